@@ -0,0 +1,131 @@
+#include "data/featureColumns.h"
+#include "data/formats/geoJson.h"
+#include "util/json.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Reads a generated GeoJSON FeatureCollection of about 100 MB into FeatureColumns.
+//
+// range_x: 0 to parse a rapidjson DOM first and read it with GeoJson::getLayer,
+// 1 to stream it with GeoJson::parse.
+//
+// The label shows the peak heap memory of an iteration, the input is not counted.
+
+#define INPUT_SIZE (100 * 1024 * 1024)
+
+// Track the heap memory in use, each allocation is prefixed with its size
+static std::atomic<size_t> s_heapSize(0);
+static std::atomic<size_t> s_heapPeak(0);
+
+static const size_t headerSize = alignof(std::max_align_t);
+
+void* operator new(size_t _size) {
+    auto* p = static_cast<char*>(std::malloc(_size + headerSize));
+    if (!p) { throw std::bad_alloc(); }
+    *reinterpret_cast<size_t*>(p) = _size;
+
+    size_t size = s_heapSize += _size;
+    size_t peak = s_heapPeak;
+    while (size > peak && !s_heapPeak.compare_exchange_weak(peak, size)) {}
+
+    return p + headerSize;
+}
+
+void operator delete(void* _p) noexcept {
+    if (!_p) { return; }
+    auto* p = static_cast<char*>(_p) - headerSize;
+    s_heapSize -= *reinterpret_cast<size_t*>(p);
+    std::free(p);
+}
+
+static const std::string& input() {
+    static std::string json;
+    if (!json.empty()) { return json; }
+
+    static const char* kinds[] = { "bus", "tram", "ferry", "train" };
+
+    json.reserve(INPUT_SIZE + 4096);
+    json += R"({"type":"FeatureCollection","features":[)";
+
+    for (int f = 0; json.size() < INPUT_SIZE; f++) {
+        if (f > 0) { json += ','; }
+        json += R"({"type":"Feature","properties":{"id":)" + std::to_string(f);
+        json += R"(,"kind":")" + std::string(kinds[f % 4]) + R"(","name":"vehicle )" + std::to_string(f);
+        json += R"("},"geometry":{"type":"LineString","coordinates":[)";
+        for (int p = 0; p < 32; p++) {
+            if (p > 0) { json += ','; }
+            json += '[' + std::to_string(-74.0 + (f % 1000) * 0.001 + p * 0.0001) + ',' +
+                std::to_string(40.7 + (f / 1000) * 0.001 + p * 0.0001) + ']';
+        }
+        json += "]}}";
+    }
+    json += "]}";
+    return json;
+}
+
+static Point project(glm::dvec2 _lonLat) {
+    return { _lonLat.x, _lonLat.y, 0 };
+}
+
+class BenchSink : public GeoJson::FeatureSink {
+public:
+    size_t beginLayer(const std::string& _name) override {
+        columns = std::make_shared<FeatureColumns>(0);
+        return 0;
+    }
+    void addFeature(size_t _layer, const GeoJson::ParsedFeature& _feature) override {
+        GeoJson::addFeature(_feature, project, *columns);
+    }
+    void endLayer(size_t _layer, bool _valid) override {
+        columns->finish();
+    }
+    std::shared_ptr<FeatureColumns> columns;
+};
+
+static void BM_GeoJsonParse(benchmark::State& state) {
+    bool stream = state.range_x();
+    const std::string& json = input();
+
+    size_t peak = 0;
+    size_t numFeatures = 0;
+
+    while (state.KeepRunning()) {
+        size_t base = s_heapSize;
+        s_heapPeak = base;
+        size_t domSize = 0;
+
+        const char* error;
+        size_t offset;
+
+        if (stream) {
+            BenchSink sink;
+            GeoJson::parse(json.data(), json.size(), sink, &error, &offset);
+            numFeatures = sink.columns->size();
+        } else {
+            auto document = JsonParseBytes(json.data(), json.size(), &error, &offset);
+            // The DOM is allocated with malloc by rapidjson
+            domSize = document.GetAllocator().Capacity();
+            auto layer = GeoJson::getLayer(document, project, 0);
+            numFeatures = layer.encodedFeatures->size();
+        }
+        peak = std::max(peak, s_heapPeak - base + domSize);
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.SetItemsProcessed(state.iterations() * numFeatures);
+    state.SetLabel(std::string(stream ? "stream" : "dom") + ", peak " +
+                   std::to_string(peak / (1024 * 1024)) + " MB");
+}
+BENCHMARK(BM_GeoJsonParse)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,202 @@
+#include "data/mbtilesDataSource.h"
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tileID.h"
+#include "tile/tileTask.h"
+
+#include <SQLiteCpp/Database.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Loads the tiles of a view from a synthetic MBTiles file of about 2 GB.
+//
+// BM_MBTilesSelect reads the tiles with one SELECT per tile on one connection.
+// BM_MBTilesDataSource loads them with MBTilesDataSource, range_x is the number of readers.
+// BM_MBTilesStore caches STORE_TILES downloaded tiles in a new MBTiles file until they are written.
+//
+// The file is created as 'bench.mbtiles' on the first run and reused afterwards.
+
+#define MBTILES_PATH "bench.mbtiles"
+#define TILE_ZOOM 14
+// 256 x 256 tiles of 32 kB
+#define TILES_PER_SIDE 256
+#define TILE_SIZE (32 * 1024)
+#define VIEW_TILES_X 10
+#define VIEW_TILES_Y 6
+#define STORE_PATH "bench-cache.mbtiles"
+#define STORE_TILES 512
+
+static void createMBTiles() {
+    if (std::FILE* file = std::fopen(MBTILES_PATH, "r")) {
+        std::fclose(file);
+        return;
+    }
+
+    SQLite::Database db(MBTILES_PATH, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+    db.exec("CREATE TABLE metadata (name text, value text);"
+            "INSERT INTO metadata VALUES ('name', 'bench'), ('format', 'pbf'), ('compression', 'identity');"
+            "CREATE TABLE tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob);");
+
+    // Random tiles do not compress, so the file has about the size of the tiles
+    db.exec("WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+            std::to_string(TILES_PER_SIDE * TILES_PER_SIDE - 1) + ") "
+            "INSERT INTO tiles SELECT " + std::to_string(TILE_ZOOM) + ", i / " + std::to_string(TILES_PER_SIDE) +
+            ", i % " + std::to_string(TILES_PER_SIDE) + ", randomblob(" + std::to_string(TILE_SIZE) + ") FROM n;");
+
+    db.exec("CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row);");
+}
+
+// Tiles of a view at a random position
+static std::vector<TileID> viewTiles(std::mt19937& _random) {
+    std::uniform_int_distribution<int> x(0, TILES_PER_SIDE - VIEW_TILES_X);
+    std::uniform_int_distribution<int> y(0, TILES_PER_SIDE - VIEW_TILES_Y);
+
+    int x0 = x(_random), y0 = y(_random);
+    int y0Xyz = (1 << TILE_ZOOM) - TILES_PER_SIDE + y0;
+
+    std::vector<TileID> tiles;
+    for (int i = 0; i < VIEW_TILES_X; i++) {
+        for (int j = 0; j < VIEW_TILES_Y; j++) {
+            tiles.emplace_back(x0 + i, y0Xyz + j, TILE_ZOOM);
+        }
+    }
+    return tiles;
+}
+
+static void BM_MBTilesSelect(benchmark::State& state) {
+    createMBTiles();
+
+    SQLite::Database db(MBTILES_PATH, SQLite::OPEN_READONLY);
+    SQLite::Statement stmt(db, "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;");
+
+    std::mt19937 random(0);
+    size_t bytes = 0;
+
+    while (state.KeepRunning()) {
+        for (auto& tileId : viewTiles(random)) {
+            stmt.bind(1, tileId.z);
+            stmt.bind(2, tileId.x);
+            stmt.bind(3, (1 << tileId.z) - 1 - tileId.y);
+
+            if (stmt.executeStep()) {
+                SQLite::Column column = stmt.getColumn(0);
+                std::vector<char> data(column.getBytes());
+                std::memcpy(data.data(), column.getBlob(), data.size());
+                bytes += data.size();
+            }
+            stmt.reset();
+        }
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * VIEW_TILES_X * VIEW_TILES_Y);
+}
+BENCHMARK(BM_MBTilesSelect);
+
+static void BM_MBTilesDataSource(benchmark::State& state) {
+    createMBTiles();
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto source = std::make_shared<TileSource>("bench", nullptr);
+    MBTilesDataSource mbtiles(platform, "bench", MBTILES_PATH, "", false, false, state.range_x());
+
+    std::mutex mutex;
+    std::condition_variable loaded;
+    size_t pending = 0;
+    size_t bytes = 0;
+
+    TileTaskCb cb{[&](std::shared_ptr<TileTask> _task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bytes += static_cast<BinaryTileTask&>(*_task).rawTileData->size();
+        if (--pending == 0) { loaded.notify_one(); }
+    }};
+
+    std::mt19937 random(0);
+
+    while (state.KeepRunning()) {
+        auto tiles = viewTiles(random);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = tiles.size();
+        }
+        for (auto& tileId : tiles) {
+            mbtiles.loadTileData(std::make_shared<BinaryTileTask>(tileId, source, -1), cb);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        loaded.wait(lock, [&]{ return pending == 0; });
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * VIEW_TILES_X * VIEW_TILES_Y);
+}
+BENCHMARK(BM_MBTilesDataSource)->Arg(1)->Arg(4);
+
+// Next source that 'downloads' distinct tiles
+struct GeneratedSource : public TileSource::DataSource {
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        TileID tileId = _task->tileId();
+
+        std::mt19937 random(tileId.x * TILES_PER_SIDE + tileId.y);
+        task.rawTileData = std::make_shared<std::vector<char>>(TILE_SIZE / 8);
+        for (auto& byte : *task.rawTileData) { byte = char(random()); }
+
+        _cb.func(_task);
+        return true;
+    }
+};
+
+static void BM_MBTilesStore(benchmark::State& state) {
+    auto platform = std::make_shared<MockPlatform>();
+    auto source = std::make_shared<TileSource>("bench", nullptr);
+
+    std::mutex mutex;
+    std::condition_variable loaded;
+    size_t pending = 0;
+
+    TileTaskCb cb{[&](std::shared_ptr<TileTask> _task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) { loaded.notify_one(); }
+    }};
+
+    while (state.KeepRunning()) {
+        std::remove(STORE_PATH);
+        std::remove(STORE_PATH "-wal");
+        std::remove(STORE_PATH "-shm");
+
+        // Destroying the data source waits for the tiles to be written
+        MBTilesDataSource mbtiles(platform, "bench", STORE_PATH, "", true, false);
+        mbtiles.setNext(std::make_unique<GeneratedSource>());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = STORE_TILES;
+        }
+        for (int i = 0; i < STORE_TILES; i++) {
+            TileID tileId(i % TILES_PER_SIDE, i / TILES_PER_SIDE, TILE_ZOOM);
+            mbtiles.loadTileData(std::make_shared<BinaryTileTask>(tileId, source, -1), cb);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        loaded.wait(lock, [&]{ return pending == 0; });
+    }
+
+    state.SetItemsProcessed(state.iterations() * STORE_TILES);
+}
+BENCHMARK(BM_MBTilesStore);
+
+BENCHMARK_MAIN();
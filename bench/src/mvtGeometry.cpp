@@ -0,0 +1,118 @@
+#include "data/formats/mvt.h"
+#include "log.h"
+#include "mockPlatform.h"
+#include "util/varint.h"
+
+#include <vector>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Decodes the feature geometries of tile.mvt
+//
+// VarintDecode range_x: 0 to read the varints one by one with protobuf::message,
+// 1 to decode them with decodeVarints().
+// MvtGeometry decodes, zigzag-decodes and normalizes the coordinates.
+
+#define LAYER_FEATURE 2
+#define LAYER_TILE_EXTENT 5
+#define FEATURE_GEOM 4
+
+struct GeometryContext {
+
+    std::vector<char> rawTileData;
+    std::vector<protobuf::message> geometries;
+    int tileExtent = 4096;
+    size_t numBytes = 0;
+
+    bool load(const char* path) {
+        rawTileData = MockPlatform::getBytesFromFile(path);
+        if (rawTileData.empty()) {
+            LOGE("Could not load %s", path);
+            return false;
+        }
+
+        protobuf::message item(rawTileData.data(), rawTileData.size());
+
+        while (item.next()) {
+            if (item.tag != 3) { item.skip(); continue; }
+
+            protobuf::message layer = item.getMessage();
+            while (layer.next()) {
+                if (layer.tag == LAYER_TILE_EXTENT) {
+                    tileExtent = static_cast<int>(layer.int64());
+                } else if (layer.tag == LAYER_FEATURE) {
+                    protobuf::message feature = layer.getMessage();
+                    while (feature.next()) {
+                        if (feature.tag == FEATURE_GEOM) {
+                            geometries.push_back(feature.getMessage());
+                            numBytes += geometries.back().getEnd() - geometries.back().getData();
+                        } else {
+                            feature.skip();
+                        }
+                    }
+                } else {
+                    layer.skip();
+                }
+            }
+        }
+        return true;
+    }
+};
+
+static void BM_VarintDecode(benchmark::State& state) {
+    bool bulk = state.range_x();
+
+    GeometryContext ctx;
+    if (!ctx.load("tile.mvt")) { return; }
+
+    std::vector<uint32_t> values(ctx.numBytes + VARINT_DECODE_PADDING);
+    volatile uint32_t sum = 0;
+
+    while (state.KeepRunning()) {
+        uint32_t s = 0;
+        for (auto geometry : ctx.geometries) {
+            if (bulk) {
+                size_t n = decodeVarints(geometry.getData(), geometry.getEnd(), values.data());
+                for (size_t i = 0; i < n; i++) { s += values[i]; }
+            } else {
+                while (geometry.getData() < geometry.getEnd()) {
+                    s += static_cast<uint32_t>(geometry.varint());
+                }
+            }
+        }
+        sum += s;
+    }
+    state.SetBytesProcessed(state.iterations() * ctx.numBytes);
+    state.SetLabel(bulk ? "bulk" : "scalar");
+}
+BENCHMARK(BM_VarintDecode)->Arg(0)->Arg(1);
+
+static void BM_MvtGeometry(benchmark::State& state) {
+
+    GeometryContext ctx;
+    if (!ctx.load("tile.mvt")) { return; }
+
+    Mvt::ParserContext parserContext(0);
+    parserContext.tileExtent = ctx.tileExtent;
+
+    size_t numPoints = 0;
+    volatile float sum = 0;
+
+    while (state.KeepRunning()) {
+        numPoints = 0;
+        float s = 0;
+        for (auto& geometry : ctx.geometries) {
+            auto decoded = Mvt::getGeometry(parserContext, geometry);
+            numPoints += decoded.coordinates.size();
+            if (!decoded.coordinates.empty()) { s += decoded.coordinates.back().x; }
+        }
+        sum += s;
+    }
+    state.SetItemsProcessed(state.iterations() * numPoints);
+}
+BENCHMARK(BM_MvtGeometry);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,242 @@
+#include "tile/tileCachePolicy.h"
+#include "tile/tileID.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Replays camera paths over a simulated tile cache and reports the hit rate
+// and the build time spent on cache misses for each replacement policy.
+//
+// A recorded path can be given in 'camera_path.txt': one frame per line as
+// 'x y zoom', with x and y normalized to [0, 1] over the mercator plane.
+
+#define CACHE_SIZE (16*1024*1024)
+#define VIEW_TILES_X 4
+#define VIEW_TILES_Y 3
+
+struct Frame {
+    double x, y;
+    float zoom;
+};
+
+using CameraPath = std::vector<Frame>;
+
+static CameraPath panPath() {
+    // Fling back and forth along a street
+    CameraPath path;
+    for (int pass = 0; pass < 6; pass++) {
+        for (int i = 0; i < 300; i++) {
+            double t = (pass % 2 == 0) ? i / 300.0 : 1.0 - i / 300.0;
+            path.push_back({ 0.5241 + t * 0.0004, 0.3406, 15.5f });
+        }
+    }
+    return path;
+}
+
+static CameraPath zoomPath() {
+    // Zoom in and out over a city center
+    CameraPath path;
+    for (int pass = 0; pass < 6; pass++) {
+        for (int i = 0; i < 200; i++) {
+            double t = (pass % 2 == 0) ? i / 200.0 : 1.0 - i / 200.0;
+            path.push_back({ 0.5241, 0.3406, float(11.0 + t * 6.0) });
+        }
+    }
+    return path;
+}
+
+static CameraPath explorePath() {
+    // Pan between points of interest, zooming out in between
+    const Frame stops[] = {
+        { 0.5241, 0.3406, 16.f }, { 0.5246, 0.3409, 16.f },
+        { 0.5238, 0.3402, 15.f }, { 0.5241, 0.3406, 16.f },
+        { 0.5250, 0.3411, 14.f }, { 0.5241, 0.3406, 16.f },
+    };
+    CameraPath path;
+    for (int round = 0; round < 3; round++) {
+        for (size_t s = 0; s + 1 < sizeof(stops) / sizeof(stops[0]); s++) {
+            auto& a = stops[s];
+            auto& b = stops[s + 1];
+            for (int i = 0; i < 120; i++) {
+                float t = i / 120.f;
+                float dip = std::sin(t * M_PI) * 2.f;
+                path.push_back({ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+                                 a.zoom + (b.zoom - a.zoom) * t - dip });
+            }
+        }
+    }
+    return path;
+}
+
+static CameraPath recordedPath() {
+    CameraPath path;
+    std::ifstream file("camera_path.txt");
+    Frame frame;
+    while (file >> frame.x >> frame.y >> frame.zoom) {
+        path.push_back(frame);
+    }
+    return path;
+}
+
+static const char* pathNames[] = { "pan", "zoom", "explore", "recorded" };
+
+static CameraPath cameraPath(int _index) {
+    switch (_index) {
+    case 0: return panPath();
+    case 1: return zoomPath();
+    case 2: return explorePath();
+    default: return recordedPath();
+    }
+}
+
+static uint32_t tileHash(const TileID& _id) {
+    uint32_t h = _id.x * 73856093u ^ _id.y * 19349663u ^ _id.z * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return h ^ (h >> 15);
+}
+
+// Dense tiles near the city center are large and slow to build,
+// a few outlying tiles are dense too.
+static void tileCost(const TileID& _id, size_t& _usage, float& _buildTime) {
+    double scale = 1.0 / (1 << _id.z);
+    double dx = (_id.x + 0.5) * scale - 0.5241;
+    double dy = (_id.y + 0.5) * scale - 0.3406;
+    double density = std::exp(-std::sqrt(dx * dx + dy * dy) / 0.0008);
+
+    uint32_t h = tileHash(_id);
+    float noise = (h % 1000) / 1000.f;
+
+    if (h % 7 == 0) { density = std::fmax(density, 0.8); }
+
+    _usage = size_t(20 * 1024 + density * 600 * 1024 * (0.5 + noise));
+    _buildTime = float(0.5 + density * 40.0 * (0.3 + noise));
+}
+
+static std::set<TileID> visibleTiles(const Frame& _frame) {
+    std::set<TileID> tiles;
+    int z = std::floor(_frame.zoom);
+    int n = 1 << z;
+    int cx = _frame.x * n;
+    int cy = _frame.y * n;
+    for (int x = cx - VIEW_TILES_X / 2; x <= cx + VIEW_TILES_X / 2; x++) {
+        for (int y = cy - VIEW_TILES_Y / 2; y <= cy + VIEW_TILES_Y / 2; y++) {
+            if (x >= 0 && x < n && y >= 0 && y < n) { tiles.insert(TileID(x, y, z)); }
+        }
+    }
+    return tiles;
+}
+
+struct CacheSimulation {
+
+    std::unique_ptr<TileCachePolicy> policy;
+    std::unordered_map<TileCacheKey, size_t> cached;
+    size_t usage = 0;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    double missTime = 0;
+
+    void run(const CameraPath& _path) {
+        std::set<TileID> current;
+
+        for (auto& frame : _path) {
+            policy->setZoom(frame.zoom);
+
+            auto next = visibleTiles(frame);
+
+            for (auto& id : current) {
+                if (!next.count(id)) { put(id); }
+            }
+            for (auto& id : next) {
+                if (!current.count(id)) { get(id); }
+            }
+            current = std::move(next);
+        }
+    }
+
+    void put(const TileID& _id) {
+        size_t tileUsage;
+        float buildTime;
+        tileCost(_id, tileUsage, buildTime);
+
+        TileCacheKey key(0, _id);
+        policy->insert(key, tileUsage, buildTime);
+        cached[key] = tileUsage;
+        usage += tileUsage;
+
+        while (usage > CACHE_SIZE) {
+            auto it = cached.find(policy->evict());
+            usage -= it->second;
+            cached.erase(it);
+        }
+    }
+
+    void get(const TileID& _id) {
+        TileCacheKey key(0, _id);
+        auto it = cached.find(key);
+        if (it != cached.end()) {
+            hits++;
+            usage -= it->second;
+            cached.erase(it);
+            policy->remove(key);
+            return;
+        }
+        size_t tileUsage;
+        float buildTime;
+        tileCost(_id, tileUsage, buildTime);
+        misses++;
+        missTime += buildTime;
+    }
+};
+
+static void BM_Tangram_TileCachePolicy(benchmark::State& state) {
+
+    // range_x: policy, range_y: camera path
+    auto path = cameraPath(state.range_y());
+
+    CacheSimulation result;
+
+    while (state.KeepRunning()) {
+        CacheSimulation sim;
+        if (state.range_x() == 0) {
+            sim.policy = std::make_unique<LRUTileCachePolicy>();
+        } else {
+            sim.policy = std::make_unique<GreedyDualSizeTileCachePolicy>();
+        }
+        sim.run(path);
+        result = std::move(sim);
+    }
+
+    char label[128];
+    if (path.empty()) {
+        state.SetLabel("no camera_path.txt");
+        return;
+    }
+    snprintf(label, sizeof(label), "%s %s: hit rate %.1f%%, miss build time %.0fms",
+             state.range_x() == 0 ? "LRU" : "GreedyDual-Size", pathNames[state.range_y()],
+             100.0 * result.hits / std::max(size_t(1), result.hits + result.misses),
+             result.missTime);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(state.iterations() * path.size());
+}
+BENCHMARK(BM_Tangram_TileCachePolicy)
+    ->ArgPair(0, 0)->ArgPair(1, 0)
+    ->ArgPair(0, 1)->ArgPair(1, 1)
+    ->ArgPair(0, 2)->ArgPair(1, 2)
+    ->ArgPair(0, 3)->ArgPair(1, 3);
+
+BENCHMARK_MAIN();
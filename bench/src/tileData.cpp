@@ -0,0 +1,159 @@
+#include "data/featureColumns.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "data/tileDataCache.h"
+#include "util/arena.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Compares the layout of TileData: one Feature per feature with a vector per
+// line or ring, against FeatureColumns with all coordinates in one array.
+//
+// range_x: 0 for Features, 1 for FeatureColumns
+// range_y: number of points per ring
+//
+// Each tile has NUM_FEATURES polygons with an outer ring and a hole.
+
+#define NUM_FEATURES 2000
+
+static const char* layoutName(int _layout) {
+    return _layout == 0 ? "features" : "columns";
+}
+
+static Point ringPoint(int _feature, int _ring, int _point, int _numPoints) {
+    float angle = 2 * M_PI * _point / _numPoints;
+    float radius = _ring == 0 ? 0.01f : 0.005f;
+    return { (_feature % 64) / 64.f + radius * std::cos(angle),
+             (_feature / 64) / 64.f + radius * std::sin(angle), 0 };
+}
+
+static std::shared_ptr<TileData> createTileData(int _layout, int _numPoints) {
+
+    static const char* kinds[] = { "building", "park", "water", "forest" };
+
+    auto tileData = std::make_shared<TileData>();
+    tileData->layers.emplace_back("layer");
+    auto& layer = tileData->layers.back();
+
+    if (_layout == 0) {
+        layer.features.reserve(NUM_FEATURES);
+
+        for (int f = 0; f < NUM_FEATURES; f++) {
+            Feature feature(0);
+            feature.geometryType = GeometryType::polygons;
+            feature.props.set("kind", kinds[f % 4]);
+            feature.props.set("height", double(f % 10));
+            feature.props.set("name", "feature " + std::to_string(f));
+
+            feature.polygons.emplace_back();
+            for (int r = 0; r < 2; r++) {
+                Line ring;
+                for (int p = 0; p < _numPoints; p++) {
+                    ring.push_back(ringPoint(f, r, p, _numPoints));
+                }
+                feature.polygons.back().push_back(std::move(ring));
+            }
+            layer.features.push_back(std::move(feature));
+        }
+    } else {
+        auto columns = std::make_shared<FeatureColumns>(0);
+
+        for (int f = 0; f < NUM_FEATURES; f++) {
+            columns->beginFeature(GeometryType::polygons);
+            columns->addProperty("kind", std::string(kinds[f % 4]));
+            columns->addProperty("height", double(f % 10));
+            columns->addProperty("name", "feature " + std::to_string(f));
+
+            for (int r = 0; r < 2; r++) {
+                for (int p = 0; p < _numPoints; p++) {
+                    columns->addCoordinate(ringPoint(f, r, p, _numPoints));
+                }
+                columns->endRing(r == 0);
+            }
+            columns->endFeature();
+        }
+        columns->finish();
+        layer.encodedFeatures = columns;
+    }
+
+    return tileData;
+}
+
+// Touch properties and coordinates like a StyleBuilder would
+static float styleFeature(const Feature& _feature) {
+    float sum = _feature.props.getNumber("height");
+    for (auto& polygon : _feature.polygons) {
+        for (auto& ring : polygon) {
+            for (auto& point : ring) { sum += point.x - point.y; }
+        }
+    }
+    return sum;
+}
+
+static void BM_Tangram_TileDataCreate(benchmark::State& state) {
+
+    int layout = state.range_x();
+    int numPoints = state.range_y();
+
+    size_t usage = 0;
+
+    while (state.KeepRunning()) {
+        auto tileData = createTileData(layout, numPoints);
+
+        state.PauseTiming();
+        usage = TileDataCache::memoryUsage(*tileData);
+        tileData.reset();
+        state.ResumeTiming();
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s, %zu kB", layoutName(layout), usage / 1024);
+    state.SetLabel(label);
+    state.SetItemsProcessed(state.iterations() * NUM_FEATURES);
+}
+BENCHMARK(BM_Tangram_TileDataCreate)
+    ->ArgPair(0, 8)->ArgPair(1, 8)->ArgPair(0, 64)->ArgPair(1, 64);
+
+static void BM_Tangram_TileDataIterate(benchmark::State& state) {
+
+    int layout = state.range_x();
+    int numPoints = state.range_y();
+
+    auto tileData = createTileData(layout, numPoints);
+    auto& layer = tileData->layers.back();
+
+    // Reused like the decoded features of TileBuilder
+    Feature decoded;
+    Arena arena;
+    volatile float sum = 0;
+
+    while (state.KeepRunning()) {
+        for (auto& feature : layer.features) {
+            sum += styleFeature(feature);
+        }
+        if (layer.encodedFeatures) {
+            auto& features = *layer.encodedFeatures;
+            for (size_t i = 0; i < features.size(); i++) {
+                features.decodeProperties(i, decoded, arena);
+                features.decodeGeometry(i, decoded, arena);
+                sum += styleFeature(decoded);
+            }
+        }
+    }
+
+    state.SetLabel(layoutName(layout));
+    state.SetItemsProcessed(state.iterations() * NUM_FEATURES);
+}
+BENCHMARK(BM_Tangram_TileDataIterate)
+    ->ArgPair(0, 8)->ArgPair(1, 8)->ArgPair(0, 64)->ArgPair(1, 64);
+
+BENCHMARK_MAIN();
@@ -1,3 +1,4 @@
+#include "data/formats/mvt.h"
 #include "data/tileSource.h"
 #include "gl.h"
 #include "log.h"
@@ -72,13 +73,17 @@ struct TestContext {
 
     }
 
-    void parseTile() {
+    std::shared_ptr<TileTask> createTask() {
         Tile tile({0,0,10,10,0}, s_projection);
         source = *scene->tileSources().begin();
         auto task = source->createTask(tile.getID());
         auto& t = dynamic_cast<BinaryTileTask&>(*task);
         t.rawTileData = std::make_shared<std::vector<char>>(rawTileData);
+        return task;
+    }
 
+    void parseTile() {
+        auto task = createTask();
         tileData = source->parse(*task, s_projection);
     }
 };
@@ -113,6 +118,37 @@ BENCHMARK_DEFINE_F(TileLoadingFixture, BuildTest)(benchmark::State& st) {
 
 BENCHMARK_REGISTER_F(TileLoadingFixture, BuildTest);
 
+BENCHMARK_DEFINE_F(TileLoadingFixture, BuildConcurrentTest)(benchmark::State& st) {
+    // range_x: number of threads building one tile
+    ctx.tileBuilder->setConcurrency(st.range_x());
+
+    ctx.parseTile();
+    if (!ctx.tileData) { return; }
+
+    while (st.KeepRunning()) {
+        result = ctx.tileBuilder->build({0,0,10,10,0}, *ctx.tileData, *ctx.source);
+    }
+}
+
+BENCHMARK_REGISTER_F(TileLoadingFixture, BuildConcurrentTest)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+BENCHMARK_DEFINE_F(TileLoadingFixture, DecodeTest)(benchmark::State& st) {
+    // range_x: 0 to decode all features when parsing, 1 to decode them while building
+    bool lazy = st.range_x();
+
+    auto task = ctx.createTask();
+
+    while (st.KeepRunning()) {
+        auto tileData = Mvt::parseTile(*task, ctx.s_projection, ctx.source->id(), lazy);
+        if (!tileData) { break; }
+
+        result = ctx.tileBuilder->build({0,0,10,10,0}, *tileData, *ctx.source);
+    }
+    st.SetLabel(lazy ? "lazy" : "eager");
+}
+
+BENCHMARK_REGISTER_F(TileLoadingFixture, DecodeTest)->Arg(0)->Arg(1);
+
 
 
 BENCHMARK_MAIN();
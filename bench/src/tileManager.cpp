@@ -0,0 +1,111 @@
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tile.h"
+#include "tile/tileManager.h"
+#include "tile/tileTask.h"
+#include "view/view.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// Measures TileManager::updateTileSets() with range_y() TileSources while
+// the view pans back and forth over loaded tiles. The view size is chosen
+// to show about range_x() tiles per TileSource.
+
+#define PAN_FRAMES 64
+
+struct BenchTileSource : TileSource {
+
+    BenchTileSource(const std::string& _name) : TileSource(_name, nullptr) {
+        m_generateGeometry = true;
+    }
+
+    void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        _task->startedLoading();
+        _cb.func(std::move(_task));
+    }
+
+    void cancelLoadingTile(const TileID& _tile) override {}
+
+    void clearData() override {}
+
+    std::shared_ptr<TileTask> createTask(TileID _tileId, int _subTask) override {
+        return std::make_shared<TileTask>(_tileId, shared_from_this(), _subTask);
+    }
+};
+
+// Builds empty tiles right away
+struct BenchTileWorker : TileTaskQueue {
+
+    MercatorProjection projection;
+
+    void enqueue(std::shared_ptr<TileTask> task) override {
+        task->tile() = std::make_shared<Tile>(task->tileId(), projection, &task->source());
+    }
+};
+
+static void BM_Tangram_UpdateTileSets(benchmark::State& state) {
+
+    int numTiles = state.range_x();
+    int numSources = state.range_y();
+
+    BenchTileWorker worker;
+    TileManager tileManager(std::make_shared<MockPlatform>(), worker);
+
+    std::vector<std::shared_ptr<TileSource>> sources;
+    for (int i = 0; i < numSources; i++) {
+        sources.push_back(std::make_shared<BenchTileSource>("source" + std::to_string(i)));
+    }
+    tileManager.setTileSources(sources);
+
+    int size = int(std::sqrt(numTiles)) * 256;
+    View view(size, size);
+    view.setZoom(15);
+
+    auto center = view.getPosition();
+    double tileSize = view.getMapProjection().TileBounds(TileID(0, 0, 15)).width();
+
+    // Pan by a quarter tile per frame
+    auto pan = [&](int frame) {
+        int step = frame % (2 * PAN_FRAMES);
+        if (step >= PAN_FRAMES) { step = 2 * PAN_FRAMES - step; }
+        view.setPosition(center.x + step * tileSize / 4, center.y);
+        view.update();
+    };
+
+    // Load the tiles of the panned area
+    for (int frame = 0; frame < 2 * PAN_FRAMES; frame++) {
+        pan(frame);
+        tileManager.updateTileSets(view);
+        tileManager.updateTileSets(view);
+    }
+
+    size_t visibleTiles = 0;
+    int frame = 0;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        pan(frame++);
+        state.ResumeTiming();
+
+        tileManager.updateTileSets(view);
+        visibleTiles += tileManager.getVisibleTiles().size();
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%.0f tiles", double(visibleTiles) / frame);
+    state.SetLabel(label);
+    state.SetItemsProcessed(visibleTiles);
+}
+BENCHMARK(BM_Tangram_UpdateTileSets)
+    ->ArgPair(16, 1)->ArgPair(64, 1)->ArgPair(256, 1)
+    ->ArgPair(16, 4)->ArgPair(64, 4)->ArgPair(256, 4);
+
+BENCHMARK_MAIN();
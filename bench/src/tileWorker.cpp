@@ -0,0 +1,82 @@
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "tile/tileTask.h"
+#include "tile/tileWorker.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+#define NUM_TASKS 512
+#define DECODE_WORK_US 20
+#define BUILD_WORK_US 30
+
+static void spin(int _us) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(_us);
+    while (std::chrono::steady_clock::now() < end) {}
+}
+
+struct BenchTileTask : TileTask {
+
+    std::atomic<int>& processed;
+
+    BenchTileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, std::atomic<int>& _processed)
+        : TileTask(_tileId, _source, -1), processed(_processed) {}
+
+    // Simulate tile decoding and building of fixed cost
+    void decode(const MapProjection& _projection) override {
+        spin(DECODE_WORK_US);
+        m_tileData = std::make_shared<TileData>();
+    }
+
+    void build(TileBuilder& _tileBuilder) override {
+        spin(BUILD_WORK_US);
+        processed++;
+    }
+};
+
+static void BM_Tangram_TileWorkerThroughput(benchmark::State& state) {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("bench", nullptr);
+
+    // range_x: building threads, range_y: decoding threads
+    TileWorker worker(platform, state.range_x(), state.range_y());
+    worker.setScene(scene);
+
+    std::atomic<int> processed{0};
+
+    while (state.KeepRunning()) {
+        processed = 0;
+
+        for (int i = 0; i < NUM_TASKS; i++) {
+            TileID tileId(i % 64, i / 64, 10);
+            auto task = std::make_shared<BenchTileTask>(tileId, source, processed);
+            task->setPriority((i * 7919) % NUM_TASKS);
+            worker.enqueue(std::move(task));
+        }
+
+        while (processed < NUM_TASKS) {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUM_TASKS);
+
+    worker.stop();
+}
+BENCHMARK(BM_Tangram_TileWorkerThroughput)
+    ->ArgPair(1, 0)->ArgPair(2, 0)->ArgPair(4, 0)->ArgPair(8, 0)->ArgPair(16, 0)
+    ->ArgPair(1, 1)->ArgPair(2, 1)->ArgPair(2, 2)->ArgPair(4, 2)->ArgPair(8, 4)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+#include "mockHttpServer.h"
+#include "urlClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "benchmark/benchmark_api.h"
+#include "benchmark/benchmark.h"
+
+using namespace Tangram;
+
+// BM_UrlClient loads the tiles of a view from a local HTTP server that answers
+// after SERVER_DELAY ms. range_x is maxActiveTasks of the UrlClient. The label
+// shows the mean latency of a request from addRequest() to its callback.
+//
+// BM_UrlClientPan requests the tiles of a view and PAN_DELAY ms later those of
+// the next view, from a server sending PAN_RATE bytes per second and connection.
+// range_x: 0 to add requests without priority, 1 to make the tiles of the first
+// view background requests when the second is requested. The label shows when
+// the tiles of the second view were loaded.
+
+#define SERVER_DELAY 20
+#define TILE_SIZE (32 * 1024)
+#define VIEW_TILES 60
+#define PAN_TILES 16
+#define PAN_TILE_SIZE (16 * 1024)
+#define PAN_RATE (160 * 1024)
+#define PAN_DELAY 20
+
+static void BM_UrlClient(benchmark::State& state) {
+    MockHttpServer server({ SERVER_DELAY, TILE_SIZE });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = state.range_x();
+    options.maxConnectionsPerHost = state.range_x();
+    UrlClient client(options);
+
+    using clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable loaded;
+    size_t pending = 0;
+    size_t bytes = 0;
+    clock::duration latency{};
+
+    int tile = 0;
+
+    while (state.KeepRunning()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = VIEW_TILES;
+        }
+        for (int i = 0; i < VIEW_TILES; i++) {
+            auto start = clock::now();
+            client.addRequest(server.url() + "/tile/" + std::to_string(tile++), [&, start](UrlResponse _response) {
+                std::lock_guard<std::mutex> lock(mutex);
+                latency += clock::now() - start;
+                bytes += _response.content.size();
+                if (--pending == 0) { loaded.notify_one(); }
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        loaded.wait(lock, [&]{ return pending == 0; });
+    }
+
+    size_t requests = state.iterations() * VIEW_TILES;
+    auto meanLatency = std::chrono::duration_cast<std::chrono::microseconds>(latency).count() / requests;
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(requests);
+    state.SetLabel("latency " + std::to_string(meanLatency / 1000.0) + " ms, " +
+                   std::to_string(server.connections()) + " connections");
+}
+BENCHMARK(BM_UrlClient)->Arg(4)->Arg(8)->Arg(32)->Arg(64);
+
+static void BM_UrlClientPan(benchmark::State& state) {
+    MockHttpServer server({ 0, PAN_TILE_SIZE, PAN_RATE });
+
+    bool prioritized = state.range_x();
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 4;
+    UrlClient client(options);
+
+    using clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable loaded;
+    size_t pending = 0;
+    size_t visiblePending = 0;
+    clock::duration visibleTime{};
+
+    int tile = 0;
+
+    while (state.KeepRunning()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = 2 * PAN_TILES;
+            visiblePending = PAN_TILES;
+        }
+        auto start = clock::now();
+        auto panned = std::make_shared<std::atomic<bool>>(false);
+
+        auto addView = [&](bool _visible) {
+            for (int i = 0; i < PAN_TILES; i++) {
+                UrlPriorityCallback priority;
+                if (prioritized) {
+                    priority = [=]() {
+                        return UrlRequestPriority{ !_visible && *panned, double(i) };
+                    };
+                }
+                client.addRequest(server.url() + "/tile/" + std::to_string(tile++), [&, _visible](UrlResponse) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (_visible && --visiblePending == 0) { visibleTime += clock::now() - start; }
+                    if (--pending == 0) { loaded.notify_one(); }
+                }, priority);
+            }
+        };
+
+        addView(false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(PAN_DELAY));
+        *panned = true;
+        addView(true);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        loaded.wait(lock, [&]{ return pending == 0; });
+    }
+
+    auto visibleMs = std::chrono::duration_cast<std::chrono::milliseconds>(visibleTime).count() / state.iterations();
+
+    state.SetItemsProcessed(state.iterations() * 2 * PAN_TILES);
+    state.SetLabel(std::string(prioritized ? "prioritized" : "fifo") + ", view loaded after " +
+                   std::to_string(visibleMs) + " ms");
+}
+BENCHMARK(BM_UrlClientPan)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -1,23 +1,55 @@
 #pragma once
 
+#include "data/tileData.h"
 #include "data/tileSource.h"
 #include "util/types.h"
+#include "util/variant.h"
 
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 
 namespace Tangram {
 
+class AsyncWorker;
 class Platform;
 
+struct BoundingBox;
 struct Properties;
 
 struct ClientGeoJsonData;
-
+struct ClientGeoJsonIndex;
+
+/*
+ * Source of features added by the client.
+ *
+ * Updates are applied to the features right away. The geojson-vt index that tiles
+ * are built from is rebuilt in the background and swapped in when done, tiles that
+ * are loaded meanwhile use the previous index. Updates show up once a new index is
+ * in place, then the generation is incremented for the tiles that changed.
+ */
 class ClientGeoJsonSource : public TileSource {
 
 public:
 
+    /* Features of one geometry type for addFeatures(), as columns.
+     *
+     * Points have one coordinate per feature. Lines are ranges of @coordinates that
+     * end at @lineEnds, one per feature. Polygons have rings that end at @lineEnds
+     * and are ranges of rings that end at @polygonEnds, one per feature.
+     * Property @keys[k] of feature i is @values[i * keys.size() + k], none_type
+     * values are skipped. */
+    struct FeatureBatch {
+        GeometryType geometryType = GeometryType::points;
+        std::vector<LngLat> coordinates;
+        std::vector<uint32_t> lineEnds;
+        std::vector<uint32_t> polygonEnds;
+        std::vector<std::string> keys;
+        std::vector<Value> values;
+    };
+
     ClientGeoJsonSource(std::shared_ptr<Platform> _platform, const std::string& _name,
             const std::string& _url, bool generateCentroids = false,
             TileSource::ZoomOptions _zoomOptions = {});
@@ -28,10 +60,28 @@ public:
 
     // Add geometry from a GeoJSON string
     void addData(const std::string& _data);
-    void addPoint(const Properties& _tags, LngLat _point);
-    void addLine(const Properties& _tags, const Coordinates& _line);
-    void addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly);
-    void generateLabelCentroidFeature();
+
+    // Add a feature, returns its id which stays valid until the feature is removed
+    uint64_t addPoint(const Properties& _tags, LngLat _point);
+    uint64_t addLine(const Properties& _tags, const Coordinates& _line);
+    uint64_t addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly);
+
+    // Replace properties and geometry of feature @_id, returns false when there is no such feature.
+    // Only tiles that intersect the old or new geometry are rebuilt.
+    bool updatePoint(uint64_t _id, const Properties& _tags, LngLat _point);
+    bool updateLine(uint64_t _id, const Properties& _tags, const Coordinates& _line);
+    bool updatePoly(uint64_t _id, const Properties& _tags, const std::vector<Coordinates>& _poly);
+
+    // Returns false when there is no feature @_id
+    bool removeFeature(uint64_t _id);
+
+    // Add the features of @_batch, returns the id of the first one, the others have consecutive ids
+    uint64_t addFeatures(FeatureBatch _batch);
+
+    // Block until the index includes all updates made before this call
+    void waitForIndex();
+
+    int64_t tileGeneration(const TileID& _tileId) const override;
 
     virtual void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
     std::shared_ptr<TileTask> createTask(TileID _tileId, int _subTask) override;
@@ -44,14 +94,38 @@ protected:
     virtual std::shared_ptr<TileData> parse(const TileTask& _task,
                                             const MapProjection& _projection) const override;
 
+    // Queue an index build for a change of the features within @_bounds. Call with m_mutexStore held.
+    void updateIndex(const BoundingBox& _bounds);
+
+    // Build the index from the current features and swap it in, runs on m_worker
+    void buildIndex();
+
+    // Increment the generation for a change within @_bounds, in longitude and latitude
+    void addChange(const BoundingBox& _bounds);
+
+    // Increment the generation for a change of all tiles
+    void addFullChange();
+
     std::unique_ptr<ClientGeoJsonData> m_store;
 
+    // Guards m_store, it is only held while features change or an index build copies them
     mutable std::mutex m_mutexStore;
+
+    // The index that tiles are built from, m_mutexIndex guards replacing it
+    std::shared_ptr<ClientGeoJsonIndex> m_index;
+    mutable std::mutex m_mutexIndex;
+
+    // Guards the changes in m_store, which tileGeneration() reads without waiting for m_mutexStore
+    mutable std::mutex m_mutexChanges;
+
     bool m_hasPendingData = false;
     bool m_generateCentroids = false;
 
     std::shared_ptr<Platform> m_platform;
 
+    // Builds the index, destroyed first to finish a running build
+    std::unique_ptr<AsyncWorker> m_worker;
+
 };
 
 }
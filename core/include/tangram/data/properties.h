@@ -5,6 +5,7 @@
 
 namespace Tangram {
 
+class PropertyKey;
 class Value;
 struct PropertyItem;
 
@@ -25,12 +26,21 @@ struct Properties {
 
     const Value& get(const std::string& key) const;
 
+    // Compares interned keys instead of strings, see <PropertyKey>
+    const Value& get(const PropertyKey& key) const;
+
+    const Value& get(const char* key) const { return get(std::string(key)); }
+
     void sort();
 
     void clear();
 
     bool contains(const std::string& key) const;
 
+    bool contains(const PropertyKey& key) const;
+
+    bool contains(const char* key) const { return contains(std::string(key)); }
+
     bool getNumber(const std::string& key, double& value) const;
 
     double getNumber(const std::string& key) const;
@@ -52,6 +62,9 @@ struct Properties {
 
     void setSorted(std::vector<Item>&& _items);
 
+    // Move the items out, to reuse their storage for setSorted()
+    std::vector<Item> takeItems();
+
     // template <typename... Args> void set(std::string key, Args&&... args) {
     //     props.emplace_back(std::move(key), Value{std::forward<Args>(args)...});
     //     sort();
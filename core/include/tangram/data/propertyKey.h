@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+namespace Tangram {
+
+/*
+ * An interned property key.
+ *
+ * Keys with the same name refer to one entry of a global table, so that
+ * comparing keys is an integer compare of their entries. Keys are interned
+ * when data is parsed and when a scene is loaded. Entries are never removed,
+ * the table holds the distinct key names of all data sources and scenes.
+ */
+class PropertyKey {
+
+public:
+
+    // The empty key
+    PropertyKey();
+
+    PropertyKey(const std::string& _key);
+
+    PropertyKey(const char* _key);
+
+    const std::string& str() const { return *m_key; }
+
+    const char* c_str() const { return m_key->c_str(); }
+
+    size_t size() const { return m_key->size(); }
+
+    bool empty() const { return m_key->empty(); }
+
+    operator const std::string&() const { return *m_key; }
+
+    bool operator==(const PropertyKey& _other) const { return m_key == _other.m_key; }
+    bool operator!=(const PropertyKey& _other) const { return m_key != _other.m_key; }
+
+    bool operator==(const std::string& _other) const { return *m_key == _other; }
+    bool operator!=(const std::string& _other) const { return *m_key != _other; }
+
+    bool operator==(const char* _other) const { return *m_key == _other; }
+    bool operator!=(const char* _other) const { return *m_key != _other; }
+
+private:
+
+    const std::string* m_key;
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include "tile/tileTask.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -17,6 +18,7 @@ class Tile;
 class TileManager;
 struct RawCache;
 class Texture;
+class TileDataCache;
 
 class TileSource : public std::enable_shared_from_this<TileSource> {
 
@@ -109,8 +111,40 @@ public:
     /* Clears all data associated with this TileSource */
     virtual void clearData();
 
+    /* Add names of tile data layers (collections) that the scene uses from this source.
+     * Once collections were added other layers are not decoded, see parseStats(). */
+    void addCollections(const std::vector<std::string>& _collections);
+    const std::vector<std::string>& collections() const { return m_collections; }
+
+    struct ParseStats {
+        // Layers that were not decoded since no scene layer uses them
+        size_t skippedLayers = 0;
+        // Encoded size and number of features of the skipped layers
+        size_t skippedBytes = 0;
+        size_t skippedFeatures = 0;
+    };
+
+    ParseStats parseStats() const;
+
+    /* Cache for parsed TileData of this TileSource, may be shared with other sources */
+    void setTileDataCache(std::shared_ptr<TileDataCache> _cache) { m_tileDataCache = _cache; }
+    TileDataCache* tileDataCache() const { return m_tileDataCache.get(); }
+
+    /* Hash of the scene configuration of this source. Sources with the same name,
+     * configuration and collections share their parsed TileData in the TileDataCache,
+     * so that it is reused when the scene is reloaded. Not set for sources whose data
+     * is provided by the application. */
+    void setConfigHash(uint64_t _hash);
+
+    /* Key and generation of the parsed TileData of this source in the TileDataCache */
+    uint64_t dataKey() const { return m_dataKey; }
+    int64_t dataGeneration() const { return m_configHash ? m_dataGeneration.load() : m_generation.load(); }
+
     const std::string& name() const { return m_name; }
 
+    /* The first DataSource of the chain that loads the tiles of this source */
+    DataSource* dataSources() const { return m_sources.get(); }
+
     virtual void clearRasters();
     virtual void clearRaster(const TileID& id);
 
@@ -122,6 +156,10 @@ public:
     /* Generation ID of TileSource state (incremented for each update, e.g. on clearData()) */
     int64_t generation() const { return m_generation; }
 
+    /* Generation of the TileSource state that the tile @_tileId depends on, tiles built
+     * before it are outdated. By default every update affects all tiles. */
+    virtual int64_t tileGeneration(const TileID& _tileId) const { return m_generation; }
+
     const ZoomOptions& zoomOptions() { return m_zoomOptions; }
     int32_t minDisplayZoom() const { return m_zoomOptions.minDisplayZoom; }
     int32_t maxDisplayZoom() const { return m_zoomOptions.maxDisplayZoom; }
@@ -150,6 +188,8 @@ protected:
 
     void createSubTasks(std::shared_ptr<TileTask> _task);
 
+    void updateDataKey();
+
     // This datasource is used to generate actual tile geometry
     bool m_generateGeometry = false;
 
@@ -163,14 +203,32 @@ protected:
     int32_t m_id;
 
     // Generation of dynamic TileSource state (incremented for each update)
-    int64_t m_generation = 1;
+    std::atomic<int64_t> m_generation{1};
 
     Format m_format = Format::GeoJson;
 
+    // Scene configuration hash, 0 when not set
+    uint64_t m_configHash = 0;
+
+    // TileDataCache key, see dataKey()
+    uint64_t m_dataKey;
+
+    // Generation of the parsed TileData of a configured source (incremented on clearData())
+    std::atomic<int64_t> m_dataGeneration{1};
+
+    // Tile data layers used by the scene, all layers are used when empty
+    std::vector<std::string> m_collections;
+
+    mutable std::atomic<size_t> m_skippedLayers{0};
+    mutable std::atomic<size_t> m_skippedBytes{0};
+    mutable std::atomic<size_t> m_skippedFeatures{0};
+
     /* vector of raster sources (as raster samplers) referenced by this datasource */
     std::vector<std::shared_ptr<TileSource>> m_rasterSources;
 
     std::unique_ptr<DataSource> m_sources;
+
+    std::shared_ptr<TileDataCache> m_tileDataCache;
 };
 
 }
@@ -4,6 +4,7 @@
 #include "util/types.h"
 
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -78,6 +79,23 @@ struct SceneError {
     Error error;
 };
 
+struct TileCacheStats {
+    // Tiles that were loaded from the cache and tiles that had to be loaded from the network
+    size_t hits = 0;
+    size_t misses = 0;
+    // Bytes in use by the cache database
+    uint64_t size = 0;
+};
+
+// Policies that choose which built tiles are removed from the in-memory tile cache
+enum class TileCachePolicyType : char {
+    // Remove the least recently used tile first (default)
+    lru = 0,
+    // Remove the tile with the lowest build time per byte first, tiles far from the
+    // current zoom level count as cheaper
+    greedyDualSize,
+};
+
 using SceneID = int32_t;
 
 // Function type for a sceneReady callback
@@ -231,6 +249,15 @@ public:
 
     void clearTileSource(TileSource& _source, bool _data, bool _tiles);
 
+    // Set the maximum size in bytes of the MBTiles tile cache of the tile source named _sourceName
+    // (see the source option 'cache'), 0 for no limit. Least recently used tiles are removed when
+    // the cache grows larger. Returns false if the source has no tile cache.
+    bool setTileCacheSize(const std::string& _sourceName, uint64_t _bytes);
+
+    // Get the statistics of the MBTiles tile cache of the tile source named _sourceName;
+    // returns false if the source has no tile cache.
+    bool getTileCacheStats(const std::string& _sourceName, TileCacheStats& _stats);
+
     // Add a marker object to the map and return an ID for it; an ID of 0 indicates an invalid marker;
     // the marker will not be drawn until both styling and geometry are set using the functions below.
     MarkerID markerAdd();
@@ -320,6 +347,32 @@ public:
     // Set the radius in logical pixels to use when picking features on the map (default is 0.5).
     void setPickRadius(float _radius);
 
+    // Load tiles that are predicted to become visible within _horizon seconds, based on the
+    // current view motion and the targets of position and zoom eases. At most _budget tiles
+    // per tile source are loaded ahead. A _horizon of 0 disables prefetching (the default).
+    void setTilePrefetch(float _horizon, size_t _budget);
+
+    // Set the number of threads that decode tile data while the worker threads build tiles
+    // from previously decoded data (default is 1). With 0 each worker thread decodes and builds
+    // its tiles.
+    void setTileDecoders(int _threads);
+
+    // Set the number of threads that each worker thread uses to build a single tile (default
+    // is 1). With more threads the features of large tiles are styled in parallel. Applies from
+    // the next tile that a worker thread builds.
+    void setTileBuilderThreads(int _threads);
+
+    // Set the policy that chooses which tiles are removed first when the in-memory cache
+    // of built tiles is full (default is TileCachePolicyType::lru).
+    void setTileCachePolicy(TileCachePolicyType _policy);
+
+    // Store built tiles in the directory at _path, so that they can be restored without
+    // loading and building their data again, e.g. after a restart. Tiles of the current
+    // scene are kept, files of other scenes are removed. An empty _path disables the cache.
+    // The least recently used files are removed when they take up more than _maxSize bytes.
+    // Only the geometry of tiles is stored: tiles with labels or rasters are built as before.
+    void setTileDiskCache(const std::string& _path, uint64_t _maxSize = 64 * 1024 * 1024);
+
     // Create a query to select a feature marked as 'interactive'. The query runs on the next frame.
     // Calls _onFeaturePickCallback once the query has completed, and returns the FeaturePickResult
     // with its associated properties or null if no feature was found.
@@ -26,6 +26,23 @@ struct UrlResponse {
 // Function type for receiving data from a URL request.
 using UrlCallback = std::function<void(UrlResponse)>;
 
+// Load order of a URL request. Background requests are only needed later, e.g.
+// for proxy or prefetched tiles, and may be preempted by other requests.
+struct UrlRequestPriority {
+    bool background = false;
+    // Requests with lower values are started first
+    double value = 0;
+
+    bool operator<(const UrlRequestPriority& _other) const {
+        if (background != _other.background) { return !background; }
+        return value < _other.value;
+    }
+};
+
+// Function type for reading the current priority of a pending URL request.
+// It is called again whenever requests are scheduled and must be thread-safe.
+using UrlPriorityCallback = std::function<UrlRequestPriority()>;
+
 using FontSourceLoader = std::function<std::vector<char>()>;
 
 struct FontSourceHandle {
@@ -71,6 +88,12 @@ public:
     // thread than the original call to startUrlRequest.
     virtual UrlRequestHandle startUrlRequest(Url _url, UrlCallback _callback) = 0;
 
+    // Start a URL request like startUrlRequest. Platforms that queue requests
+    // start them in the order given by _priority, the default implementation
+    // ignores it.
+    virtual UrlRequestHandle startPrioritizedUrlRequest(Url _url, UrlCallback _callback,
+                                                        UrlPriorityCallback _priority);
+
     // Stop retrieving data from a URL that was previously requested. When a
     // request is canceled its callback will still be run, but the response
     // will have an error string and the data may not be complete.
@@ -11,6 +11,8 @@ namespace Tangram {
 
 class TileManager;
 class TileBuilder;
+class TileDiskCache;
+class TileTaskHeap;
 class TileSource;
 class Tile;
 class MapProjection;
@@ -62,8 +64,17 @@ public:
     int subTaskId() const { return m_subTaskId; }
     bool isSubTask() const { return m_subTaskId >= 0; }
 
-    // running on worker thread
-    virtual void process(TileBuilder& _tileBuilder);
+    // running on worker thread: decode() and build() the tile
+    void process(TileBuilder& _tileBuilder);
+
+    // running on worker thread: parse the data of this task into TileData
+    virtual void decode(const MapProjection& _projection);
+
+    // running on worker thread: create the Tile from the decoded TileData
+    virtual void build(TileBuilder& _tileBuilder);
+
+    // Decoded data, set between decode() and build()
+    const std::shared_ptr<TileData>& tileData() const { return m_tileData; }
 
     // running on main thread when the tile is added to
     virtual void complete();
@@ -73,6 +84,10 @@ public:
 
     int rawSource = 0;
 
+    // Persistent cache for the built tile, set when the tile was looked up in it
+    void setTileDiskCache(std::weak_ptr<TileDiskCache> _cache) { m_tileDiskCache = _cache; }
+    std::shared_ptr<TileDiskCache> tileDiskCache() const { return m_tileDiskCache.lock(); }
+
     bool needsLoading() const { return m_needsLoading; }
 
     // Set whether DataSource should (re)try loading data
@@ -84,6 +99,8 @@ public:
 
 protected:
 
+    friend class TileTaskHeap;
+
     const TileID m_tileId;
 
     const int m_subTaskId;
@@ -96,14 +113,30 @@ protected:
 
     const int64_t m_sourceGeneration;
 
+    // Generation of the source's parsed TileData in the TileDataCache
+    const int64_t m_dataGeneration;
+
     // Tile result, set when tile was  sucessfully created
     std::shared_ptr<Tile> m_tile;
 
-    bool m_canceled = false;
+    std::shared_ptr<TileData> m_tileData;
+
+    // Not owned: the cache holds references to tasks while looking them up
+    std::weak_ptr<TileDiskCache> m_tileDiskCache;
+
+    // Time in milliseconds spent in decode()
+    float m_decodeTime = 0;
+
+    // Set from the main thread, polled by TileBuilder while building
+    std::atomic<bool> m_canceled{false};
     bool m_needsLoading = true;
 
     std::atomic<float> m_priority;
-    bool m_proxyState = false;
+    // Read by the URL client thread when scheduling requests
+    std::atomic<bool> m_proxyState{false};
+
+    // Position in the <TileTaskHeap> of TileWorker, -1 when not queued
+    int m_heapIndex = -1;
 };
 
 class BinaryTileTask : public TileTask {
@@ -122,6 +155,10 @@ public:
 
 struct TileTaskQueue {
     virtual void enqueue(std::shared_ptr<TileTask> task) = 0;
+
+    // Called once per frame with the tasks whose priority changed or
+    // that were canceled since the last call
+    virtual void updateTasks(const std::vector<std::shared_ptr<TileTask>>& tasks) {}
 };
 
 struct TileTaskCb {
@@ -4,19 +4,23 @@
 #include "platform.h"
 #include "tile/tileTask.h"
 #include "util/geom.h"
+#include "data/formats/geoJson.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "tile/tile.h"
+#include "util/asyncWorker.h"
+#include "util/mapProjection.h"
 #include "view/view.h"
 
 #include "mapbox/geojsonvt.hpp"
 
-// RapidJson parser
-#include "mapbox/geojson.hpp"
-#include <mapbox/geojson_impl.hpp>
-
-
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <limits>
+#include <numeric>
 #include <regex>
+#include <unordered_map>
 
 namespace Tangram {
 
@@ -34,10 +38,47 @@ geojsonvt::Options options() {
     return opt;
 }
 
+// Number of changes that tileGeneration() checks, older changes are merged
+#define MAX_CHANGES 256
+
+static BoundingBox emptyBounds() {
+    return { glm::dvec2(std::numeric_limits<double>::max()),
+             glm::dvec2(std::numeric_limits<double>::lowest()) };
+}
+
 struct ClientGeoJsonData {
-    std::unique_ptr<geojsonvt::GeoJSONVT> tiles;
+    // The id of a feature in @features is its index here and in
+    // @properties, @bounds and @ids. Properties are shared with the index.
     mapbox::geometry::feature_collection<double> features;
-    std::vector<Properties> properties;
+    std::vector<std::shared_ptr<const Properties>> properties;
+    std::vector<BoundingBox> bounds;
+    std::vector<uint64_t> ids;
+
+    // Index of each feature by its id
+    std::unordered_map<uint64_t, size_t> indices;
+    uint64_t nextId = 0;
+
+    // Changes that the next index build applies
+    BoundingBox pendingBounds = emptyBounds();
+    bool pendingFullChange = false;
+    bool buildQueued = false;
+
+    // Updates since the last update of all tiles, oldest first
+    struct Change {
+        int64_t generation;
+        BoundingBox bounds;
+    };
+    std::deque<Change> changes;
+    int64_t fullGeneration = 0;
+};
+
+// A geojson-vt index and the properties of its features
+struct ClientGeoJsonIndex {
+    // geojson-vt splits tiles lazily in getTile()
+    std::mutex mutex;
+    std::unique_ptr<geojsonvt::GeoJSONVT> tiles;
+    // Properties by feature id, label centroids come after the features
+    std::vector<std::shared_ptr<const Properties>> properties;
 };
 
 std::shared_ptr<TileTask> ClientGeoJsonSource::createTask(TileID _tileId, int _subTask) {
@@ -57,6 +98,7 @@ ClientGeoJsonSource::ClientGeoJsonSource(std::shared_ptr<Platform> _platform,
 
     m_generateGeometry = true;
     m_store = std::make_unique<ClientGeoJsonData>();
+    m_worker = std::make_unique<AsyncWorker>();
 
     if (!_url.empty()) {
         UrlCallback onUrlFinished = [&, this](UrlResponse response) {
@@ -73,7 +115,10 @@ ClientGeoJsonSource::ClientGeoJsonSource(std::shared_ptr<Platform> _platform,
 
 }
 
-ClientGeoJsonSource::~ClientGeoJsonSource() {}
+ClientGeoJsonSource::~ClientGeoJsonSource() {
+    // Wait for a running index build
+    m_worker.reset();
+}
 
 struct add_centroid {
 
@@ -112,76 +157,326 @@ struct add_centroid {
     }
 };
 
-struct prop_visitor {
-    Properties& props;
-    std::string& key;
-    void operator()(std::string v) {
-        props.set(key, v);
+// Collects the features of the document read by GeoJson::parse() as geojson-vt input
+class ClientFeatureSink : public GeoJson::FeatureSink {
+
+public:
+
+    size_t beginLayer(const std::string& _name) override { return m_numLayers++; }
+
+    void addFeature(size_t _layer, const GeoJson::ParsedFeature& _feature) override {
+        // Named FeatureCollections are not supported here
+        if (_layer != 0) { return; }
+
+        geometry::geometry<double> geom;
+        if (!getGeometry(_feature, geom)) { return; }
+
+        geometries.push_back(std::move(geom));
+        properties.emplace_back();
+
+        Properties& props = properties.back();
+        for (const auto& property : _feature.properties) {
+            if (property.second.is<std::string>()) {
+                props.set(property.first, property.second.get<std::string>());
+            } else if (property.second.is<double>()) {
+                props.set(property.first, property.second.get<double>());
+            }
+        }
     }
-    void operator()(bool v) {
-        props.set(key, double(v));
+
+    void endLayer(size_t _layer, bool _valid) override {
+        if (_layer == 0 && !_valid) {
+            geometries.clear();
+            properties.clear();
+        }
+    }
+
+    std::vector<geometry::geometry<double>> geometries;
+    std::vector<Properties> properties;
+
+private:
+
+    // Returns line @_line of @_feature as a line_string or linear_ring
+    template<class Line>
+    static Line getLine(const GeoJson::ParsedFeature& _feature, size_t _line) {
+        Line line;
+        uint32_t start = _line > 0 ? _feature.lineEnds[_line - 1] : 0;
+        for (uint32_t i = start; i < _feature.lineEnds[_line]; i++) {
+            line.emplace_back(_feature.coordinates[i].x, _feature.coordinates[i].y);
+        }
+        return line;
     }
-    void operator()(uint64_t v) {
-        props.set(key, double(v));
+
+    static bool getGeometry(const GeoJson::ParsedFeature& _feature, geometry::geometry<double>& _geom) {
+
+        const auto& coordinates = _feature.coordinates;
+
+        switch (_feature.geometryType) {
+        case GeometryType::points: {
+            if (coordinates.size() == 1) {
+                _geom = geometry::point<double>(coordinates[0].x, coordinates[0].y);
+                return true;
+            }
+            geometry::multi_point<double> points;
+            for (const auto& p : coordinates) { points.emplace_back(p.x, p.y); }
+            _geom = std::move(points);
+            return true;
+        }
+        case GeometryType::lines: {
+            geometry::multi_line_string<double> lines;
+            for (size_t line = 0; line < _feature.lineEnds.size(); line++) {
+                lines.push_back(getLine<geometry::line_string<double>>(_feature, line));
+            }
+            if (lines.size() == 1) {
+                _geom = std::move(lines[0]);
+            } else {
+                _geom = std::move(lines);
+            }
+            return true;
+        }
+        case GeometryType::polygons: {
+            geometry::multi_polygon<double> polygons;
+            size_t line = 0;
+            for (uint32_t polygonEnd : _feature.polygonEnds) {
+                polygons.emplace_back();
+                for (; line < polygonEnd; line++) {
+                    polygons.back().push_back(getLine<geometry::linear_ring<double>>(_feature, line));
+                }
+            }
+            if (polygons.size() == 1) {
+                _geom = std::move(polygons[0]);
+            } else {
+                _geom = std::move(polygons);
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
     }
-    void operator()(int64_t v) {
-        props.set(key, double(v));
+
+    size_t m_numLayers = 0;
+};
+
+struct add_bounds {
+
+    BoundingBox& bounds;
+
+    void operator()(const geometry::point<double>& p) {
+        bounds.expand(p.x, p.y);
     }
-    void operator()(double v) {
-        props.set(key, v);
+
+    void operator()(const geometry::geometry<double>& geom) {
+        geometry::geometry<double>::visit(geom, *this);
     }
 
+    // Lines, rings, polygons, multi-geometries and collections
     template <typename T>
-    void operator()(T) {
-        // Ignore all other basic value types
+    void operator()(const T& geom) {
+        for (const auto& g : geom) { (*this)(g); }
     }
 };
 
-void ClientGeoJsonSource::generateLabelCentroidFeature() {
-    for (const auto &feat : m_store->features) {
+static BoundingBox getBounds(const geometry::geometry<double>& _geom) {
+    BoundingBox bounds = emptyBounds();
+    add_bounds{ bounds }(_geom);
+    return bounds;
+}
+
+static uint64_t insertFeature(ClientGeoJsonData& _store, geometry::geometry<double>&& _geom,
+                              std::shared_ptr<const Properties> _props) {
+
+    uint64_t id = _store.nextId++;
+    uint64_t index = _store.features.size();
+
+    _store.bounds.push_back(getBounds(_geom));
+    _store.features.emplace_back(std::move(_geom), index);
+    _store.properties.push_back(std::move(_props));
+    _store.ids.push_back(id);
+    _store.indices[id] = index;
+
+    return id;
+}
+
+// Remove the feature at @_index by moving the last feature in its place
+static void eraseFeature(ClientGeoJsonData& _store, size_t _index) {
+
+    _store.indices.erase(_store.ids[_index]);
+
+    size_t last = _store.features.size() - 1;
+    if (_index != last) {
+        _store.features[_index] = std::move(_store.features[last]);
+        _store.features[_index].id = uint64_t(_index);
+        _store.properties[_index] = std::move(_store.properties[last]);
+        _store.bounds[_index] = _store.bounds[last];
+        _store.ids[_index] = _store.ids[last];
+        _store.indices[_store.ids[_index]] = _index;
+    }
+
+    _store.features.pop_back();
+    _store.properties.pop_back();
+    _store.bounds.pop_back();
+    _store.ids.pop_back();
+}
+
+// Add a label point at the centroid of each polygon of @_features
+static void addCentroids(geometry::feature_collection<double>& _features,
+                         std::vector<std::shared_ptr<const Properties>>& _properties) {
+
+    size_t numFeatures = _features.size();
+
+    for (size_t i = 0; i < numFeatures; i++) {
         geometry::point<double> centroid;
-        const auto& properties = m_store->properties[feat.id.get<uint64_t>()];
-        if (geometry::geometry<double>::visit(feat.geometry, add_centroid{ centroid })) {
-            uint64_t id = m_store->features.size();
-            m_store->features.emplace_back(centroid, id);
-            m_store->properties.push_back(properties);
-            auto& props = m_store->properties.back();
-            props.set("label_placement", 1.0);
+        if (geometry::geometry<double>::visit(_features[i].geometry, add_centroid{ centroid })) {
+            uint64_t id = _properties.size();
+            _features.emplace_back(centroid, id);
+
+            auto props = std::make_shared<Properties>(*_properties[i]);
+            props->set("label_placement", 1.0);
+            _properties.push_back(std::move(props));
         }
     }
 }
 
-void ClientGeoJsonSource::addData(const std::string& _data) {
+void ClientGeoJsonSource::updateIndex(const BoundingBox& _bounds) {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    m_store->pendingBounds.expand(_bounds);
 
-    const auto json = geojson::parse(_data);
-    auto features = geojsonvt::geojson::visit(json, geojsonvt::ToFeatureCollection{});
+    if (m_store->buildQueued) { return; }
 
-    for (auto& feature : features) {
+    m_store->buildQueued = true;
+    m_worker->enqueue([this]() { buildIndex(); });
+}
 
-        feature.id = uint64_t(m_store->properties.size());
-        m_store->properties.emplace_back();
-        Properties& props = m_store->properties.back();
+void ClientGeoJsonSource::buildIndex() {
 
-        for (const auto& prop : feature.properties) {
-            auto key = prop.first;
-            prop_visitor visitor = {props, key};
-            mapbox::util::apply_visitor(visitor, prop.second);
-        }
-        feature.properties.clear();
-    }
+    auto index = std::make_shared<ClientGeoJsonIndex>();
+    geometry::feature_collection<double> features;
+    BoundingBox changedBounds;
+    bool fullChange;
 
-    m_store->features.insert(m_store->features.end(),
-                             std::make_move_iterator(features.begin()),
-                             std::make_move_iterator(features.end()));
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+
+        // Updates from here on queue the next build
+        m_store->buildQueued = false;
+
+        features = m_store->features;
+        index->properties = m_store->properties;
+
+        changedBounds = m_store->pendingBounds;
+        fullChange = m_store->pendingFullChange;
+        m_store->pendingBounds = emptyBounds();
+        m_store->pendingFullChange = false;
+    }
 
     if (m_generateCentroids) {
-        generateLabelCentroidFeature();
+        addCentroids(features, index->properties);
+    }
+
+    if (!features.empty()) {
+        index->tiles = std::make_unique<geojsonvt::GeoJSONVT>(features, options());
     }
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
+    {
+        std::lock_guard<std::mutex> lock(m_mutexIndex);
+        m_index = index;
+    }
+
+    // Tiles that are created from here on are built from the new index
+    if (fullChange) {
+        addFullChange();
+    } else {
+        addChange(changedBounds);
+    }
+
+    if (m_platform) {
+        m_platform->requestRender();
+    }
+}
+
+void ClientGeoJsonSource::waitForIndex() {
+
+    // Index builds are queued before this task
+    std::promise<void> done;
+    m_worker->enqueue([&]() { done.set_value(); });
+    done.get_future().wait();
+}
+
+void ClientGeoJsonSource::addChange(const BoundingBox& _bounds) {
+
+    std::lock_guard<std::mutex> lock(m_mutexChanges);
+
     m_generation++;
+
+    auto& changes = m_store->changes;
+    changes.push_back({ m_generation, _bounds });
+
+    if (changes.size() > MAX_CHANGES) {
+        // Merge the two oldest changes, tiles in the merged bounds may be rebuilt early
+        auto oldest = changes.front();
+        changes.pop_front();
+        changes.front().bounds.expand(oldest.bounds);
+    }
+}
+
+void ClientGeoJsonSource::addFullChange() {
+
+    std::lock_guard<std::mutex> lock(m_mutexChanges);
+
+    m_generation++;
+
+    m_store->changes.clear();
+    m_store->fullGeneration = m_generation;
+}
+
+int64_t ClientGeoJsonSource::tileGeneration(const TileID& _tileId) const {
+
+    static const MercatorProjection projection;
+    BoundingBox bounds = projection.TileLonLatBounds(_tileId);
+
+    // TileLonLatBounds() has y pointing down, flip it to latitude
+    BoundingBox tileBounds{ { bounds.min.x, -bounds.max.y }, { bounds.max.x, -bounds.min.y } };
+
+    std::lock_guard<std::mutex> lock(m_mutexChanges);
+
+    // Changes are ordered by generation, the latest one within the tile counts
+    const auto& changes = m_store->changes;
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+        if (it->bounds.intersects(tileBounds)) {
+            return it->generation;
+        }
+    }
+    return m_store->fullGeneration;
+}
+
+void ClientGeoJsonSource::addData(const std::string& _data) {
+
+    // Parse without holding the lock, features are buffered one at a time
+    ClientFeatureSink sink;
+    const char* error;
+    size_t offset;
+
+    if (!GeoJson::parse(_data.data(), _data.size(), sink, &error, &offset)) {
+        LOGE("Unable to parse GeoJSON data: %s (%u)", error, offset);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (sink.geometries.empty()) { return; }
+
+    m_store->features.reserve(m_store->features.size() + sink.geometries.size());
+
+    BoundingBox bounds = emptyBounds();
+
+    for (size_t i = 0; i < sink.geometries.size(); i++) {
+        insertFeature(*m_store, std::move(sink.geometries[i]),
+                      std::make_shared<Properties>(std::move(sink.properties[i])));
+        bounds.expand(m_store->bounds.back());
+    }
+
+    updateIndex(bounds);
 }
 
 void ClientGeoJsonSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -206,70 +501,231 @@ void ClientGeoJsonSource::clearData() {
 
     m_store->features.clear();
     m_store->properties.clear();
-    m_store->tiles.reset();
+    m_store->bounds.clear();
+    m_store->ids.clear();
+    m_store->indices.clear();
 
-    m_generation++;
+    m_store->pendingFullChange = true;
+    updateIndex(emptyBounds());
+}
+
+static geometry::geometry<double> pointGeometry(LngLat _point) {
+    return geometry::point<double>{ _point.longitude, _point.latitude };
+}
+
+static geometry::geometry<double> lineGeometry(const Coordinates& _line) {
+    geometry::line_string<double> geom;
+    for (auto& p : _line) {
+        geom.emplace_back(p.longitude, p.latitude);
+    }
+    return geom;
+}
+
+static geometry::geometry<double> polyGeometry(const std::vector<Coordinates>& _poly) {
+    geometry::polygon<double> geom;
+    for (auto& ring : _poly) {
+        geom.emplace_back();
+        auto &line = geom.back();
+        for (auto& p : ring) {
+            line.emplace_back(p.longitude, p.latitude);
+        }
+    }
+    return geom;
 }
 
-void ClientGeoJsonSource::addPoint(const Properties& _tags, LngLat _point) {
+uint64_t ClientGeoJsonSource::addPoint(const Properties& _tags, LngLat _point) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::point<double> geom { _point.longitude, _point.latitude };
+    uint64_t id = insertFeature(*m_store, pointGeometry(_point), std::make_shared<Properties>(_tags));
+    updateIndex(m_store->bounds.back());
+
+    return id;
+}
 
-    uint64_t id = m_store->features.size();
+uint64_t ClientGeoJsonSource::addLine(const Properties& _tags, const Coordinates& _line) {
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+    std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    uint64_t id = insertFeature(*m_store, lineGeometry(_line), std::make_shared<Properties>(_tags));
+    updateIndex(m_store->bounds.back());
+
+    return id;
+}
+
+uint64_t ClientGeoJsonSource::addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    uint64_t id = insertFeature(*m_store, polyGeometry(_poly), std::make_shared<Properties>(_tags));
+    updateIndex(m_store->bounds.back());
+
+    return id;
 }
 
-void ClientGeoJsonSource::addLine(const Properties& _tags, const Coordinates& _line) {
+// Replace the feature @_id in @_store and set @_changedBounds to the bounds of its old
+// and new geometry, returns false when there is no feature @_id
+static bool updateFeature(ClientGeoJsonData& _store, uint64_t _id, geometry::geometry<double>&& _geom,
+                          const Properties& _tags, BoundingBox& _changedBounds) {
 
+    auto it = _store.indices.find(_id);
+    if (it == _store.indices.end()) { return false; }
+
+    size_t index = it->second;
+
+    _changedBounds = _store.bounds[index];
+
+    _store.bounds[index] = getBounds(_geom);
+    _store.features[index].geometry = std::move(_geom);
+    _store.properties[index] = std::make_shared<Properties>(_tags);
+
+    _changedBounds.expand(_store.bounds[index]);
+
+    return true;
+}
+
+bool ClientGeoJsonSource::updatePoint(uint64_t _id, const Properties& _tags, LngLat _point) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::line_string<double> geom;
-    for (auto& p : _line) {
-        geom.emplace_back(p.longitude, p.latitude);
-    }
+    BoundingBox bounds;
+    if (!updateFeature(*m_store, _id, pointGeometry(_point), _tags, bounds)) { return false; }
 
-    uint64_t id = m_store->features.size();
+    updateIndex(bounds);
+    return true;
+}
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+bool ClientGeoJsonSource::updateLine(uint64_t _id, const Properties& _tags, const Coordinates& _line) {
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    BoundingBox bounds;
+    if (!updateFeature(*m_store, _id, lineGeometry(_line), _tags, bounds)) { return false; }
+
+    updateIndex(bounds);
+    return true;
 }
 
-void ClientGeoJsonSource::addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly) {
+bool ClientGeoJsonSource::updatePoly(uint64_t _id, const Properties& _tags, const std::vector<Coordinates>& _poly) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    BoundingBox bounds;
+    if (!updateFeature(*m_store, _id, polyGeometry(_poly), _tags, bounds)) { return false; }
 
+    updateIndex(bounds);
+    return true;
+}
+
+bool ClientGeoJsonSource::removeFeature(uint64_t _id) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::polygon<double> geom;
-    for (auto& ring : _poly) {
-        geom.emplace_back();
-        auto &line = geom.back();
-        for (auto& p : ring) {
-            line.emplace_back(p.longitude, p.latitude);
+    auto it = m_store->indices.find(_id);
+    if (it == m_store->indices.end()) { return false; }
+
+    BoundingBox bounds = m_store->bounds[it->second];
+    eraseFeature(*m_store, it->second);
+
+    updateIndex(bounds);
+    return true;
+}
+
+uint64_t ClientGeoJsonSource::addFeatures(FeatureBatch _batch) {
+
+    size_t numKeys = _batch.keys.size();
+
+    // Intern the keys once and add the properties of each feature in sorted order
+    std::vector<PropertyKey> keys(_batch.keys.begin(), _batch.keys.end());
+    std::vector<size_t> keyOrder(numKeys);
+    std::iota(keyOrder.begin(), keyOrder.end(), 0);
+    std::sort(keyOrder.begin(), keyOrder.end(), [&](size_t a, size_t b) {
+        return Properties::keyComparator(_batch.keys[a], _batch.keys[b]);
+    });
+
+    size_t numFeatures = 0;
+    switch (_batch.geometryType) {
+    case GeometryType::points: numFeatures = _batch.coordinates.size(); break;
+    case GeometryType::lines: numFeatures = _batch.lineEnds.size(); break;
+    case GeometryType::polygons: numFeatures = _batch.polygonEnds.size(); break;
+    default: break;
+    }
+
+    if (numKeys > 0) {
+        numFeatures = std::min(numFeatures, _batch.values.size() / numKeys);
+    }
+
+    auto maxEnd = [](const std::vector<uint32_t>& _ends) {
+        return _ends.empty() ? 0 : *std::max_element(_ends.begin(), _ends.end());
+    };
+    if (maxEnd(_batch.lineEnds) > _batch.coordinates.size() ||
+        maxEnd(_batch.polygonEnds) > _batch.lineEnds.size()) {
+        LOGE("Feature batch refers to lines or coordinates that it does not have");
+        numFeatures = 0;
+    }
+
+    auto lonLat = [&](uint32_t i) {
+        return geometry::point<double>(_batch.coordinates[i].longitude, _batch.coordinates[i].latitude);
+    };
+
+    std::vector<geometry::geometry<double>> geometries;
+    std::vector<std::shared_ptr<const Properties>> properties;
+    geometries.reserve(numFeatures);
+    properties.reserve(numFeatures);
+
+    uint32_t line = 0;
+    uint32_t start = 0;
+
+    for (size_t i = 0; i < numFeatures; i++) {
+
+        switch (_batch.geometryType) {
+        case GeometryType::points:
+            geometries.push_back(lonLat(i));
+            break;
+        case GeometryType::lines: {
+            geometry::line_string<double> geom;
+            for (; start < _batch.lineEnds[i]; start++) { geom.push_back(lonLat(start)); }
+            geometries.push_back(std::move(geom));
+            break;
+        }
+        default: {
+            geometry::polygon<double> geom;
+            for (; line < _batch.polygonEnds[i]; line++) {
+                geom.emplace_back();
+                for (; start < _batch.lineEnds[line]; start++) { geom.back().push_back(lonLat(start)); }
+            }
+            geometries.push_back(std::move(geom));
         }
+        }
+
+        std::vector<Properties::Item> items;
+        items.reserve(numKeys);
+        for (size_t k : keyOrder) {
+            auto& value = _batch.values[i * numKeys + k];
+            if (!value.is<none_type>()) {
+                items.emplace_back(keys[k], std::move(value));
+            }
+        }
+        auto props = std::make_shared<Properties>();
+        props->setSorted(std::move(items));
+        properties.push_back(std::move(props));
     }
 
-    uint64_t id = m_store->features.size();
+    std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+    uint64_t firstId = m_store->nextId;
+    BoundingBox bounds = emptyBounds();
 
-    if (m_generateCentroids) {
-        generateLabelCentroidFeature();
+    for (size_t i = 0; i < numFeatures; i++) {
+        insertFeature(*m_store, std::move(geometries[i]), std::move(properties[i]));
+        bounds.expand(m_store->bounds.back());
     }
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    if (numFeatures > 0) {
+        updateIndex(bounds);
+    }
+
+    return firstId;
 }
 
 struct add_geometry {
@@ -339,12 +795,21 @@ struct add_geometry {
 std::shared_ptr<TileData> ClientGeoJsonSource::parse(const TileTask& _task,
                                                      const MapProjection& _projection) const {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    std::shared_ptr<ClientGeoJsonIndex> index;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexIndex);
+        index = m_index;
+    }
 
-    auto data = std::make_shared<TileData>();
+    if (!index || !index->tiles) { return nullptr; }
 
-    if (!m_store->tiles) { return nullptr; }
-    auto tile = m_store->tiles->getTile(_task.tileId().z, _task.tileId().x, _task.tileId().y);
+    geojsonvt::Tile tile;
+    {
+        std::lock_guard<std::mutex> lock(index->mutex);
+        tile = index->tiles->getTile(_task.tileId().z, _task.tileId().x, _task.tileId().y);
+    }
+
+    auto data = std::make_shared<TileData>();
 
     data->layers.emplace_back("");  // empty name will skip filtering by 'collection'
     Layer& layer = data->layers.back();
@@ -353,7 +818,7 @@ std::shared_ptr<TileData> ClientGeoJsonSource::parse(const TileTask& _task,
         Feature feature(m_id);
 
         if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature })) {
-            feature.props = m_store->properties[it.id.get<uint64_t>()];
+            feature.props = *index->properties[it.id.get<uint64_t>()];
             layer.features.emplace_back(std::move(feature));
         }
     }
@@ -0,0 +1,177 @@
+#include "data/featureColumns.h"
+
+#include "data/propertyItem.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+uint32_t FeatureColumns::addKey(const std::string& _key) {
+
+    auto it = m_keyIds.find(_key);
+    if (it != m_keyIds.end()) { return it->second; }
+
+    // Only intern keys that are new to this layer
+    return addKey(PropertyKey(_key));
+}
+
+uint32_t FeatureColumns::addKey(const PropertyKey& _key) {
+
+    auto it = m_keyIds.find(_key.str());
+    if (it != m_keyIds.end()) { return it->second; }
+
+    uint32_t id = m_keys.size();
+    m_keys.push_back(_key);
+    m_keyIds.emplace(_key.str(), id);
+    return id;
+}
+
+uint32_t FeatureColumns::addValue(const Value& _value) {
+
+    uint32_t id = m_values.size();
+
+    if (_value.is<std::string>()) {
+        auto result = m_stringIds.emplace(_value.get<std::string>(), id);
+        if (!result.second) { return result.first->second; }
+    } else if (_value.is<double>()) {
+        auto result = m_numberIds.emplace(_value.get<double>(), id);
+        if (!result.second) { return result.first->second; }
+    }
+
+    m_values.push_back(_value);
+    return id;
+}
+
+void FeatureColumns::beginFeature(GeometryType _geometryType) {
+    m_geometryTypes.push_back(_geometryType);
+}
+
+void FeatureColumns::endFeature() {
+
+    m_features.push_back(m_parts.size() - 1);
+
+    // Properties are decoded in the order of Properties
+    std::sort(m_properties.begin() + m_propertyEnds.back(), m_properties.end(),
+              [&](const auto& a, const auto& b) {
+                  return Properties::keyComparator(m_keys[a.first], m_keys[b.first]);
+              });
+
+    m_propertyEnds.push_back(m_properties.size());
+}
+
+void FeatureColumns::finish() {
+
+    m_keyIds = {};
+    m_stringIds = {};
+    m_numberIds = {};
+
+    // Only release larger unused space: shrinking copies the columns
+    auto shrink = [](auto& _column) {
+        if (_column.capacity() - _column.size() > _column.size() / 4) {
+            _column.shrink_to_fit();
+        }
+    };
+    shrink(m_coordinates);
+    shrink(m_rings);
+    shrink(m_parts);
+    shrink(m_properties);
+}
+
+void FeatureColumns::decodeProperties(size_t _index, Feature& _feature, Arena&) const {
+
+    _feature.geometryType = m_geometryTypes[_index];
+
+    size_t begin = m_propertyEnds[_index];
+    size_t count = m_propertyEnds[_index + 1] - begin;
+
+    // Assign to the items of the previously decoded feature to reuse their storage
+    auto items = _feature.props.takeItems();
+    if (items.size() > count) {
+        items.erase(items.begin() + count, items.end());
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        auto& property = m_properties[begin + i];
+        if (i < items.size()) {
+            items[i].key = m_keys[property.first];
+            items[i].value = m_values[property.second];
+        } else {
+            items.emplace_back(m_keys[property.first], m_values[property.second]);
+        }
+    }
+
+    _feature.props.setSorted(std::move(items));
+    _feature.props.sourceId = m_sourceId;
+}
+
+void FeatureColumns::decodeGeometry(size_t _index, Feature& _feature, Arena&) const {
+
+    // Lines and rings of @_feature are resized rather than cleared,
+    // so that decoding reuses their storage from previous features.
+    auto assign = [&](Line& _line, size_t _ring) {
+        _line.assign(m_coordinates.begin() + m_rings[_ring],
+                     m_coordinates.begin() + m_rings[_ring + 1]);
+    };
+
+    size_t firstPart = m_features[_index];
+    size_t numParts = m_features[_index + 1] - firstPart;
+
+    _feature.points.clear();
+
+    switch (m_geometryTypes[_index]) {
+    case GeometryType::points:
+        if (numParts > 0) { assign(_feature.points, m_parts[firstPart]); }
+        _feature.lines.clear();
+        _feature.polygons.clear();
+        break;
+
+    case GeometryType::lines:
+        _feature.lines.resize(numParts);
+        for (size_t i = 0; i < numParts; i++) {
+            assign(_feature.lines[i], m_parts[firstPart + i]);
+        }
+        _feature.polygons.clear();
+        break;
+
+    case GeometryType::polygons:
+        _feature.polygons.resize(numParts);
+        for (size_t i = 0; i < numParts; i++) {
+            size_t firstRing = m_parts[firstPart + i];
+            size_t numRings = m_parts[firstPart + i + 1] - firstRing;
+
+            auto& polygon = _feature.polygons[i];
+            polygon.resize(numRings);
+            for (size_t r = 0; r < numRings; r++) {
+                assign(polygon[r], firstRing + r);
+            }
+        }
+        _feature.lines.clear();
+        break;
+
+    default:
+        _feature.lines.clear();
+        _feature.polygons.clear();
+        break;
+    }
+}
+
+size_t FeatureColumns::memoryUsage() const {
+
+    size_t usage = sizeof(*this);
+
+    usage += m_geometryTypes.capacity() * sizeof(GeometryType);
+    usage += (m_features.capacity() + m_propertyEnds.capacity() +
+              m_parts.capacity() + m_rings.capacity()) * sizeof(uint32_t);
+    usage += m_coordinates.capacity() * sizeof(Point);
+    usage += m_properties.capacity() * sizeof(m_properties[0]);
+
+    // Keys are interned, see <PropertyKey>
+    usage += m_keys.capacity() * sizeof(PropertyKey);
+    for (auto& value : m_values) {
+        usage += sizeof(value);
+        if (value.is<std::string>()) { usage += value.get<std::string>().capacity(); }
+    }
+    return usage;
+}
+
+}
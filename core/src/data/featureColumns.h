@@ -0,0 +1,144 @@
+#pragma once
+
+#include "data/propertyKey.h"
+#include "data/tileData.h"
+#include "util/variant.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * Columnar storage for the features of a Layer.
+ *
+ * The coordinates of all features are kept in one array. Rings (or lines,
+ * or the points of a feature) are ranges of this array, parts (polygons or
+ * lines) are ranges of rings and features are ranges of parts. Properties
+ * are stored as key and value ids into tables that are shared by all
+ * features of the layer.
+ *
+ * Features are added with beginFeature(), addProperty(), the coordinates
+ * of its geometry and endFeature(). Coordinates are added as ranges or one
+ * at a time followed by endPoints(), endLine() or endRing(). Call finish()
+ * when all features were added to release the lookup tables used while adding.
+ */
+class FeatureColumns : public EncodedFeatures {
+
+public:
+
+    FeatureColumns(int32_t _sourceId) : m_sourceId(_sourceId) {}
+
+    size_t size() const override { return m_geometryTypes.size(); }
+
+    void decodeProperties(size_t _index, Feature& _feature, Arena& _arena) const override;
+
+    void decodeGeometry(size_t _index, Feature& _feature, Arena& _arena) const override;
+
+    size_t memoryUsage() const override;
+
+    // Returns the id of @_key in the key table
+    uint32_t addKey(const std::string& _key);
+
+    uint32_t addKey(const PropertyKey& _key);
+
+    // Returns the id of @_value in the value table
+    uint32_t addValue(const Value& _value);
+
+    void beginFeature(GeometryType _geometryType);
+
+    // Add a property of the current feature
+    void addProperty(uint32_t _key, uint32_t _value) { m_properties.push_back({ _key, _value }); }
+
+    void addProperty(const std::string& _key, const Value& _value) {
+        addProperty(addKey(_key), addValue(_value));
+    }
+
+    // Add a coordinate to the current points, line or ring
+    void addCoordinate(const Point& _point) { m_coordinates.push_back(_point); }
+
+    // End the points of the current feature, all points of a feature are one ring
+    void endPoints() {
+        if (hasPart()) {
+            m_rings.back() = m_coordinates.size();
+        } else {
+            closeRing();
+            closePart();
+        }
+    }
+
+    void endLine() {
+        closeRing();
+        closePart();
+    }
+
+    // End a ring of the current polygon, or of a new one when @_newPolygon
+    void endRing(bool _newPolygon) {
+        closeRing();
+        if (_newPolygon || !hasPart()) {
+            closePart();
+        } else {
+            m_parts.back() = m_rings.size() - 1;
+        }
+    }
+
+    template<class It>
+    void addPoints(It _begin, It _end) {
+        m_coordinates.insert(m_coordinates.end(), _begin, _end);
+        endPoints();
+    }
+
+    template<class It>
+    void addLine(It _begin, It _end) {
+        m_coordinates.insert(m_coordinates.end(), _begin, _end);
+        endLine();
+    }
+
+    template<class It>
+    void addRing(It _begin, It _end, bool _newPolygon) {
+        m_coordinates.insert(m_coordinates.end(), _begin, _end);
+        endRing(_newPolygon);
+    }
+
+    void endFeature();
+
+    // Release the lookup tables of addKey() and addValue()
+    void finish();
+
+private:
+
+    // Whether the current feature has a part
+    bool hasPart() const { return m_parts.size() - 1 > m_features.back(); }
+
+    void closeRing() { m_rings.push_back(m_coordinates.size()); }
+    void closePart() { m_parts.push_back(m_rings.size() - 1); }
+
+    int32_t m_sourceId;
+
+    // Per feature: geometry type, end of its parts and properties
+    std::vector<GeometryType> m_geometryTypes;
+    std::vector<uint32_t> m_features = { 0 };
+    std::vector<uint32_t> m_propertyEnds = { 0 };
+
+    // End of the rings of each part
+    std::vector<uint32_t> m_parts = { 0 };
+
+    // End of the coordinates of each ring
+    std::vector<uint32_t> m_rings = { 0 };
+
+    std::vector<Point> m_coordinates;
+
+    // Key and value ids of the properties, sorted per feature by key
+    std::vector<std::pair<uint32_t, uint32_t>> m_properties;
+
+    std::vector<PropertyKey> m_keys;
+    std::vector<Value> m_values;
+
+    // Lookup tables for adding features
+    std::unordered_map<std::string, uint32_t> m_keyIds;
+    std::unordered_map<std::string, uint32_t> m_stringIds;
+    std::unordered_map<double, uint32_t> m_numberIds;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "data/formats/geoJson.h"
 
+#include "data/featureColumns.h"
 #include "data/propertyItem.h"
 #include "log.h"
 #include "tile/tileTask.h"
@@ -7,6 +8,11 @@
 #include "util/mapProjection.h"
 
 #include "glm/glm.hpp"
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
+#include <cstring>
 
 namespace Tangram {
 
@@ -35,62 +41,41 @@ Point GeoJson::getPoint(const JsonValue& _in, const Transform& _proj) {
     return _proj(glm::dvec2(_in[0].GetDouble(), _in[1].GetDouble()));
 }
 
-Line GeoJson::getLine(const JsonValue& _in, const Transform& _proj) {
+void GeoJson::addCoordinates(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns) {
 
-    Line line;
     for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        line.push_back(getPoint(*itr, _proj));
+        _columns.addCoordinate(getPoint(*itr, _proj));
     }
-    return line;
 
 }
 
-Polygon GeoJson::getPolygon(const JsonValue& _in, const Transform& _proj) {
+void GeoJson::addPolygon(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns) {
 
-    Polygon polygon;
     for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        polygon.push_back(getLine(*itr, _proj));
+        addCoordinates(*itr, _proj, _columns);
+        _columns.endRing(itr == _in.Begin());
     }
-    return polygon;
 
 }
 
-Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
-
-    std::vector<PropertyItem> items;
-    items.reserve(_in.MemberCount());
+void GeoJson::addProperties(const JsonValue& _in, FeatureColumns& _columns) {
 
     for (auto it = _in.MemberBegin(); it != _in.MemberEnd(); ++it) {
 
         const auto& name = it->name.GetString();
         const auto& value = it->value;
         if (value.IsNumber()) {
-            items.emplace_back(name, value.GetDouble());
+            _columns.addProperty(name, value.GetDouble());
         } else if (it->value.IsString()) {
-            items.emplace_back(name, value.GetString());
+            _columns.addProperty(name, std::string(value.GetString()));
         } else if (it->value.IsBool()) {
-            items.emplace_back(name, double(value.GetBool()));
+            _columns.addProperty(name, double(value.GetBool()));
         }
     }
 
-    Properties properties;
-    properties.sourceId = _sourceId;
-    properties.setSorted(std::move(items));
-    properties.sort();
-
-    return properties;
-
 }
 
-Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
-
-    Feature feature;
-
-    // Copy properties into tile data
-    auto properties = _in.FindMember("properties");
-    if (properties != _in.MemberEnd()) {
-        feature.props = getProperties(properties->value, _sourceId);
-    }
+void GeoJson::addFeature(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns) {
 
     // Copy geometry into tile data
     const JsonValue& geometry = _in["geometry"];
@@ -99,43 +84,54 @@ Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_
 
     if (geometryType.compare("Point") == 0) {
 
-        feature.geometryType = GeometryType::points;
-        feature.points.push_back(getPoint(coords, _proj));
+        _columns.beginFeature(GeometryType::points);
+        _columns.addCoordinate(getPoint(coords, _proj));
+        _columns.endPoints();
 
     } else if (geometryType.compare("MultiPoint") == 0) {
 
-        feature.geometryType = GeometryType::points;
-        for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
-            feature.points.push_back(getPoint(*pointCoords, _proj));
-        }
+        _columns.beginFeature(GeometryType::points);
+        addCoordinates(coords, _proj, _columns);
+        _columns.endPoints();
 
     } else if (geometryType.compare("LineString") == 0) {
 
-        feature.geometryType = GeometryType::lines;
-        feature.lines.push_back(getLine(coords, _proj));
+        _columns.beginFeature(GeometryType::lines);
+        addCoordinates(coords, _proj, _columns);
+        _columns.endLine();
 
     } else if (geometryType.compare("MultiLineString") == 0) {
 
-        feature.geometryType = GeometryType::lines;
+        _columns.beginFeature(GeometryType::lines);
         for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
-            feature.lines.push_back(getLine(*lineCoords, _proj));
+            addCoordinates(*lineCoords, _proj, _columns);
+            _columns.endLine();
         }
 
     } else if (geometryType.compare("Polygon") == 0) {
 
-        feature.geometryType = GeometryType::polygons;
-        feature.polygons.push_back(getPolygon(coords, _proj));
+        _columns.beginFeature(GeometryType::polygons);
+        addPolygon(coords, _proj, _columns);
 
     } else if (geometryType.compare("MultiPolygon") == 0) {
 
-        feature.geometryType = GeometryType::polygons;
+        _columns.beginFeature(GeometryType::polygons);
         for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
-            feature.polygons.push_back(getPolygon(*polyCoords, _proj));
+            addPolygon(*polyCoords, _proj, _columns);
         }
 
+    } else {
+        // Features of other types have no geometry
+        _columns.beginFeature(GeometryType::polygons);
     }
 
-    return feature;
+    // Copy properties into tile data
+    auto properties = _in.FindMember("properties");
+    if (properties != _in.MemberEnd()) {
+        addProperties(properties->value, _columns);
+    }
+
+    _columns.endFeature();
 
 }
 
@@ -150,30 +146,426 @@ Layer GeoJson::getLayer(const JsonValue& _in, const Transform& _proj, int32_t _s
         return layer;
     }
 
+    auto columns = std::make_shared<FeatureColumns>(_sourceId);
+
     for (auto featureIt = features->value.Begin(); featureIt != features->value.End(); ++featureIt) {
-        layer.features.push_back(getFeature(*featureIt, _proj, _sourceId));
+        addFeature(*featureIt, _proj, *columns);
     }
 
+    columns->finish();
+    layer.encodedFeatures = columns;
+
     return layer;
 
 }
 
-std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId) {
+void GeoJson::ParsedFeature::clear() {
+    geometryType = GeometryType::unknown;
+    coordinates.clear();
+    lineEnds.clear();
+    polygonEnds.clear();
+    properties.clear();
+}
 
-    auto& task = static_cast<const BinaryTileTask&>(_task);
+namespace {
+
+// What a GeoJSON object turned out to be, known once its "type" was read
+enum class ObjectType : uint8_t {
+    unknown,
+    featureCollection,
+    feature,
+    geometry,
+};
+
+// What a coordinates array contains, known once its first element ended
+enum class ArrayKind : uint8_t {
+    empty,
+    position,
+    line,
+    polygon,
+    multiPolygon,
+};
+
+/* SAX handler of GeoJson::parse()
+ *
+ * Keeps a stack of the objects and arrays it is in and buffers the current
+ * feature. Coordinates are collected before the geometry type is known, the
+ * nesting depth of the arrays tells apart points, lines and polygons. Members
+ * that are not part of a feature are skipped. */
+class StreamHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, StreamHandler> {
+
+public:
+
+    StreamHandler(GeoJson::FeatureSink& _sink) : m_sink(_sink) {}
+
+    bool Null() { return true; }
+    bool Bool(bool _value) { return scalar(Value(double(_value))); }
+    bool Int(int _value) { return number(_value); }
+    bool Uint(unsigned _value) { return number(_value); }
+    bool Int64(int64_t _value) { return number(double(_value)); }
+    bool Uint64(uint64_t _value) { return number(double(_value)); }
+    bool Double(double _value) { return number(_value); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth > 0 || m_frames.empty()) { return true; }
+
+        if (m_frames.back() == Frame::object && m_key == "type") {
+            setType(m_objects.back(), _str);
+            return true;
+        }
+        return scalar(Value(std::string(_str, _length)));
+    }
 
-    std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
+    bool Key(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth == 0) { m_key.assign(_str, _length); }
+        return true;
+    }
 
-    // Parse data into a JSON document
-    const char* error;
-    size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
+    bool StartObject() {
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+        if (m_frames.empty()) {
+            // The document itself may be a FeatureCollection, Feature or geometry
+            pushObject(m_sink.beginLayer(""), true);
+            return true;
+        }
+        switch (m_frames.back()) {
+        case Frame::object:
+            if (m_key == "properties") {
+                m_frames.push_back(Frame::properties);
+            } else if (m_key == "geometry") {
+                pushObject(m_objects.back().layer, false);
+            } else if (m_frames.size() == 1) {
+                // Members of the document may be named FeatureCollections
+                pushObject(m_sink.beginLayer(m_key), true);
+            } else {
+                m_skipDepth = 1;
+            }
+            break;
+        case Frame::features:
+            m_feature.clear();
+            pushObject(m_objects.back().layer, false);
+            break;
+        default:
+            m_skipDepth = 1;
+        }
+        return true;
+    }
 
-    if (error) {
-        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
-        return tileData;
+    bool EndObject(rapidjson::SizeType) {
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+        Frame frame = m_frames.back();
+        m_frames.pop_back();
+
+        if (frame != Frame::object) { return true; }
+
+        Object object = m_objects.back();
+        m_objects.pop_back();
+
+        if (object.type == ObjectType::geometry) {
+            m_feature.geometryType = object.geometryType;
+        }
+
+        bool isFeature = object.type == ObjectType::feature ||
+            (object.type == ObjectType::geometry && object.ownsLayer);
+
+        if (isFeature) {
+            m_sink.addFeature(object.layer, m_feature);
+            m_feature.clear();
+        }
+
+        if (object.ownsLayer) {
+            bool isDocument = m_frames.empty();
+            bool valid = object.type == ObjectType::featureCollection || (isDocument && isFeature);
+            m_sink.endLayer(object.layer, valid);
+        }
+        return true;
     }
 
+    bool StartArray() {
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+        if (m_frames.empty()) {
+            m_skipDepth = 1;
+            return true;
+        }
+        switch (m_frames.back()) {
+        case Frame::object:
+            if (m_key == "features") {
+                m_frames.push_back(Frame::features);
+            } else if (m_key == "coordinates") {
+                m_frames.push_back(Frame::coordinates);
+                m_arrays.push_back(ArrayKind::empty);
+                m_numComponents = 0;
+            } else {
+                m_skipDepth = 1;
+            }
+            break;
+        case Frame::coordinates:
+            m_arrays.push_back(ArrayKind::empty);
+            m_numComponents = 0;
+            break;
+        default:
+            m_skipDepth = 1;
+        }
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType) {
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+        if (m_frames.back() != Frame::coordinates) {
+            m_frames.pop_back();
+            return true;
+        }
+
+        ArrayKind kind = m_arrays.back();
+        m_arrays.pop_back();
+
+        switch (kind) {
+        case ArrayKind::position:
+            if (m_numComponents >= 2) {
+                m_feature.coordinates.push_back(m_position);
+            }
+            break;
+        case ArrayKind::line:
+            m_feature.lineEnds.push_back(m_feature.coordinates.size());
+            break;
+        case ArrayKind::polygon:
+            m_feature.polygonEnds.push_back(m_feature.lineEnds.size());
+            break;
+        default:
+            break;
+        }
+
+        if (m_arrays.empty()) {
+            m_frames.pop_back();
+        } else if (kind != ArrayKind::empty && kind != ArrayKind::multiPolygon) {
+            m_arrays.back() = static_cast<ArrayKind>(static_cast<uint8_t>(kind) + 1);
+        }
+        return true;
+    }
+
+private:
+
+    enum class Frame : uint8_t {
+        object,
+        features,
+        coordinates,
+        properties,
+    };
+
+    struct Object {
+        ObjectType type;
+        GeometryType geometryType;
+        // Layer the features of this object are added to
+        size_t layer;
+        bool ownsLayer;
+    };
+
+    void pushObject(size_t _layer, bool _ownsLayer) {
+        m_frames.push_back(Frame::object);
+        m_objects.push_back({ ObjectType::unknown, GeometryType::unknown, _layer, _ownsLayer });
+    }
+
+    void setType(Object& _object, const char* _type) {
+        static const struct { const char* name; ObjectType type; GeometryType geometryType; } types[] = {
+            { "FeatureCollection", ObjectType::featureCollection, GeometryType::unknown },
+            { "Feature", ObjectType::feature, GeometryType::unknown },
+            { "Point", ObjectType::geometry, GeometryType::points },
+            { "MultiPoint", ObjectType::geometry, GeometryType::points },
+            { "LineString", ObjectType::geometry, GeometryType::lines },
+            { "MultiLineString", ObjectType::geometry, GeometryType::lines },
+            { "Polygon", ObjectType::geometry, GeometryType::polygons },
+            { "MultiPolygon", ObjectType::geometry, GeometryType::polygons },
+            // Features of other types have no geometry
+            { "GeometryCollection", ObjectType::geometry, GeometryType::unknown },
+        };
+        for (auto& t : types) {
+            if (std::strcmp(_type, t.name) == 0) {
+                _object.type = t.type;
+                _object.geometryType = t.geometryType;
+                return;
+            }
+        }
+    }
+
+    bool number(double _value) {
+        if (m_skipDepth > 0 || m_frames.empty()) { return true; }
+
+        if (m_frames.back() == Frame::coordinates) {
+            if (m_arrays.back() == ArrayKind::empty) {
+                m_arrays.back() = ArrayKind::position;
+            }
+            if (m_numComponents < 2) {
+                m_position[m_numComponents] = _value;
+            }
+            m_numComponents++;
+            return true;
+        }
+        return scalar(Value(_value));
+    }
+
+    bool scalar(Value&& _value) {
+        if (m_skipDepth == 0 && !m_frames.empty() && m_frames.back() == Frame::properties) {
+            m_feature.properties.emplace_back(m_key, std::move(_value));
+        }
+        return true;
+    }
+
+    GeoJson::FeatureSink& m_sink;
+
+    std::vector<Frame> m_frames;
+    std::vector<Object> m_objects;
+    std::vector<ArrayKind> m_arrays;
+
+    // Depth of the objects and arrays being skipped
+    int m_skipDepth = 0;
+
+    std::string m_key;
+
+    glm::dvec2 m_position;
+    int m_numComponents = 0;
+
+    GeoJson::ParsedFeature m_feature;
+};
+
+// Adds the features of each FeatureCollection as a layer of FeatureColumns
+class ColumnsSink : public GeoJson::FeatureSink {
+
+public:
+
+    ColumnsSink(const GeoJson::Transform& _proj, int32_t _sourceId)
+        : m_proj(_proj), m_sourceId(_sourceId) {}
+
+    size_t beginLayer(const std::string& _name) override {
+        m_layers.emplace_back(_name);
+        m_columns.push_back(std::make_shared<FeatureColumns>(m_sourceId));
+        return m_layers.size() - 1;
+    }
+
+    void addFeature(size_t _layer, const GeoJson::ParsedFeature& _feature) override {
+        GeoJson::addFeature(_feature, m_proj, *m_columns[_layer]);
+    }
+
+    void endLayer(size_t _layer, bool _valid) override {
+        if (_valid) {
+            m_columns[_layer]->finish();
+            m_layers[_layer].encodedFeatures = m_columns[_layer];
+        }
+        m_columns[_layer].reset();
+    }
+
+    // Move the layers that were FeatureCollections into @_tileData
+    void takeLayers(TileData& _tileData) {
+        for (auto& layer : m_layers) {
+            if (layer.encodedFeatures) {
+                _tileData.layers.push_back(std::move(layer));
+            }
+        }
+        m_layers.clear();
+    }
+
+private:
+
+    GeoJson::Transform m_proj;
+    int32_t m_sourceId;
+
+    std::vector<Layer> m_layers;
+    std::vector<std::shared_ptr<FeatureColumns>> m_columns;
+};
+
+}
+
+void GeoJson::addFeature(const ParsedFeature& _feature, const Transform& _proj, FeatureColumns& _columns) {
+
+    const auto& coordinates = _feature.coordinates;
+    const auto& lineEnds = _feature.lineEnds;
+
+    switch (_feature.geometryType) {
+    case GeometryType::points:
+        _columns.beginFeature(GeometryType::points);
+        for (const auto& lonLat : coordinates) {
+            _columns.addCoordinate(_proj(lonLat));
+        }
+        _columns.endPoints();
+        break;
+
+    case GeometryType::lines: {
+        _columns.beginFeature(GeometryType::lines);
+        uint32_t start = 0;
+        for (uint32_t end : lineEnds) {
+            for (uint32_t i = start; i < end; i++) {
+                _columns.addCoordinate(_proj(coordinates[i]));
+            }
+            _columns.endLine();
+            start = end;
+        }
+        break;
+    }
+    case GeometryType::polygons: {
+        _columns.beginFeature(GeometryType::polygons);
+        uint32_t start = 0;
+        uint32_t line = 0;
+        for (uint32_t polygonEnd : _feature.polygonEnds) {
+            for (uint32_t first = line; line < polygonEnd; line++) {
+                for (uint32_t i = start; i < lineEnds[line]; i++) {
+                    _columns.addCoordinate(_proj(coordinates[i]));
+                }
+                _columns.endRing(line == first);
+                start = lineEnds[line];
+            }
+        }
+        break;
+    }
+    default:
+        // Features of other types have no geometry
+        _columns.beginFeature(GeometryType::polygons);
+    }
+
+    for (const auto& property : _feature.properties) {
+        _columns.addProperty(property.first, property.second);
+    }
+
+    _columns.endFeature();
+
+}
+
+bool GeoJson::parse(const char* _data, size_t _length, FeatureSink& _sink,
+                    const char** _error, size_t* _errorOffset) {
+
+    StreamHandler handler(_sink);
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream stream(_data, _length);
+
+    auto result = reader.Parse(stream, handler);
+
+    *_error = nullptr;
+    *_errorOffset = 0;
+    if (result.IsError()) {
+        *_error = rapidjson::GetParseError_En(result.Code());
+        *_errorOffset = result.Offset();
+        return false;
+    }
+    return true;
+
+}
+
+std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId) {
+
+    auto& task = static_cast<const BinaryTileTask&>(_task);
+
+    std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
+
     BoundingBox tileBounds(_projection.TileBounds(task.tileId()));
     glm::dvec2 tileOrigin = {tileBounds.min.x, tileBounds.max.y*-1.0};
     double tileInverseScale = 1.0 / tileBounds.width();
@@ -187,20 +579,17 @@ std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, const MapPro
         };
     };
 
-    // Transform JSON data into TileData using GeoJson functions
-    if (GeoJson::isFeatureCollection(document)) {
-        tileData->layers.push_back(GeoJson::getLayer(document, projFn, _sourceId));
-    } else {
-        for (auto layer = document.MemberBegin(); layer != document.MemberEnd(); ++layer) {
-            if (GeoJson::isFeatureCollection(layer->value)) {
-                tileData->layers.push_back(GeoJson::getLayer(layer->value, projFn, _sourceId));
-                tileData->layers.back().name = layer->name.GetString();
-            }
-        }
-    }
+    // Read features from the JSON stream directly into FeatureColumns
+    ColumnsSink sink(projFn, _sourceId);
 
+    const char* error;
+    size_t offset;
+    if (!GeoJson::parse(task.rawTileData->data(), task.rawTileData->size(), sink, &error, &offset)) {
+        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
+        return tileData;
+    }
 
-    // Discard original JSON object and return TileData
+    sink.takeLayers(*tileData);
 
     return tileData;
 
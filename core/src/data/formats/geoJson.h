@@ -2,11 +2,19 @@
 
 #include "data/tileData.h"
 #include "util/json.h"
+#include "util/variant.h"
+
+#include "glm/vec2.hpp"
+
 #include <functional>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace Tangram {
 
+class FeatureColumns;
 class TileTask;
 class MapProjection;
 
@@ -18,16 +26,60 @@ bool isFeatureCollection(const JsonValue& _in);
 
 Point getPoint(const JsonValue& _in, const Transform& _proj);
 
-Line getLine(const JsonValue& _in, const Transform& _proj);
+// Add the coordinates of a line or ring to the current feature of @_columns
+void addCoordinates(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns);
 
-Polygon getPolygon(const JsonValue& _in, const Transform& _proj);
+void addPolygon(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns);
 
-Properties getProperties(const JsonValue& _in, int32_t _sourceId);
+void addProperties(const JsonValue& _in, FeatureColumns& _columns);
 
-Feature getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
+void addFeature(const JsonValue& _in, const Transform& _proj, FeatureColumns& _columns);
 
 Layer getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
 
+/* A feature read by GeoJson::parse(), with coordinates in longitude and latitude.
+ *
+ * Lines, rings and the points of multi-points are ranges of @coordinates that end
+ * at @lineEnds. Polygons are ranges of lines that end at @polygonEnds. */
+struct ParsedFeature {
+    // Multi-geometries have the type of their parts, unknown without geometry
+    GeometryType geometryType = GeometryType::unknown;
+
+    std::vector<glm::dvec2> coordinates;
+    std::vector<uint32_t> lineEnds;
+    std::vector<uint32_t> polygonEnds;
+
+    // Properties with string, number or bool (as 0 or 1) values
+    std::vector<std::pair<std::string, Value>> properties;
+
+    void clear();
+};
+
+// Add @_feature to @_columns, projecting its coordinates with @_proj
+void addFeature(const ParsedFeature& _feature, const Transform& _proj, FeatureColumns& _columns);
+
+// Receives the layers and features read by GeoJson::parse()
+class FeatureSink {
+public:
+    virtual ~FeatureSink() {}
+
+    // Returns the id of a new layer, @_name is empty for the document itself
+    virtual size_t beginLayer(const std::string& _name) = 0;
+
+    virtual void addFeature(size_t _layer, const ParsedFeature& _feature) = 0;
+
+    // @_valid is false when the layer object turned out not to be a FeatureCollection
+    virtual void endLayer(size_t _layer, bool _valid) = 0;
+};
+
+/* Read the features of a GeoJSON document into @_sink without building a DOM.
+ *
+ * The document may be a FeatureCollection, a Feature, a geometry or an object of
+ * named FeatureCollections. Only one feature is buffered at a time. Returns false
+ * and sets @_error and @_errorOffset when the JSON is malformed. */
+bool parse(const char* _data, size_t _length, FeatureSink& _sink,
+           const char** _error, size_t* _errorOffset);
+
 std::shared_ptr<TileData> parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId);
 
 } // namespace GeoJson
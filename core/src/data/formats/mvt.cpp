@@ -1,13 +1,16 @@
 #include "data/formats/mvt.h"
+#include "data/featureColumns.h"
 #include "data/propertyItem.h"
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "log.h"
 #include "platform.h"
 #include "util/geom.h"
+#include "util/varint.h"
 
 #include <algorithm>
 #include <iterator>
+#include <stdexcept>
 
 #define FEATURE_ID 1
 #define FEATURE_TAGS 2
@@ -22,57 +25,66 @@
 
 namespace Tangram {
 
-Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
+// Decode @_geomIn into @_geometry, normalized by @_tileExtent
+static void readGeometry(protobuf::message _geomIn, int _tileExtent, Mvt::Geometry& _geometry) {
 
-    Geometry geometry;
+    using GeomCmd = Mvt::GeomCmd;
+
+    auto& geometry = _geometry;
+    geometry.coordinates.clear();
+    geometry.sizes.clear();
 
-    GeomCmd cmd = GeomCmd::moveTo;
-    uint32_t cmdRepeat = 0;
+    // Decode all commands and parameters at once, at most one per byte
+    auto& values = geometry.values;
+    values.resize(_geomIn.getEnd() - _geomIn.getData() + VARINT_DECODE_PADDING);
+    size_t numValues = decodeVarints(_geomIn.getData(), _geomIn.getEnd(), values.data());
 
-    double invTileExtent = (1.0/(_ctx.tileExtent-1.0));
+    // Each point takes at least one value
+    geometry.coordinates.reserve(numValues);
 
     int64_t x = 0;
     int64_t y = 0;
 
     size_t numCoordinates = 0;
 
-    while(_geomIn.getData() < _geomIn.getEnd()) {
+    for (size_t i = 0; i < numValues; ) {
 
-        if(cmdRepeat == 0) { // get new command, length and parameters..
-            uint32_t cmdData = static_cast<uint32_t>(_geomIn.varint());
-            cmd = static_cast<GeomCmd>(cmdData & 0x7); //first 3 bits of the cmdData
-            cmdRepeat = cmdData >> 3; //last 5 bits
-        }
+        uint32_t cmdData = values[i++];
+        auto cmd = static_cast<GeomCmd>(cmdData & 0x7); //first 3 bits of the cmdData
+        uint32_t cmdRepeat = cmdData >> 3; //last 5 bits
 
-        if(cmd == GeomCmd::moveTo || cmd == GeomCmd::lineTo) { // get parameters/points
-            // if cmd is move then move to a new line/set of points and save this line
-            if(cmd == GeomCmd::moveTo) {
-                if (geometry.coordinates.size() > 0) {
-                    geometry.sizes.push_back(numCoordinates);
-                }
-                numCoordinates = 0;
+        if (cmd == GeomCmd::moveTo || cmd == GeomCmd::lineTo) { // get parameters/points
+            if (numValues - i < 2 * size_t(cmdRepeat)) {
+                throw std::runtime_error("geometry command exceeds its parameters");
             }
+            for (; cmdRepeat > 0; cmdRepeat--) {
+                // if cmd is move then move to a new line/set of points and save this line
+                if (cmd == GeomCmd::moveTo) {
+                    if (geometry.coordinates.size() > 0) {
+                        geometry.sizes.push_back(numCoordinates);
+                    }
+                    numCoordinates = 0;
+                }
 
-            x += _geomIn.svarint();
-            y += _geomIn.svarint();
+                x += zigzagDecode(values[i++]);
+                y += zigzagDecode(values[i++]);
 
-            // bring the points in 0 to 1 space
-            Point p;
-            p.x = invTileExtent * (double)x;
-            p.y = invTileExtent * (double)(_ctx.tileExtent - y);
+                // Keep tile coordinates until the line is complete, they are exact as float
+                Point p(x, y, 0);
 
-            if (numCoordinates == 0 || geometry.coordinates.back() != p) {
-                geometry.coordinates.push_back(p);
-                numCoordinates++;
+                if (numCoordinates == 0 || geometry.coordinates.back() != p) {
+                    geometry.coordinates.push_back(p);
+                    numCoordinates++;
+                }
             }
-        } else if(cmd == GeomCmd::closePath) {
+        } else if (cmd == GeomCmd::closePath) {
             // end of a polygon, push first point in this line as last and push line to poly
-            geometry.coordinates.push_back(geometry.coordinates[geometry.coordinates.size() - numCoordinates]);
-            geometry.sizes.push_back(numCoordinates + 1);
-            numCoordinates = 0;
+            for (; cmdRepeat > 0 && numCoordinates > 0; cmdRepeat--) {
+                geometry.coordinates.push_back(geometry.coordinates[geometry.coordinates.size() - numCoordinates]);
+                geometry.sizes.push_back(numCoordinates + 1);
+                numCoordinates = 0;
+            }
         }
-
-        cmdRepeat--;
     }
 
     // Enter the last line
@@ -80,101 +92,126 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
         geometry.sizes.push_back(numCoordinates);
     }
 
-    return geometry;
+    // bring the points in 0 to 1 space
+    double invTileExtent = (1.0/(_tileExtent-1.0));
+
+    for (auto& p : geometry.coordinates) {
+        p.x = invTileExtent * (double)p.x;
+        p.y = invTileExtent * (double)(_tileExtent - p.y);
+    }
 }
 
-Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
+Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
 
-    Feature feature(_ctx.sourceId);
+    Geometry geometry;
+    readGeometry(_geomIn, _ctx.tileExtent, geometry);
 
-    _ctx.featureTags.clear();
-    _ctx.featureTags.assign(_ctx.keys.size(), -1);
+    return geometry;
+}
 
+// Read the value ids of @_tagsIn into @_featureTags, indexed by key id
+template<class Tags>
+static bool getFeatureTags(const Mvt::ParserContext& _ctx, protobuf::message _tagsIn, Tags& _featureTags) {
 
-    while(_featureIn.next()) {
-        switch(_featureIn.tag) {
-            case FEATURE_ID:
-                // ignored for now, also not used in json parsing
-                _featureIn.skip();
-                break;
+    while(_tagsIn) {
+        auto tagKey = _tagsIn.varint();
 
-            case FEATURE_TAGS: {
-                protobuf::message tagsMsg = _featureIn.getMessage();
+        if(_ctx.keys.size() <= tagKey) {
+            LOGE("accessing out of bound key");
+            return false;
+        }
 
-                while(tagsMsg) {
-                    auto tagKey = tagsMsg.varint();
+        if(!_tagsIn) {
+            LOGE("uneven number of feature tag ids");
+            return false;
+        }
 
-                    if(_ctx.keys.size() <= tagKey) {
-                        LOGE("accessing out of bound key");
-                        return feature;
-                    }
+        auto valueKey = _tagsIn.varint();
 
-                    if(!tagsMsg) {
-                        LOGE("uneven number of feature tag ids");
-                        return feature;
-                    }
+        if( _ctx.values.size() <= valueKey ) {
+            LOGE("accessing out of bound values");
+            return false;
+        }
 
-                    auto valueKey = tagsMsg.varint();
+        _featureTags[tagKey] = valueKey;
+    }
+    return true;
+}
 
-                    if( _ctx.values.size() <= valueKey ) {
-                        LOGE("accessing out of bound values");
-                        return feature;
-                    }
+static void setProperties(const Mvt::ParserContext& _ctx, const ArenaVector<int>& _featureTags,
+                          Feature& _feature) {
 
-                    _ctx.featureTags[tagKey] = valueKey;
-                }
-                break;
-            }
-            case FEATURE_TYPE:
-                feature.geometryType = (GeometryType)_featureIn.varint();
-                break;
-            // Actual geometry data
-            case FEATURE_GEOM:
-                _ctx.geometry = getGeometry(_ctx, _featureIn.getMessage());
-                break;
+    // Assign to the items of the previously decoded feature to reuse their storage
+    auto properties = _feature.props.takeItems();
+    size_t count = 0;
 
-            default:
-                _featureIn.skip();
-                break;
+    for (int tagKey : _ctx.orderedKeys) {
+        int tagValue = _featureTags[tagKey];
+        if (tagValue < 0) { continue; }
+
+        if (count < properties.size()) {
+            properties[count].key = _ctx.keys[tagKey];
+            properties[count].value = _ctx.values[tagValue];
+        } else {
+            properties.emplace_back(_ctx.keys[tagKey], _ctx.values[tagValue]);
         }
+        count++;
     }
+    properties.erase(properties.begin() + count, properties.end());
+
+    _feature.props.setSorted(std::move(properties));
+}
 
-    std::vector<Properties::Item> properties;
-    properties.reserve(_ctx.featureTags.size());
+// Adds geometry to a Feature, the other output of setGeometry() is FeatureColumns
+struct FeatureGeometry {
+    Feature& feature;
 
-    for (int tagKey : _ctx.orderedKeys) {
-        int tagValue = _ctx.featureTags[tagKey];
-        if (tagValue >= 0) {
-            properties.emplace_back(_ctx.keys[tagKey], _ctx.values[tagValue]);
+    template<class It>
+    void addPoints(It _begin, It _end) {
+        feature.points.insert(feature.points.end(), _begin, _end);
+    }
+
+    template<class It>
+    void addLine(It _begin, It _end) {
+        feature.lines.emplace_back(_begin, _end);
+    }
+
+    template<class It>
+    void addRing(It _begin, It _end, bool _newPolygon) {
+        if (_newPolygon || feature.polygons.empty()) {
+            feature.polygons.emplace_back();
         }
+        feature.polygons.back().emplace_back(_begin, _end);
     }
-    feature.props.setSorted(std::move(properties));
+};
+
+// Add @_geometry to @_output according to @_geometryType. @_winding is the
+// exterior polygon winding, it is set by the first polygon when still unknown.
+template<class Output>
+static void setGeometry(const Mvt::Geometry& _geometry, GeometryType _geometryType, int& _winding,
+                        Output& _output) {
 
-    switch(feature.geometryType) {
+    switch(_geometryType) {
         case GeometryType::points:
-            feature.points.insert(feature.points.begin(),
-                                  _ctx.geometry.coordinates.begin(),
-                                  _ctx.geometry.coordinates.end());
+            _output.addPoints(_geometry.coordinates.begin(), _geometry.coordinates.end());
             break;
 
         case GeometryType::lines:
         {
-            auto pos = _ctx.geometry.coordinates.begin();
-            for (int length : _ctx.geometry.sizes) {
+            auto pos = _geometry.coordinates.begin();
+            for (int length : _geometry.sizes) {
                 if (length == 0) { continue; }
-                Line line;
-                line.reserve(length);
-                line.insert(line.begin(), pos, pos + length);
+                _output.addLine(pos, pos + length);
                 pos += length;
-                feature.lines.emplace_back(std::move(line));
             }
             break;
         }
         case GeometryType::polygons:
         {
-            auto pos = _ctx.geometry.coordinates.begin();
-            auto rpos = _ctx.geometry.coordinates.rend();
-            for (int length : _ctx.geometry.sizes) {
+            auto pos = _geometry.coordinates.begin();
+            auto rpos = _geometry.coordinates.rend();
+            bool first = true;
+            for (int length : _geometry.sizes) {
                 if (length == 0) { continue; }
                 float area = signedArea(pos, pos + length);
                 if (area == 0) {
@@ -184,23 +221,19 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 }
                 int winding = area > 0 ? 1 : -1;
                 // Determine exterior winding from first polygon.
-                if (_ctx.winding == 0) {
-                    _ctx.winding = winding;
+                if (_winding == 0) {
+                    _winding = winding;
                 }
-                Line line;
-                line.reserve(length);
-                if (_ctx.winding > 0) {
-                    line.insert(line.end(), pos, pos + length);
+                // This is an exterior polygon.
+                bool exterior = (winding == _winding || first);
+                if (_winding > 0) {
+                    _output.addRing(pos, pos + length, exterior);
                 } else {
-                    line.insert(line.end(), rpos - length, rpos);
+                    _output.addRing(rpos - length, rpos, exterior);
                 }
                 pos += length;
                 rpos -= length;
-                if (winding == _ctx.winding || feature.polygons.empty()) {
-                    // This is an exterior polygon.
-                    feature.polygons.emplace_back();
-                }
-                feature.polygons.back().push_back(std::move(line));
+                first = false;
             }
             break;
         }
@@ -209,8 +242,187 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         default:
             break;
     }
+}
+
+// Winding of the first ring of @_geometry with non-zero area, 0 if there is none
+static int getWinding(const Mvt::Geometry& _geometry) {
+
+    auto pos = _geometry.coordinates.begin();
+    for (int length : _geometry.sizes) {
+        float area = signedArea(pos, pos + length);
+        if (area != 0) { return area > 0 ? 1 : -1; }
+        pos += length;
+    }
+    return 0;
+}
+
+// Location of the encoded tags and geometry of a feature
+struct FeatureEntry {
+    protobuf::message tags;
+    protobuf::message geometry;
+    GeometryType geometryType;
+};
+
+// Locate the tags and geometry of @_featureIn without decoding them
+static FeatureEntry getFeatureEntry(protobuf::message _featureIn) {
+
+    FeatureEntry entry;
+    entry.geometryType = GeometryType::polygons;
+
+    while(_featureIn.next()) {
+        switch(_featureIn.tag) {
+            case FEATURE_TAGS:
+                entry.tags = _featureIn.getMessage();
+                break;
+            case FEATURE_TYPE:
+                entry.geometryType = (GeometryType)_featureIn.varint();
+                break;
+            case FEATURE_GEOM:
+                entry.geometry = _featureIn.getMessage();
+                break;
+            default:
+                _featureIn.skip();
+                break;
+        }
+    }
+    return entry;
+}
+
+// Features of a layer that are decoded from the raw tile data. Key and value
+// tables are decoded once per layer, features are only located when parsing.
+class LayerFeatures : public EncodedFeatures {
+
+public:
+
+    LayerFeatures(Mvt::ParserContext& _ctx) : m_ctx(_ctx.sourceId) {
+        m_ctx.keys = std::move(_ctx.keys);
+        m_ctx.values = std::move(_ctx.values);
+        m_ctx.orderedKeys = std::move(_ctx.orderedKeys);
+        m_ctx.tileExtent = _ctx.tileExtent;
+        m_ctx.rawData = _ctx.rawData;
+    }
+
+    size_t size() const override { return entries.size(); }
+
+    void decodeProperties(size_t _index, Feature& _feature, Arena& _arena) const override {
+
+        auto& entry = entries[_index];
+
+        _feature.geometryType = entry.geometryType;
+
+        ArenaVector<int> featureTags(m_ctx.keys.size(), -1, ArenaAllocator<int>(&_arena));
+        bool valid = false;
+
+        try {
+            valid = getFeatureTags(m_ctx, entry.tags, featureTags);
+        } catch(const std::exception& e) {
+            LOGE("Cannot decode feature properties: %s", e.what());
+        }
+
+        if (valid) {
+            setProperties(m_ctx, featureTags, _feature);
+        } else {
+            // Like invalid features of eagerly parsed tiles, without geometry
+            _feature.props.clear();
+            _feature.geometryType = GeometryType::unknown;
+        }
+        _feature.props.sourceId = m_ctx.sourceId;
+    }
+
+    void decodeGeometry(size_t _index, Feature& _feature, Arena& _arena) const override {
+
+        _feature.points.clear();
+        _feature.lines.clear();
+        _feature.polygons.clear();
+
+        Mvt::Geometry geometry(&_arena);
+        try {
+            readGeometry(entries[_index].geometry, m_ctx.tileExtent, geometry);
+        } catch(const std::exception& e) {
+            LOGE("Cannot decode feature geometry: %s", e.what());
+            return;
+        }
+
+        int winding = m_ctx.winding;
+        FeatureGeometry output{_feature};
+        setGeometry(geometry, _feature.geometryType, winding, output);
+    }
+
+    size_t memoryUsage() const override {
+
+        size_t usage = sizeof(*this) + entries.capacity() * sizeof(FeatureEntry);
+
+        for (auto& entry : entries) {
+            auto tags = entry.tags;
+            auto geometry = entry.geometry;
+            usage += (tags.getEnd() - tags.getData()) + (geometry.getEnd() - geometry.getData());
+        }
+        // Keys are interned, see <PropertyKey>
+        usage += m_ctx.keys.capacity() * sizeof(PropertyKey);
+        for (auto& value : m_ctx.values) {
+            usage += sizeof(value);
+            if (value.is<std::string>()) { usage += value.get<std::string>().capacity(); }
+        }
+        return usage + m_ctx.orderedKeys.capacity() * sizeof(int);
+    }
+
+    void setWinding(int _winding) { m_ctx.winding = _winding; }
+
+    std::vector<FeatureEntry> entries;
+
+private:
+
+    // Tables of the layer, holds a reference to the raw tile data
+    Mvt::ParserContext m_ctx;
+};
+
+void Mvt::addFeature(ParserContext& _ctx, protobuf::message _featureIn, FeatureColumns& _columns) {
+
+    auto entry = getFeatureEntry(_featureIn);
+
+    _columns.beginFeature(entry.geometryType);
+
+    _ctx.featureTags.clear();
+    _ctx.featureTags.assign(_ctx.keys.size(), -1);
+
+    if (getFeatureTags(_ctx, entry.tags, _ctx.featureTags)) {
+
+        for (int tagKey : _ctx.orderedKeys) {
+            int tagValue = _ctx.featureTags[tagKey];
+            if (tagValue >= 0) {
+                _columns.addProperty(_ctx.keyIds[tagKey], _ctx.valueIds[tagValue]);
+            }
+        }
+
+        readGeometry(entry.geometry, _ctx.tileExtent, _ctx.geometry);
+        setGeometry(_ctx.geometry, entry.geometryType, _ctx.winding, _columns);
+    }
+
+    _columns.endFeature();
+}
+
+static std::shared_ptr<LayerFeatures> getLayerFeatures(Mvt::ParserContext& _ctx, size_t _numFeatures) {
+
+    auto features = std::make_shared<LayerFeatures>(_ctx);
+    features->entries.reserve(_numFeatures);
+
+    for (auto& featureItr : _ctx.featureMsgs) {
+        do {
+            features->entries.push_back(getFeatureEntry(featureItr.getMessage()));
+
+            // The exterior winding is determined by the first polygon
+            // of the tile, as when decoding all features in order.
+            auto& entry = features->entries.back();
+            if (_ctx.winding == 0 && entry.geometryType == GeometryType::polygons) {
+                _ctx.winding = getWinding(Mvt::getGeometry(_ctx, entry.geometry));
+            }
+
+        } while (featureItr.next() && featureItr.tag == LAYER_FEATURE);
+    }
 
-    return feature;
+    features->setWinding(_ctx.winding);
+
+    return features;
 }
 
 Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
@@ -306,20 +518,93 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                   return Properties::keyComparator(_ctx.keys[a], _ctx.keys[b]);
               });
 
-    layer.features.reserve(numFeatures);
+    if (_ctx.rawData) {
+        layer.encodedFeatures = getLayerFeatures(_ctx, numFeatures);
+        return layer;
+    }
+
+    auto columns = std::make_shared<FeatureColumns>(_ctx.sourceId);
+
+    _ctx.keyIds.clear();
+    for (auto& key : _ctx.keys) { _ctx.keyIds.push_back(columns->addKey(key)); }
+
+    _ctx.valueIds.clear();
+    for (auto& value : _ctx.values) { _ctx.valueIds.push_back(columns->addValue(value)); }
+
     for (auto& featureItr : _ctx.featureMsgs) {
         do {
             auto featureMsg = featureItr.getMessage();
 
-            layer.features.push_back(getFeature(_ctx, featureMsg));
+            addFeature(_ctx, featureMsg, *columns);
 
         } while (featureItr.next() && featureItr.tag == LAYER_FEATURE);
     }
 
+    columns->finish();
+    layer.encodedFeatures = columns;
+
     return layer;
 }
 
-std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId) {
+// Whether the layer @_layerIn is named in @_collections. Layers without name
+// are used by all DataLayers of a source, like in TileBuilder::build().
+static bool isSelected(protobuf::message _layerIn, const std::vector<std::string>& _collections) {
+
+    while(_layerIn.next()) {
+        if (_layerIn.tag == LAYER_NAME) {
+            auto name = _layerIn.string();
+            return name.empty() ||
+                std::find(_collections.begin(), _collections.end(), name) != _collections.end();
+        }
+        _layerIn.skip();
+    }
+    return true;
+}
+
+// Skip the layer @_layerIn. Keeps the state that following layers inherit
+// from it: the tile extent and the exterior winding of the first polygon.
+static void skipLayer(Mvt::ParserContext& _ctx, protobuf::message _layerIn, Mvt::SkippedLayers* _skipped) {
+
+    size_t bytes = _layerIn.getEnd() - _layerIn.getData();
+    size_t numFeatures = 0;
+
+    // Geometry of the polygons, while the winding is unknown
+    _ctx.featureMsgs.clear();
+
+    while(_layerIn.next()) {
+        switch(_layerIn.tag) {
+            case LAYER_FEATURE: {
+                numFeatures++;
+                auto entry = getFeatureEntry(_layerIn.getMessage());
+                if (_ctx.winding == 0 && entry.geometryType == GeometryType::polygons) {
+                    _ctx.featureMsgs.push_back(entry.geometry);
+                }
+                break;
+            }
+            case LAYER_TILE_EXTENT:
+                _ctx.tileExtent = static_cast<int>(_layerIn.int64());
+                break;
+            default:
+                _layerIn.skip();
+                break;
+        }
+    }
+
+    for (auto& geometry : _ctx.featureMsgs) {
+        if (_ctx.winding != 0) { break; }
+        _ctx.winding = getWinding(Mvt::getGeometry(_ctx, geometry));
+    }
+
+    if (_skipped) {
+        _skipped->layers++;
+        _skipped->bytes += bytes;
+        _skipped->features += numFeatures;
+    }
+}
+
+std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId,
+                                         bool _lazy, const std::vector<std::string>* _collections,
+                                         SkippedLayers* _skipped) {
 
     auto tileData = std::make_shared<TileData>();
 
@@ -328,10 +613,19 @@ std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, const MapProject
     protobuf::message item(task.rawTileData->data(), task.rawTileData->size());
     ParserContext ctx(_sourceId);
 
+    if (_lazy) { ctx.rawData = task.rawTileData; }
+
     try {
         while(item.next()) {
             if(item.tag == 3) {
-                tileData->layers.push_back(getLayer(ctx, item.getMessage()));
+                auto layerMsg = item.getMessage();
+
+                if (_collections && !isSelected(layerMsg, *_collections)) {
+                    skipLayer(ctx, layerMsg, _skipped);
+                    continue;
+                }
+
+                tileData->layers.push_back(getLayer(ctx, layerMsg));
             } else {
                 item.skip();
             }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "data/propertyKey.h"
 #include "data/tileData.h"
 #include "pbf/pbf.hpp"
+#include "util/arena.h"
 #include "util/variant.h"
 
 #include <memory>
@@ -10,6 +12,7 @@
 
 namespace Tangram {
 
+class FeatureColumns;
 class Tile;
 class TileTask;
 class MapProjection;
@@ -17,15 +20,22 @@ class MapProjection;
 namespace Mvt {
 
     struct Geometry {
-        std::vector<Point> coordinates;
-        std::vector<int> sizes;
+        // Without @_arena the coordinates are allocated on the heap
+        Geometry(Arena* _arena = nullptr)
+            : coordinates(ArenaAllocator<Point>(_arena)), sizes(ArenaAllocator<int>(_arena)),
+              values(ArenaAllocator<uint32_t>(_arena)) {}
+
+        ArenaVector<Point> coordinates;
+        ArenaVector<int> sizes;
+        // Decoded commands and parameters of the last geometry read
+        ArenaVector<uint32_t> values;
     };
 
     struct ParserContext {
         ParserContext(int32_t _sourceId) : sourceId(_sourceId){}
 
         int32_t sourceId;
-        std::vector<std::string> keys;
+        std::vector<PropertyKey> keys;
         std::vector<Value> values;
         std::vector<protobuf::message> featureMsgs;
         Geometry geometry;
@@ -33,9 +43,16 @@ namespace Mvt {
         std::vector<int> featureTags;
         // Key IDs sorted by Property key ordering
         std::vector<int> orderedKeys;
+        // Map Key and Value ID -> FeatureColumns ID
+        std::vector<uint32_t> keyIds;
+        std::vector<uint32_t> valueIds;
 
         int tileExtent = 0;
         int winding = 0;
+
+        // When set, features keep views into this data and
+        // are decoded on demand, see <EncodedFeatures>
+        std::shared_ptr<std::vector<char>> rawData;
     };
 
     enum GeomCmd {
@@ -46,11 +63,24 @@ namespace Mvt {
 
     Geometry getGeometry(ParserContext& _ctx, protobuf::message _geomIn);
 
-    Feature getFeature(ParserContext& _ctx, protobuf::message _featureIn);
+    void addFeature(ParserContext& _ctx, protobuf::message _featureIn, FeatureColumns& _columns);
 
     Layer getLayer(ParserContext& _ctx, protobuf::message _layerIn);
 
-    std::shared_ptr<TileData> parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId);
+    // Layers that parseTile() did not decode
+    struct SkippedLayers {
+        size_t layers = 0;
+        size_t bytes = 0;
+        size_t features = 0;
+    };
+
+    /* Parse the MVT data of @_task into layers of <FeatureColumns>. With @_lazy the features
+     * are not decoded up front: the layers hold <EncodedFeatures> that refer to the raw tile data.
+     * With @_collections only the layers of these names are decoded, other layers are added
+     * to @_skipped. */
+    std::shared_ptr<TileData> parseTile(const TileTask& _task, const MapProjection& _projection, int32_t _sourceId,
+                                        bool _lazy = true, const std::vector<std::string>* _collections = nullptr,
+                                        SkippedLayers* _skipped = nullptr);
 
 } // namespace Mvt
 
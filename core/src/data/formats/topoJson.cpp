@@ -1,5 +1,6 @@
 #include "data/formats/topoJson.h"
 #include "data/formats/geoJson.h"
+#include "data/featureColumns.h"
 #include "data/propertyItem.h"
 #include "tile/tileTask.h"
 #include "util/geom.h"
@@ -82,12 +83,10 @@ Point TopoJson::getPoint(const JsonValue& _coordinates, const Topology& _topolog
 
 }
 
-Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
-
-    Line line;
+void TopoJson::addLine(const JsonValue& _arcs, const Topology& _topology, FeatureColumns& _columns) {
 
     if (!_arcs.IsArray()) {
-        return line;
+        return;
     }
 
     for (auto arcIt = _arcs.Begin(); arcIt != _arcs.End(); ++arcIt) {
@@ -122,48 +121,35 @@ Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
         }
 
         for (auto pointIt = begin; pointIt != end; pointIt += inc) {
-            line.push_back(*pointIt);
+            _columns.addCoordinate(*pointIt);
         }
 
     }
 
-    return line;
-
 }
 
-Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topology) {
-
-    Polygon polygon;
+void TopoJson::addPolygon(const JsonValue& _arcSets, const Topology& _topology, FeatureColumns& _columns) {
 
     if (!_arcSets.IsArray()) {
-        return polygon;
+        return;
     }
 
     for (auto arcSetIt = _arcSets.Begin(); arcSetIt != _arcSets.End(); ++arcSetIt) {
 
-        auto ring = getLine(*arcSetIt, _topology);
-        polygon.push_back(ring);
+        addLine(*arcSetIt, _topology, _columns);
+        _columns.endRing(arcSetIt == _arcSets.Begin());
 
     }
 
-    return polygon;
-
 }
 
-Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _source) {
+void TopoJson::addFeature(const JsonValue& _geometry, const Topology& _topology, FeatureColumns& _columns) {
 
     static const JsonValue keyProperties("properties");
     static const JsonValue keyType("type");
     static const JsonValue keyCoordinates("coordinates");
     static const JsonValue keyArcs("arcs");
 
-    Feature feature;
-
-    auto propertiesIt = _geometry.FindMember(keyProperties);
-    if (propertiesIt != _geometry.MemberEnd() && propertiesIt->value.IsObject()) {
-        feature.props = GeoJson::getProperties(propertiesIt->value, _source);
-    }
-
     std::string type;
     auto typeIt = _geometry.FindMember(keyType);
     if (typeIt != _geometry.MemberEnd() && typeIt->value.IsString()) {
@@ -171,57 +157,67 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
     }
 
     if (type == "Point") {
-        feature.geometryType = GeometryType::points;
+        _columns.beginFeature(GeometryType::points);
         auto coordinatesIt = _geometry.FindMember(keyCoordinates);
         if (coordinatesIt != _geometry.MemberEnd()) {
             glm::ivec2 cursor;
-            feature.points.push_back(getPoint(coordinatesIt->value, _topology, cursor));
+            _columns.addCoordinate(getPoint(coordinatesIt->value, _topology, cursor));
+            _columns.endPoints();
         }
     } else if (type == "MultiPoint") {
-        feature.geometryType = GeometryType::points;
+        _columns.beginFeature(GeometryType::points);
         auto coordinatesIt = _geometry.FindMember(keyCoordinates);
         if (coordinatesIt != _geometry.MemberEnd() && coordinatesIt->value.IsArray()) {
             auto& coordinates = coordinatesIt->value;
             for (auto point = coordinates.Begin(); point != coordinates.End(); ++point) {
                 glm::ivec2 cursor;
-                feature.points.push_back(getPoint(*point, _topology, cursor));
+                _columns.addCoordinate(getPoint(*point, _topology, cursor));
             }
+            _columns.endPoints();
         }
     } else if (type == "LineString") {
-        feature.geometryType = GeometryType::lines;
+        _columns.beginFeature(GeometryType::lines);
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.lines.push_back(getLine(arcsIt->value, _topology));
+            addLine(arcsIt->value, _topology, _columns);
+            _columns.endLine();
         }
     } else if (type == "MultiLineString") {
-        feature.geometryType = GeometryType::lines;
+        _columns.beginFeature(GeometryType::lines);
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.lines.push_back(getLine(*arcList, _topology));
+                addLine(*arcList, _topology, _columns);
+                _columns.endLine();
             }
         }
     } else if (type == "Polygon") {
-        feature.geometryType = GeometryType::polygons;
+        _columns.beginFeature(GeometryType::polygons);
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.polygons.push_back(getPolygon(arcsIt->value, _topology));
+            addPolygon(arcsIt->value, _topology, _columns);
         }
     } else if (type == "MultiPolygon") {
-        feature.geometryType = GeometryType::polygons;
+        _columns.beginFeature(GeometryType::polygons);
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.polygons.push_back(getPolygon(*arcList, _topology));
+                addPolygon(*arcList, _topology, _columns);
             }
         }
-    } else if (type == "GeometryCollection") {
-        // Not handled
+    } else {
+        // GeometryCollection is not handled
+        _columns.beginFeature(GeometryType::polygons);
     }
 
-    return feature;
+    auto propertiesIt = _geometry.FindMember(keyProperties);
+    if (propertiesIt != _geometry.MemberEnd() && propertiesIt->value.IsObject()) {
+        GeoJson::addProperties(propertiesIt->value, _columns);
+    }
+
+    _columns.endFeature();
 
 }
 
@@ -234,9 +230,14 @@ Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _
     if (type != object.MemberEnd() && strcmp("GeometryCollection", type->value.GetString()) == 0) {
         auto geometries = object.FindMember("geometries");
         if (geometries != object.MemberEnd() && geometries->value.IsArray()) {
+            auto columns = std::make_shared<FeatureColumns>(_source);
+
             for (auto it = geometries->value.Begin(); it != geometries->value.End(); ++it) {
-                layer.features.push_back(getFeature(*it, _topology, _source));
+                addFeature(*it, _topology, *columns);
             }
+
+            columns->finish();
+            layer.encodedFeatures = columns;
         }
     }
 
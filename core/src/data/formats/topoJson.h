@@ -9,6 +9,7 @@
 
 namespace Tangram {
 
+class FeatureColumns;
 class TileTask;
 class MapProjection;
 
@@ -27,11 +28,12 @@ Topology getTopology(const JsonDocument& _document, const Transform& _proj);
 
 Point getPoint(const JsonValue& _coordinates, const Topology& _topology, glm::ivec2& _cursor);
 
-Line getLine(const JsonValue& _arcs, const Topology& _topology);
+// Add the coordinates of the line made of @_arcs to the current feature of @_columns
+void addLine(const JsonValue& _arcs, const Topology& _topology, FeatureColumns& _columns);
 
-Polygon getPolygon(const JsonValue& _arcs, const Topology& _topology);
+void addPolygon(const JsonValue& _arcs, const Topology& _topology, FeatureColumns& _columns);
 
-Feature getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _sourceId);
+void addFeature(const JsonValue& _geometry, const Topology& _topology, FeatureColumns& _columns);
 
 Layer getLayer(JsonValue::MemberIterator& _object, const Topology& _topology, int32_t _sourceId);
 
@@ -7,8 +7,14 @@
 #include "util/url.h"
 
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Transaction.h>
 #include "hash-library/md5.cpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_set>
+
 
 namespace Tangram {
 
@@ -98,25 +104,86 @@ CREATE VIEW IF NOT EXISTS grid_data AS
     JOIN keymap ON grid_key.key_name = keymap.key_name;
 COMMIT;)SQL_ESC";
 
-struct MBTilesQueries {
-    // SELECT statement from tiles view
-    SQLite::Statement getTileData;
+// Maximum number of tiles that are read with one query
+#define MBTILES_BATCH_SIZE 32
+
+// Bytes of the database that the readers of a source map into memory together,
+// less where address space is scarce
+#if UINTPTR_MAX > 0xffffffff
+#define MBTILES_MMAP_SIZE (256 * 1024 * 1024)
+#else
+#define MBTILES_MMAP_SIZE (32 * 1024 * 1024)
+#endif
+
+// Milliseconds that a reader waits for a write to finish
+#define MBTILES_BUSY_TIMEOUT 1000
+
+// Number of buffered tiles that are written without waiting for MBTILES_WRITE_DELAY
+#define MBTILES_WRITE_BATCH 64
+
+// Milliseconds that stored tiles are buffered before they are written
+#define MBTILES_WRITE_DELAY 500
+
+// Fraction of the cache size that eviction shrinks the database to. The free
+// space holds several write batches, so that not every batch is followed by
+// a DELETE of old tiles and an incremental_vacuum pass
+#define MBTILES_EVICT_TARGET 0.9
 
+struct MBTilesQueries {
     // REPLACE INTO statement in map table
     SQLite::Statement putMap;
 
-    // REPLACE INTO statement in images table
+    // INSERT INTO statement in images table, images that are already stored are kept
     SQLite::Statement putImage;
 
+    // UPDATE statement of the access time in map table
+    SQLite::Statement touchMap;
+
     MBTilesQueries(SQLite::Database& _db, bool _cache)
-        : getTileData(_db, "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;"),
-          putMap(_db, _cache ? "REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id) VALUES (?, ?, ?, ?);" : ";" ),
-          putImage(_db, _cache ? "REPLACE INTO images (tile_id, tile_data) VALUES (?, ?);" : ";") {}
+        : putMap(_db, _cache ? "REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id, last_access) VALUES (?, ?, ?, ?, ?);" : ";" ),
+          putImage(_db, _cache ? "INSERT OR IGNORE INTO images (tile_id, tile_data) VALUES (?, ?);" : ";"),
+          touchMap(_db, _cache ? "UPDATE map SET last_access = ? WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;" : ";") {}
 
 };
 
+// SELECT statement from tiles view for MBTILES_BATCH_SIZE tiles of one zoom level.
+// Each tile is matched on the full (zoom_level, tile_column, tile_row) index, unused
+// parameters repeat the first tile.
+static std::string batchQuery() {
+    std::string query = "SELECT tile_column, tile_row, tile_data FROM tiles WHERE ";
+    for (int i = 0; i < MBTILES_BATCH_SIZE; i++) {
+        if (i > 0) { query += " OR "; }
+        query += "(zoom_level = ?1 AND tile_column = ?" + std::to_string(2 + 2 * i) +
+            " AND tile_row = ?" + std::to_string(3 + 2 * i) + ")";
+    }
+    return query + ";";
+}
+
+struct MBTilesReader {
+    SQLite::Database db;
+
+    std::unique_ptr<SQLite::Statement> getTileData;
+
+    // Whether the worker is reading lookups, guarded by MBTilesDataSource::m_lookupMutex
+    bool busy = false;
+
+    // Destroyed first to finish a running query
+    std::unique_ptr<AsyncWorker> worker;
+
+    MBTilesReader(const std::string& _path, const char* _vfs, size_t _mmapSize)
+        : db(_path, SQLite::OPEN_READONLY, MBTILES_BUSY_TIMEOUT, _vfs) {
+
+        // Read tiles from the mapped file instead of copying them through the page cache
+        db.exec("PRAGMA mmap_size = " + std::to_string(_mmapSize) + ";");
+
+        getTileData = std::make_unique<SQLite::Statement>(db, batchQuery());
+        worker = std::make_unique<AsyncWorker>();
+    }
+};
+
 MBTilesDataSource::MBTilesDataSource(std::shared_ptr<Platform> _platform, std::string _name,
-                                     std::string _path, std::string _mime, bool _cache, bool _offlineFallback)
+                                     std::string _path, std::string _mime, bool _cache, bool _offlineFallback,
+                                     size_t _maxReaders)
     : m_name(_name),
       m_path(_path),
       m_mime(_mime),
@@ -126,10 +193,22 @@ MBTilesDataSource::MBTilesDataSource(std::shared_ptr<Platform> _platform, std::s
 
     m_worker = std::make_unique<AsyncWorker>();
 
-    openMBTiles();
+    openMBTiles(_maxReaders);
 }
 
 MBTilesDataSource::~MBTilesDataSource() {
+    // Finish running lookups while the other members are alive
+    m_readers.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_storeMutex);
+        m_closing = true;
+    }
+    m_storeCondition.notify_one();
+
+    // Finish a running write, then write the tiles that remain
+    m_worker.reset();
+    if (m_queries) { writeTiles(); }
 }
 
 bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -146,35 +225,7 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
     if (!m_db) { return false; }
 
     if (_task->rawSource == this->level) {
-
-        m_worker->enqueue([this, _task, _cb](){
-            TileID tileId = _task->tileId();
-
-            auto& task = static_cast<BinaryTileTask&>(*_task);
-            task.rawTileData = std::make_shared<std::vector<char>>();
-
-            getTileData(tileId, *task.rawTileData);
-
-            if (task.hasData()) {
-                LOGW("loaded tile: %s, %d", tileId.toString().c_str(), task.rawTileData->size());
-
-                _cb.func(_task);
-
-            } else if (next) {
-
-                // Don't try this source again
-                _task->rawSource = next->level;
-
-                if (!loadNextSource(_task, _cb)) {
-                    // Trigger TileManager update so that tile will be
-                    // downloaded next time.
-                    _task->setNeedsLoading(true);
-                    m_platform->requestRender();
-                }
-            } else {
-                LOGW("missing tile: %s, %d", _task->tileId().toString().c_str());
-            }
-        });
+        queueLookup(_task, _cb, false);
         return true;
     }
 
@@ -194,14 +245,11 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
         if (_task->hasData()) {
 
             if (m_cacheMode) {
-                m_worker->enqueue([this, _task](){
-
-                        auto& task = static_cast<BinaryTileTask&>(*_task);
+                auto& task = static_cast<BinaryTileTask&>(*_task);
 
-                        LOGW("store tile: %s, %d", _task->tileId().toString().c_str(), task.hasData());
+                LOGW("store tile: %s, %d", _task->tileId().toString().c_str(), task.hasData());
 
-                        storeTileData(_task->tileId(), *task.rawTileData);
-                    });
+                storeTileData(_task->tileId(), task.rawTileData);
             }
 
             _cb.func(_task);
@@ -209,18 +257,7 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
         } else if (m_offlineMode) {
             LOGW("try fallback tile: %s, %d", _task->tileId().toString().c_str());
 
-            m_worker->enqueue([this, _task, _cb](){
-
-                auto& task = static_cast<BinaryTileTask&>(*_task);
-                task.rawTileData = std::make_shared<std::vector<char>>();
-
-                getTileData(_task->tileId(), *task.rawTileData);
-
-                LOGW("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
-
-                _cb.func(_task);
-
-            });
+            queueLookup(_task, _cb, true);
         } else {
             LOGW("missing tile: %s, %d", _task->tileId().toString().c_str());
             _cb.func(_task);
@@ -230,7 +267,98 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
     return next->loadTileData(_task, cb);
 }
 
-void MBTilesDataSource::openMBTiles() {
+void MBTilesDataSource::queueLookup(std::shared_ptr<TileTask> _task, TileTaskCb _cb, bool _fallback) {
+
+    std::lock_guard<std::mutex> lock(m_lookupMutex);
+
+    m_lookups.push_back({ _task, _cb, _fallback });
+
+    // Busy readers take this lookup with their next batch
+    for (auto& reader : m_readers) {
+        if (!reader->busy) {
+            reader->busy = true;
+            MBTilesReader* r = reader.get();
+            reader->worker->enqueue([this, r](){ readTiles(*r); });
+            break;
+        }
+    }
+}
+
+void MBTilesDataSource::readTiles(MBTilesReader& _reader) {
+
+    std::vector<Lookup> batch;
+
+    while (true) {
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+
+            if (m_lookups.empty()) {
+                _reader.busy = false;
+                return;
+            }
+
+            // Take the oldest lookups of the zoom level of the first one
+            int z = m_lookups.front().task->tileId().z;
+
+            for (auto it = m_lookups.begin(); it != m_lookups.end() && batch.size() < MBTILES_BATCH_SIZE; ) {
+                if (it->task->tileId().z == z) {
+                    batch.push_back(std::move(*it));
+                    it = m_lookups.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        getTileData(_reader, batch);
+
+        for (auto& lookup : batch) {
+            onLookupDone(lookup);
+        }
+    }
+}
+
+void MBTilesDataSource::onLookupDone(Lookup& _lookup) {
+
+    auto& _task = _lookup.task;
+    auto& task = static_cast<BinaryTileTask&>(*_task);
+
+    if (_lookup.fallback) {
+        LOGW("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
+
+        _lookup.cb.func(_task);
+
+    } else if (task.hasData()) {
+        LOGW("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
+
+        _lookup.cb.func(_task);
+
+    } else if (next) {
+
+        // Don't try this source again
+        _task->rawSource = next->level;
+
+        if (!loadNextSource(_task, _lookup.cb)) {
+            // Trigger TileManager update so that tile will be
+            // downloaded next time.
+            _task->setNeedsLoading(true);
+            m_platform->requestRender();
+        }
+    } else {
+        LOGW("missing tile: %s, %d", _task->tileId().toString().c_str());
+    }
+}
+
+void MBTilesDataSource::openMBTiles(size_t _maxReaders) {
+
+    auto url = Url(m_path);
+    auto path = url.path();
+    const char* vfs = "";
+    if (url.scheme() == "asset") {
+        vfs = "ndk-asset";
+        path.erase(path.begin()); // Remove leading '/'.
+    }
 
     try {
         auto mode = SQLite::OPEN_READONLY;
@@ -240,13 +368,6 @@ void MBTilesDataSource::openMBTiles() {
             mode = SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE;
         }
 
-        auto url = Url(m_path);
-        auto path = url.path();
-        const char* vfs = "";
-        if (url.scheme() == "asset") {
-            vfs = "ndk-asset";
-            path.erase(path.begin()); // Remove leading '/'.
-        }
         m_db = std::make_unique<SQLite::Database>(path, mode, 0, vfs);
         LOG("SQLite database opened: %s", path.c_str());
 
@@ -263,7 +384,6 @@ void MBTilesDataSource::openMBTiles() {
             LOGE("Cannot cache to 'externally created' MBTiles database");
             // Run in non-caching mode
             m_cacheMode = false;
-            return;
         }
     } else if (m_cacheMode) {
 
@@ -287,6 +407,19 @@ void MBTilesDataSource::openMBTiles() {
         return;
     }
 
+    if (m_cacheMode) {
+        // Let readers run while tiles are stored. Cached tiles can be downloaded
+        // again, so commits don't need to wait for the WAL to be synced.
+        try {
+            m_db->exec("PRAGMA journal_mode = WAL;");
+            m_db->exec("PRAGMA synchronous = NORMAL;");
+        } catch (std::exception& e) {
+            LOGW("Unable to set WAL journal mode: %s", e.what());
+        }
+
+        initCacheSchema(*m_db);
+    }
+
     try {
         m_queries = std::make_unique<MBTilesQueries>(*m_db, m_cacheMode);
     } catch (std::exception& e) {
@@ -294,6 +427,28 @@ void MBTilesDataSource::openMBTiles() {
         m_db.reset();
         return;
     }
+
+    openReaders(path, vfs, _maxReaders);
+}
+
+void MBTilesDataSource::openReaders(const std::string& _path, const char* _vfs, size_t _maxReaders) {
+
+    // Readers mostly wait for I/O, so they are not limited to the number of cores
+    size_t numReaders = std::max(_maxReaders, size_t(1));
+    size_t mmapSize = MBTILES_MMAP_SIZE / numReaders;
+
+    for (size_t i = 0; i < numReaders; i++) {
+        try {
+            m_readers.push_back(std::make_unique<MBTilesReader>(_path, _vfs, mmapSize));
+        } catch (std::exception& e) {
+            LOGE("Unable to open MBTiles reader: %s", e.what());
+            break;
+        }
+    }
+
+    if (m_readers.empty()) {
+        m_db.reset();
+    }
 }
 
 /**
@@ -376,6 +531,10 @@ void MBTilesDataSource::initSchema(SQLite::Database& db, std::string _name, std:
 
     // Otherwise, we need to execute schema.sql to set up the db with the right schema.
     try {
+        // Let evicted tiles be released without rewriting the database.
+        // This only takes effect before the first table is created.
+        db.exec("PRAGMA auto_vacuum = INCREMENTAL;");
+
         // Execute schema.
         db.exec(SCHEMA);
 
@@ -422,43 +581,90 @@ void MBTilesDataSource::initSchema(SQLite::Database& db, std::string _name, std:
     }
 }
 
-bool MBTilesDataSource::getTileData(const TileID& _tileId, std::vector<char>& _data) {
+void MBTilesDataSource::initCacheSchema(SQLite::Database& db) {
 
-    auto& stmt = m_queries->getTileData;
+    try {
+        // Caches created before access times were tracked don't have the column,
+        // their tiles count as least recently used
+        bool hasAccessTime = false;
+        SQLite::Statement columns(db, "PRAGMA table_info(map);");
+        while (columns.executeStep()) {
+            std::string name = columns.getColumn(1);
+            if (name == "last_access") { hasAccessTime = true; }
+        }
+        if (!hasAccessTime) {
+            db.exec("ALTER TABLE map ADD COLUMN last_access INTEGER NOT NULL DEFAULT 0;");
+        }
+
+        db.exec("CREATE INDEX IF NOT EXISTS map_last_access ON map (last_access);"
+                "CREATE INDEX IF NOT EXISTS map_tile_id ON map (tile_id);");
+
+        SQLite::Statement autoVacuum(db, "PRAGMA auto_vacuum;");
+        // 2 is INCREMENTAL
+        m_incrementalVacuum = autoVacuum.executeStep() && autoVacuum.getColumn(0).getInt() == 2;
+
+        m_cacheSize = databaseSize();
+
+    } catch (std::exception& e) {
+        LOGE("Unable to setup MBTiles cache tables: %s", e.what());
+    }
+}
+
+void MBTilesDataSource::getTileData(MBTilesReader& _reader, std::vector<Lookup>& _batch) {
+
+    size_t numBuffered = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_storeMutex);
+
+        for (auto& lookup : _batch) {
+            auto& task = static_cast<BinaryTileTask&>(*lookup.task);
+
+            // Tiles that are not committed yet are not visible to readers
+            task.rawTileData = findStoredTile(lookup.task->tileId());
+            if (task.rawTileData) {
+                numBuffered++;
+            } else {
+                task.rawTileData = std::make_shared<std::vector<char>>();
+            }
+        }
+    }
+
+    if (numBuffered == _batch.size()) {
+        m_hits += numBuffered;
+        return;
+    }
+
+    auto& stmt = *_reader.getTileData;
     try {
         // Google TMS to WMTS
         // https://github.com/mapbox/node-mbtiles/blob/
         // 4bbfaf991969ce01c31b95184c4f6d5485f717c3/lib/mbtiles.js#L149
-        int z = _tileId.z;
-        int y = (1 << z) - 1 - _tileId.y;
-
+        int z = _batch.front().task->tileId().z;
         stmt.bind(1, z);
-        stmt.bind(2, _tileId.x);
-        stmt.bind(3, y);
 
-        if (stmt.executeStep()) {
-            SQLite::Column column = stmt.getColumn(0);
+        for (int i = 0; i < MBTILES_BATCH_SIZE; i++) {
+            TileID tileId = _batch[size_t(i) < _batch.size() ? i : 0].task->tileId();
+            stmt.bind(2 + 2 * i, tileId.x);
+            stmt.bind(3 + 2 * i, (1 << z) - 1 - tileId.y);
+        }
+
+        while (stmt.executeStep()) {
+            int x = stmt.getColumn(0).getInt();
+            int y = (1 << z) - 1 - stmt.getColumn(1).getInt();
+
+            SQLite::Column column = stmt.getColumn(2);
             const char* blob = (const char*) column.getBlob();
             const int length = column.getBytes();
 
-            if ((m_schemaOptions.compression == Compression::undefined) ||
-                (m_schemaOptions.compression == Compression::deflate)) {
+            for (auto& lookup : _batch) {
+                TileID tileId = lookup.task->tileId();
+                if (tileId.x != x || tileId.y != y) { continue; }
 
-                if (zlib::inflate(blob, length, _data) != 0) {
-                    if (m_schemaOptions.compression == Compression::undefined) {
-                        _data.resize(length);
-                        memcpy(_data.data(), blob, length);
-                    } else {
-                        LOGW("Invalid deflate compression");
-                    }
-                }
-            } else {
-                _data.resize(length);
-                memcpy(_data.data(), blob, length);
-            }
+                auto& task = static_cast<BinaryTileTask&>(*lookup.task);
+                if (!task.rawTileData->empty()) { continue; }
 
-            stmt.reset();
-            return true;
+                decodeTileData(blob, length, *task.rawTileData);
+            }
         }
 
     } catch (std::exception& e) {
@@ -468,49 +674,277 @@ bool MBTilesDataSource::getTileData(const TileID& _tileId, std::vector<char>& _d
         stmt.reset();
     } catch(...) {}
 
-    return false;
+    size_t numHits = 0;
+    for (auto& lookup : _batch) {
+        auto& task = static_cast<BinaryTileTask&>(*lookup.task);
+        if (!task.rawTileData->empty()) { numHits++; }
+    }
+    m_hits += numHits;
+    m_misses += _batch.size() - numHits;
+
+    if (m_cacheMode && numHits > numBuffered) {
+        std::lock_guard<std::mutex> lock(m_storeMutex);
+
+        for (auto& lookup : _batch) {
+            auto& task = static_cast<BinaryTileTask&>(*lookup.task);
+            if (task.rawTileData->empty()) { continue; }
+
+            TileID tileId = lookup.task->tileId();
+            TileID key(tileId.x, tileId.y, tileId.z);
+            // Buffered tiles get their access time when they are written
+            if (!findStoredTile(key)) {
+                m_accessed.insert(key);
+            }
+        }
+        queueWrite();
+    }
+}
+
+void MBTilesDataSource::decodeTileData(const char* _blob, int _length, std::vector<char>& _data) {
+
+    if ((m_schemaOptions.compression == Compression::undefined) ||
+        (m_schemaOptions.compression == Compression::deflate)) {
+
+        if (zlib::inflate(_blob, _length, _data) != 0) {
+            if (m_schemaOptions.compression == Compression::undefined) {
+                _data.resize(_length);
+                memcpy(_data.data(), _blob, _length);
+            } else {
+                LOGW("Invalid deflate compression");
+            }
+        }
+    } else {
+        _data.resize(_length);
+        memcpy(_data.data(), _blob, _length);
+    }
 }
 
-void MBTilesDataSource::storeTileData(const TileID& _tileId, const std::vector<char>& _data) {
-    int z = _tileId.z;
-    int y = (1 << z) - 1 - _tileId.y;
+void MBTilesDataSource::storeTileData(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data) {
+
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+
+    if (m_closing) { return; }
+
+    // A newer download of a buffered tile replaces it
+    m_stores[TileID(_tileId.x, _tileId.y, _tileId.z)] = _data;
 
-    const char* data = _data.data();
-    size_t size = _data.size();
+    if (m_stores.size() >= MBTILES_WRITE_BATCH) {
+        m_storeCondition.notify_one();
+    }
+
+    queueWrite();
+}
+
+void MBTilesDataSource::queueWrite() {
+
+    if (m_writeQueued || m_closing) { return; }
+
+    m_writeQueued = true;
+    m_worker->enqueue([this](){ writeTiles(); });
+}
+
+std::shared_ptr<std::vector<char>> MBTilesDataSource::findStoredTile(const TileID& _tileId) {
+
+    TileID key(_tileId.x, _tileId.y, _tileId.z);
+
+    auto it = m_stores.find(key);
+    if (it != m_stores.end()) { return it->second; }
+
+    it = m_storing.find(key);
+    if (it != m_storing.end()) { return it->second; }
+
+    return nullptr;
+}
+
+void MBTilesDataSource::writeTiles() {
+
+    std::set<TileID> accessed;
+    {
+        std::unique_lock<std::mutex> lock(m_storeMutex);
+
+        m_storeCondition.wait_for(lock, std::chrono::milliseconds(MBTILES_WRITE_DELAY), [&]{
+            return m_closing || m_stores.size() >= MBTILES_WRITE_BATCH;
+        });
+
+        // Tiles that are stored from here on queue the next write
+        m_writeQueued = false;
+        m_storing = std::move(m_stores);
+        m_stores.clear();
+        accessed = std::move(m_accessed);
+        m_accessed.clear();
+    }
+
+    if (m_storing.empty() && accessed.empty()) {
+        evictTiles();
+        return;
+    }
+
+    // Milliseconds, so that tiles written one after another are evicted in that order
+    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
 
     /**
      * We create an MD5 of the raw tile data. The MD5 functions as a hash
      * between the map and images tables. With this, tiles with duplicate
      * data will join to a single entry in the images table.
      */
-    MD5 md5;
-    std::string md5id = md5(data, size);
+    std::vector<std::string> md5ids;
+    md5ids.reserve(m_storing.size());
+
+    for (auto& store : m_storing) {
+        MD5 md5;
+        md5ids.push_back(md5(store.second->data(), store.second->size()));
+    }
 
     try {
-        auto& stmt = m_queries->putMap;
-        stmt.bind(1, z);
-        stmt.bind(2, _tileId.x);
-        stmt.bind(3, y);
-        stmt.bind(4, md5id);
-        stmt.exec();
+        // One transaction and sync for all buffered tiles
+        SQLite::Transaction transaction(*m_db);
+
+        // Identical tiles of this batch share one image
+        std::unordered_set<std::string> images;
+
+        size_t i = 0;
+        for (auto& store : m_storing) {
+            const TileID& tileId = store.first;
+            const std::string& md5id = md5ids[i++];
+
+            int z = tileId.z;
+            int y = (1 << z) - 1 - tileId.y;
+
+            auto& putMap = m_queries->putMap;
+            putMap.bind(1, z);
+            putMap.bind(2, tileId.x);
+            putMap.bind(3, y);
+            putMap.bind(4, md5id);
+            putMap.bind(5, now);
+            putMap.exec();
+            putMap.reset();
+
+            if (!images.insert(md5id).second) { continue; }
+
+            auto& putImage = m_queries->putImage;
+            putImage.bind(1, md5id);
+            putImage.bind(2, store.second->data(), store.second->size());
+            putImage.exec();
+            putImage.reset();
+        }
 
-        stmt.reset();
+        for (auto& tileId : accessed) {
+            auto& touchMap = m_queries->touchMap;
+            touchMap.bind(1, now);
+            touchMap.bind(2, tileId.z);
+            touchMap.bind(3, tileId.x);
+            touchMap.bind(4, (1 << tileId.z) - 1 - tileId.y);
+            touchMap.exec();
+            touchMap.reset();
+        }
+
+        transaction.commit();
 
     } catch (std::exception& e) {
-        LOGE("MBTiles SQLite put map statement failed: %s", e.what());
+        LOGE("MBTiles SQLite store tiles transaction failed: %s", e.what());
+        try {
+            m_queries->putMap.reset();
+            m_queries->putImage.reset();
+            m_queries->touchMap.reset();
+        } catch (...) {}
     }
 
+    {
+        // The readers see committed tiles from here on
+        std::lock_guard<std::mutex> lock(m_storeMutex);
+        m_storing.clear();
+    }
+
+    evictTiles();
+}
+
+uint64_t MBTilesDataSource::databaseSize() {
+
+    auto pragma = [&](const char* _query) -> uint64_t {
+        SQLite::Statement stmt(*m_db, _query);
+        return stmt.executeStep() ? stmt.getColumn(0).getInt64() : 0;
+    };
+
+    return (pragma("PRAGMA page_count;") - pragma("PRAGMA freelist_count;")) * pragma("PRAGMA page_size;");
+}
+
+void MBTilesDataSource::evictTiles() {
+
     try {
-        auto& stmt = m_queries->putImage;
-        stmt.bind(1, md5id);
-        stmt.bind(2, data, size);
-        stmt.exec();
+        uint64_t size = databaseSize();
+        uint64_t maxSize = m_maxCacheSize;
 
-        stmt.reset();
+        if (maxSize == 0 || size <= maxSize) {
+            m_cacheSize = size;
+            return;
+        }
+
+        uint64_t targetSize = maxSize * MBTILES_EVICT_TARGET;
+
+        int64_t numTiles = 0;
+        {
+            // Finalized before VACUUM, which fails while statements are running
+            SQLite::Statement countTiles(*m_db, "SELECT count(*) FROM map;");
+            if (countTiles.executeStep()) { numTiles = countTiles.getColumn(0).getInt64(); }
+        }
+
+        while (size > targetSize && numTiles > 0) {
+            // Remove as many tiles of average size as the database is too large
+            int64_t numEvict = std::min<int64_t>(numTiles, (size - targetSize) / (size / numTiles) + 1);
+
+            SQLite::Transaction transaction(*m_db);
+
+            SQLite::Statement deleteMap(*m_db, "DELETE FROM map WHERE rowid IN "
+                                        "(SELECT rowid FROM map ORDER BY last_access LIMIT ?);");
+            deleteMap.bind(1, (long long)numEvict);
+            deleteMap.exec();
+
+            // Also removes images of tiles that were replaced by newer downloads
+            m_db->exec("DELETE FROM images WHERE tile_id NOT IN (SELECT tile_id FROM map);");
+
+            transaction.commit();
+
+            numTiles -= numEvict;
+            size = databaseSize();
+        }
+
+        LOG("MBTiles cache evicted to %d kB", int(size / 1024));
+
+        // Return the freed pages to the file system
+        if (m_incrementalVacuum) {
+            m_db->exec("PRAGMA incremental_vacuum;");
+        } else {
+            // Caches created before incremental vacuum was enabled are rewritten once
+            m_db->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+            m_db->exec("VACUUM;");
+            m_incrementalVacuum = true;
+        }
+
+        m_cacheSize = databaseSize();
 
     } catch (std::exception& e) {
-        LOGE("MBTiles SQLite put image statement failed: %s", e.what());
+        LOGE("MBTiles SQLite evict tiles failed: %s", e.what());
     }
 }
 
+void MBTilesDataSource::setCacheSize(uint64_t _cacheSize) {
+
+    m_maxCacheSize = _cacheSize;
+
+    if (!m_cacheMode || !m_queries) { return; }
+
+    // Evict with the next write
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    queueWrite();
+}
+
+MBTilesDataSource::Stats MBTilesDataSource::getStats() const {
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.size = m_cacheSize;
+    return stats;
+}
+
 }
@@ -2,6 +2,15 @@
 
 #include "data/tileSource.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
 namespace SQLite {
 class Database;
 }
@@ -12,13 +21,38 @@ namespace Tangram {
 class Platform;
 
 struct MBTilesQueries;
+struct MBTilesReader;
 class AsyncWorker;
 
+/*
+ * Tiles are read on a pool of read-only connections, each with its own worker thread.
+ * Tiles that were requested while the readers were busy are read in batches, with one
+ * query for up to MBTILES_BATCH_SIZE tiles of a zoom level. More than one reader only
+ * helps when reads wait for storage, e.g. with a cold page cache or a network file
+ * system; for files in the page cache one reader is as fast, so it is the default.
+ *
+ * In cache mode tiles from the next source are buffered and written in one transaction
+ * per MBTILES_WRITE_BATCH tiles or MBTILES_WRITE_DELAY milliseconds. Buffered tiles are
+ * read from the buffer until they are committed.
+ *
+ * With a cache size set, the least recently read or stored tiles of a cache-mode
+ * database are removed when it grows larger, and the freed pages are returned to
+ * the file system.
+ */
+
 class MBTilesDataSource : public TileSource::DataSource {
 public:
 
+    struct Stats {
+        // Tiles that were read from the database, or are buffered to be written to it
+        size_t hits = 0;
+        size_t misses = 0;
+        // Bytes in use by the database, updated when tiles were written or removed
+        uint64_t size = 0;
+    };
+
     MBTilesDataSource(std::shared_ptr<Platform> _platform, std::string _name, std::string _path, std::string _mime,
-                      bool _cache = false, bool _offlineFallback = false);
+                      bool _cache = false, bool _offlineFallback = false, size_t _maxReaders = 1);
 
     ~MBTilesDataSource();
 
@@ -26,14 +60,59 @@ public:
 
     void clear() override {}
 
+    /* Set the maximum size of a cache-mode database in bytes, 0 for no limit (the default) */
+    void setCacheSize(uint64_t _cacheSize);
+
+    Stats getStats() const;
+
+    /* Whether tiles from the next source are stored in the database */
+    bool isCache() const { return m_cacheMode; }
+
 private:
-    bool getTileData(const TileID& _tileId, std::vector<char>& _data);
-    void storeTileData(const TileID& _tileId, const std::vector<char>& _data);
+    struct Lookup {
+        std::shared_ptr<TileTask> task;
+        TileTaskCb cb;
+        // Whether this is the offline fallback for a tile that the next source did not have
+        bool fallback;
+    };
+
+    // Read the tile of @_task on the next free reader
+    void queueLookup(std::shared_ptr<TileTask> _task, TileTaskCb _cb, bool _fallback);
+
+    // Runs on the worker of @_reader until no lookups are queued
+    void readTiles(MBTilesReader& _reader);
+
+    // Read the tiles of @_batch, all of one zoom level, into their tasks
+    void getTileData(MBTilesReader& _reader, std::vector<Lookup>& _batch);
+    void decodeTileData(const char* _blob, int _length, std::vector<char>& _data);
+
+    void onLookupDone(Lookup& _lookup);
+
+    // Buffer @_data of @_tileId to be written with the next transaction
+    void storeTileData(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data);
+
+    // Runs on m_worker: wait for a full batch or the write delay, then write the buffered tiles
+    void writeTiles();
+
+    // Returns the data of @_tileId when it is buffered, call with m_storeMutex held
+    std::shared_ptr<std::vector<char>> findStoredTile(const TileID& _tileId);
+
+    // Queue writeTiles() unless it is queued, call with m_storeMutex held
+    void queueWrite();
+
+    // Runs on m_worker: remove least recently used tiles until the database fits into the cache size
+    void evictTiles();
+
+    // Bytes of the pages in use by m_db
+    uint64_t databaseSize();
+
     bool loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
 
-    void openMBTiles();
+    void openMBTiles(size_t _maxReaders);
+    void openReaders(const std::string& _path, const char* _vfs, size_t _maxReaders);
     bool testSchema(SQLite::Database& db);
     void initSchema(SQLite::Database& db, std::string _name, std::string _mimeType);
+    void initCacheSchema(SQLite::Database& db);
 
     std::string m_name;
 
@@ -52,6 +131,30 @@ private:
     std::unique_ptr<MBTilesQueries> m_queries;
     std::unique_ptr<AsyncWorker> m_worker;
 
+    // Read-only connections and the lookups that wait for one of them
+    std::vector<std::unique_ptr<MBTilesReader>> m_readers;
+    std::deque<Lookup> m_lookups;
+    std::mutex m_lookupMutex;
+
+    // Tiles waiting for the next transaction and those of the running transaction, by z/x/y
+    std::map<TileID, std::shared_ptr<std::vector<char>>> m_stores;
+    std::map<TileID, std::shared_ptr<std::vector<char>>> m_storing;
+    std::mutex m_storeMutex;
+    std::condition_variable m_storeCondition;
+    bool m_writeQueued = false;
+    bool m_closing = false;
+
+    // Tiles that were read since the last write, their access time is updated with it
+    std::set<TileID> m_accessed;
+
+    std::atomic<uint64_t> m_maxCacheSize{0};
+    std::atomic<uint64_t> m_cacheSize{0};
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+
+    // Whether freed pages of m_db can be released with incremental_vacuum
+    bool m_incrementalVacuum = false;
+
     // Platform reference
     std::shared_ptr<Platform> m_platform;
 
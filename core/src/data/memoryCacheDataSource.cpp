@@ -4,12 +4,71 @@
 #include "tile/tileID.h"
 #include "log.h"
 
+#include <cstring>
 #include <list>
 #include <mutex>
 #include <unordered_map>
 
 namespace Tangram {
 
+// Content-addressed store of the tile data of all caches, identical payloads
+// (e.g. empty ocean tiles of different sources or positions) share one buffer.
+struct RawDataStore {
+
+    std::mutex m_mutex;
+
+    // Data by hash of its content, entries expire when no cache or task holds the data
+    std::unordered_multimap<size_t, std::weak_ptr<std::vector<char>>> m_entries;
+    size_t m_sweepSize = 1024;
+
+    static size_t hash(const std::vector<char>& _data) {
+        // FNV-1a over 8 byte words
+        uint64_t hash = 14695981039346656037ull ^ _data.size();
+        size_t i = 0;
+        for (; i + 8 <= _data.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, _data.data() + i, 8);
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        for (; i < _data.size(); i++) {
+            hash = (hash ^ uint8_t(_data[i])) * 1099511628211ull;
+        }
+        return size_t(hash);
+    }
+
+    // Returns stored data with the content of _data, or stores _data
+    std::shared_ptr<std::vector<char>> intern(std::shared_ptr<std::vector<char>> _data) {
+        size_t key = hash(*_data);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto range = m_entries.equal_range(key);
+        for (auto it = range.first; it != range.second; ) {
+            auto stored = it->second.lock();
+            if (!stored) {
+                it = m_entries.erase(it);
+                continue;
+            }
+            if (stored == _data || *stored == *_data) {
+                return stored;
+            }
+            ++it;
+        }
+
+        m_entries.emplace(key, _data);
+
+        if (m_entries.size() >= m_sweepSize) {
+            for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+                if (it->second.expired()) { it = m_entries.erase(it); } else { ++it; }
+            }
+            m_sweepSize = std::max<size_t>(1024, 2 * m_entries.size());
+        }
+        return _data;
+    }
+};
+
+static RawDataStore s_rawDataStore;
+
 struct RawCache {
 
     // Used to ensure safe access from async loading threads
@@ -22,6 +81,8 @@ struct RawCache {
 
     CacheMap m_cacheMap;
     CacheList m_cacheList;
+    // Number of entries by data, shared data is counted once in m_usage
+    std::unordered_map<const std::vector<char>*, int> m_dataRefs;
     int m_usage = 0;
     int m_maxUsage = 0;
 
@@ -51,10 +112,17 @@ struct RawCache {
         std::lock_guard<std::mutex> lock(m_mutex);
         TileID id(tileID.x, tileID.y, tileID.z);
 
+        auto it = m_cacheMap.find(id);
+        if (it != m_cacheMap.end()) {
+            removeEntry(it->second);
+        }
+
         m_cacheList.push_front({id, rawDataRef});
         m_cacheMap[id] = m_cacheList.begin();
 
-        m_usage += rawDataRef->size();
+        if (m_dataRefs[rawDataRef.get()]++ == 0) {
+            m_usage += rawDataRef->size();
+        }
 
         while (m_usage > m_maxUsage) {
             if (m_cacheList.empty()) {
@@ -66,18 +134,25 @@ struct RawCache {
             // LOGE("Limit raw cache tiles:%d, %fMB ", m_cacheList.size(),
             //        double(m_cacheUsage) / (1024*1024));
 
-            auto& entry = m_cacheList.back();
-            m_usage -= entry.second->size();
+            removeEntry(std::prev(m_cacheList.end()));
+        }
+    }
 
-            m_cacheMap.erase(entry.first);
-            m_cacheList.pop_back();
+    void removeEntry(CacheList::iterator _entry) {
+        auto ref = m_dataRefs.find(_entry->second.get());
+        if (--ref->second == 0) {
+            m_usage -= _entry->second->size();
+            m_dataRefs.erase(ref);
         }
+        m_cacheMap.erase(_entry->first);
+        m_cacheList.erase(_entry);
     }
 
     void clear() {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_cacheMap.clear();
         m_cacheList.clear();
+        m_dataRefs.clear();
         m_usage = 0;
     }
 };
@@ -93,6 +168,11 @@ void MemoryCacheDataSource::setCacheSize(size_t _cacheSize) {
     m_cache->m_maxUsage = _cacheSize;
 }
 
+size_t MemoryCacheDataSource::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+    return m_cache->m_usage;
+}
+
 bool MemoryCacheDataSource::cacheGet(BinaryTileTask& _task) {
     return m_cache->get(_task);
 }
@@ -124,7 +204,10 @@ bool MemoryCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTa
 
             auto& task = static_cast<BinaryTileTask&>(*_task);
 
-            if (task.hasData()) { cachePut(task.tileId(), task.rawTileData); }
+            if (task.hasData()) {
+                task.rawTileData = s_rawDataStore.intern(task.rawTileData);
+                cachePut(task.tileId(), task.rawTileData);
+            }
 
             _cb.func(_task);
         }});
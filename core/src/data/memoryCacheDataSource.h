@@ -19,6 +19,9 @@ public:
      */
     void setCacheSize(size_t _cacheSize);
 
+    /* Bytes of tile data in the cache, identical data of several tiles is counted once */
+    size_t getMemoryUsage() const;
+
 private:
     bool cacheGet(BinaryTileTask& _task);
 
@@ -3,8 +3,39 @@
 #include "log.h"
 #include "platform.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <map>
+
 namespace Tangram {
 
+// A URL request that one or more tasks wait for
+struct SharedUrlRequest {
+
+    struct Waiter {
+        std::shared_ptr<TileTask> task;
+        TileTaskCb callback;
+        NetworkDataSource* source;
+    };
+
+    using Key = std::pair<const Platform*, std::string>;
+    Key key;
+
+    std::vector<Waiter> waiters;
+    UrlRequestHandle handle = 0;
+    // The platform request was started
+    bool started = false;
+    // All waiters were removed before the request was started
+    bool canceled = false;
+};
+
+// Requests in flight by Platform and URL, shared by all NetworkDataSources
+static std::mutex s_requestMutex;
+static std::map<SharedUrlRequest::Key, std::shared_ptr<SharedUrlRequest>> s_requests;
+// Notified when a source finished running the callbacks of a request
+static std::condition_variable s_callbacksDone;
+
 NetworkDataSource::NetworkDataSource(std::shared_ptr<Platform> _platform, const std::string& _urlTemplate,
         std::vector<std::string>&& _urlSubdomains, bool isTms) :
     m_platform(_platform),
@@ -12,6 +43,22 @@ NetworkDataSource::NetworkDataSource(std::shared_ptr<Platform> _platform, const
     m_urlSubdomains(std::move(_urlSubdomains)),
     m_isTms(isTms) {}
 
+NetworkDataSource::~NetworkDataSource() {
+    // Stop waiting for pending requests, other sources may still share them.
+    std::vector<TileID> tiles;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (auto& pending : m_pending) { tiles.push_back(pending.tile); }
+    }
+    for (auto& tile : tiles) {
+        removePending(tile, true);
+    }
+
+    // A request that finished before may still call into this source.
+    std::unique_lock<std::mutex> lock(s_requestMutex);
+    s_callbacksDone.wait(lock, [&]{ return m_activeCallbacks == 0; });
+}
+
 std::string NetworkDataSource::buildUrlForTile(const TileID& tile, size_t subdomainIndex) const {
 
     std::string url = m_urlTemplate;
@@ -58,54 +105,152 @@ bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb
         m_urlSubdomainIndex = (m_urlSubdomainIndex + 1) % m_urlSubdomains.size();
     }
 
-    UrlCallback onRequestFinish = [this, callback, task, url](UrlResponse response) mutable {
-
-        removePending(task->tileId(), false);
+    // Join the request for this URL when another task already waits for it.
+    std::shared_ptr<SharedUrlRequest> request;
+    bool startRequest = false;
+    {
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        SharedUrlRequest::Key key{ m_platform.get(), url.string() };
 
-        if (task->isCanceled()) {
-            return;
+        auto& entry = s_requests[key];
+        if (!entry) {
+            entry = std::make_shared<SharedUrlRequest>();
+            entry->key = key;
+            startRequest = true;
         }
+        request = entry;
+        request->waiters.push_back({ task, callback, this });
+    }
 
-        if (response.error) {
-            LOGE("Error for URL request '%s': %s", url.string().c_str(), response.error);
-            return;
-        }
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pending.push_back({ tileId, request });
+    }
 
-        if (!response.content.empty()) {
-            auto& dlTask = static_cast<BinaryTileTask&>(*task);
-            dlTask.rawTileData = std::make_shared<std::vector<char>>(std::move(response.content));
+    if (!startRequest) { return true; }
+
+    UrlCallback onRequestFinish = [request](UrlResponse response) {
+        NetworkDataSource::onRequestFinish(request, response);
+    };
+
+    // Load tiles closest to the view center first and proxy tiles last, as TileManager
+    // updates the priorities while the request waits. The request has the highest
+    // priority of its waiting tasks.
+    std::weak_ptr<SharedUrlRequest> weakRequest = request;
+    UrlPriorityCallback priority = [weakRequest]() {
+        // Requests that no task waits for anymore are canceled soon, never prefer them.
+        UrlRequestPriority result{ true, std::numeric_limits<double>::max() };
+        auto request = weakRequest.lock();
+        if (!request) { return result; }
+
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        for (auto& waiter : request->waiters) {
+            UrlRequestPriority priority{ waiter.task->isProxy(), waiter.task->getPriority() };
+            if (priority < result) { result = priority; }
         }
-        callback.func(task);
+        return result;
     };
 
+    // The request is started without holding a lock, the platform may run its callback right away.
+    auto requestHandle = m_platform->startPrioritizedUrlRequest(url, onRequestFinish, priority);
+
+    bool cancelRequest = false;
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        auto requestHandle = m_platform->startUrlRequest(url, onRequestFinish);
-        m_pending.push_back({ tileId, requestHandle });
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        request->handle = requestHandle;
+        request->started = true;
+        cancelRequest = request->canceled;
+    }
+    if (cancelRequest) {
+        m_platform->cancelUrlRequest(requestHandle);
     }
 
     return true;
 }
 
+void NetworkDataSource::onRequestFinish(std::shared_ptr<SharedUrlRequest> _request, UrlResponse& _response) {
+
+    std::vector<SharedUrlRequest::Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        auto it = s_requests.find(_request->key);
+        if (it != s_requests.end() && it->second == _request) {
+            s_requests.erase(it);
+        }
+        waiters = std::move(_request->waiters);
+        _request->waiters.clear();
+
+        // Keep the sources alive until their callbacks ran
+        for (auto& waiter : waiters) { waiter.source->m_activeCallbacks++; }
+    }
+
+    if (_response.error && !waiters.empty()) {
+        LOGE("Error for URL request '%s': %s", _request->key.second.c_str(), _response.error);
+    }
+
+    // All tasks share one copy of the data
+    std::shared_ptr<std::vector<char>> rawTileData;
+    if (!_response.error && !_response.content.empty()) {
+        rawTileData = std::make_shared<std::vector<char>>(std::move(_response.content));
+    }
+
+    for (auto& waiter : waiters) {
+        auto& task = waiter.task;
+
+        waiter.source->removePending(task->tileId(), false);
+
+        if (!task->isCanceled() && !_response.error) {
+            if (rawTileData) {
+                auto& dlTask = static_cast<BinaryTileTask&>(*task);
+                dlTask.rawTileData = rawTileData;
+            }
+            waiter.callback.func(task);
+        }
+
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        if (--waiter.source->m_activeCallbacks == 0) {
+            s_callbacksDone.notify_all();
+        }
+    }
+}
+
 void NetworkDataSource::removePending(const TileID& tile, bool cancelRequest) {
-    UrlRequestHandle pendingRequestToCancel = 0;
-    bool foundRequest = false;
+    std::shared_ptr<SharedUrlRequest> request;
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
             if (it->tile == tile) {
-                pendingRequestToCancel = it->request;
-                foundRequest = true;
+                request = std::move(it->request);
                 // This invalidates our iterators, so we break immediately.
                 m_pending.erase(it);
                 break;
             }
         }
     }
+    if (!cancelRequest || !request) { return; }
+
+    bool cancelUrlRequest = false;
+    {
+        std::lock_guard<std::mutex> lock(s_requestMutex);
+        auto& waiters = request->waiters;
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [&](auto& waiter) {
+                    return waiter.source == this && waiter.task->tileId() == tile;
+                }), waiters.end());
+
+        if (waiters.empty()) {
+            // No other task waits for the request.
+            auto it = s_requests.find(request->key);
+            if (it != s_requests.end() && it->second == request) {
+                s_requests.erase(it);
+                cancelUrlRequest = request->started;
+                request->canceled = true;
+            }
+        }
+    }
     // Cancelling a request will run its callback, which can call into this function again,
     // so we must perform the cancellation outside the mutex lock or we'll deadlock.
-    if (cancelRequest && foundRequest) {
-        m_platform->cancelUrlRequest(pendingRequestToCancel);
+    if (cancelUrlRequest) {
+        m_platform->cancelUrlRequest(request->handle);
     }
 }
 
@@ -8,13 +8,21 @@
 namespace Tangram {
 
 class Platform;
+struct SharedUrlRequest;
 
+/* Loads tile data from URLs of a template.
+ *
+ * Requests for the same URL on the same Platform are shared by all NetworkDataSources,
+ * one download fans out its response to every waiting TileTask.
+ */
 class NetworkDataSource : public TileSource::DataSource {
 public:
 
     NetworkDataSource(std::shared_ptr<Platform> _platform, const std::string& _urlTemplate,
             std::vector<std::string>&& _urlSubdomains, bool isTms);
 
+    ~NetworkDataSource();
+
     bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
 
     void cancelLoadingTile(const TileID& _tile) override;
@@ -23,18 +31,21 @@ private:
     // Build the URL of a tile using our URL template.
     std::string buildUrlForTile(const TileID& tile, size_t subdomainIndex) const;
 
-    // Each pending tile request is stored as a pair of TileID and UrlRequestHandle.
+    // Each pending tile request is stored as a pair of TileID and the shared URL request.
     struct TileRequest {
         TileID tile;
-        UrlRequestHandle request;
+        std::shared_ptr<SharedUrlRequest> request;
     };
 
     std::vector<TileRequest> m_pending;
 
     // Remove a pending list item with the given TileID if present, and if cancelRequest is true
-    // also cancels the corresponding URL request.
+    // also stops waiting for the URL request. The request is canceled when no tasks wait for it.
     void removePending(const TileID& tile, bool cancelRequest);
 
+    // Run the callbacks of the tasks waiting for a finished URL request
+    static void onRequestFinish(std::shared_ptr<SharedUrlRequest> _request, UrlResponse& _response);
+
     std::shared_ptr<Platform> m_platform;
 
     // URL template for requesting tiles from a network or filesystem
@@ -45,6 +56,10 @@ private:
 
     std::mutex m_mutex;
 
+    // Finished requests that are running callbacks of this source, guarded by the
+    // mutex of the shared requests. The destructor waits until it is zero.
+    int m_activeCallbacks = 0;
+
 };
 
 }
@@ -29,6 +29,12 @@ void Properties::setSorted(std::vector<Item>&& _items) {
     props = std::move(_items);
 }
 
+std::vector<Properties::Item> Properties::takeItems() {
+    std::vector<Item> items;
+    items.swap(props);
+    return items;
+}
+
 const Value& Properties::get(const std::string& key) const {
 
     const auto it = std::find_if(props.begin(), props.end(),
@@ -50,12 +56,29 @@ const Value& Properties::get(const std::string& key) const {
     return it->value;
 }
 
+const Value& Properties::get(const PropertyKey& key) const {
+
+    const auto it = std::find_if(props.begin(), props.end(),
+                                 [&](const auto& item) {
+                                     return item.key == key;
+                                 });
+    if (it == props.end()) {
+        return NOT_A_VALUE;
+    }
+
+    return it->value;
+}
+
 void Properties::clear() { props.clear(); }
 
 bool Properties::contains(const std::string& key) const {
     return !get(key).is<none_type>();
 }
 
+bool Properties::contains(const PropertyKey& key) const {
+    return !get(key).is<none_type>();
+}
+
 bool Properties::getNumber(const std::string& key, double& value) const {
     auto& it = get(key);
     if (it.is<double>()) {
@@ -159,7 +182,7 @@ std::string Properties::toJson() const {
 
     for (const auto& item : props) {
         bool last = (&item == &props.back());
-        json += "\"" + item.key + "\": \"" + asString(item.value) + (last ? "\"" : "\",");
+        json += "\"" + item.key.str() + "\": \"" + asString(item.value) + (last ? "\"" : "\",");
     }
 
     json += " }";
@@ -0,0 +1,28 @@
+#include "data/propertyKey.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace Tangram {
+
+// Returns the entry for @_key in the table of interned keys
+static const std::string* intern(const std::string& _key) {
+
+    // Elements of unordered_set keep their address when the set grows
+    static std::mutex mutex;
+    static std::unordered_set<std::string> keys;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return &*keys.insert(_key).first;
+}
+
+PropertyKey::PropertyKey() {
+    static const std::string* empty = intern("");
+    m_key = empty;
+}
+
+PropertyKey::PropertyKey(const std::string& _key) : m_key(intern(_key)) {}
+
+PropertyKey::PropertyKey(const char* _key) : m_key(intern(_key)) {}
+
+}
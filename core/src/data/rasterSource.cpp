@@ -27,7 +27,7 @@ public:
         }
     }
 
-    void process(TileBuilder& _tileBuilder) override {
+    void decode(const MapProjection& _projection) override {
 
         auto source = reinterpret_cast<RasterSource*>(m_source.get());
 
@@ -38,7 +38,7 @@ public:
 
         // Create tile geometries
         if (!isSubTask()) {
-            BinaryTileTask::process(_tileBuilder);
+            BinaryTileTask::decode(_projection);
         }
     }
 
@@ -3,6 +3,7 @@
 #include "glm/vec3.hpp"
 #include "data/properties.h"
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -34,7 +35,10 @@ Data heirarchy:
 
   A <TileData> contains a collection of <Layer>s
 
-  A <Layer> contains a name and a collection of <Feature>s
+  A <Layer> contains a name and a collection of <Feature>s. Features of a layer
+  may also be kept in their encoded form as <EncodedFeatures>, which are decoded
+  one at a time while the tile is built. The parsers store features in
+  <FeatureColumns>, with the coordinates of all features in one array.
 
   A <Feature> contains a <GeometryType> denoting what variety of geometry is
   contained in the feature, a <Properties> struct describing the feature, and
@@ -56,6 +60,8 @@ Data heirarchy:
 */
 namespace Tangram {
 
+class Arena;
+
 enum GeometryType {
     unknown,
     points,
@@ -82,6 +88,26 @@ struct Feature {
     Properties props;
 };
 
+// Features that are decoded on demand. All methods may be called
+// concurrently, for TileData that is shared by multiple TileBuilders.
+struct EncodedFeatures {
+
+    virtual ~EncodedFeatures() {}
+
+    virtual size_t size() const = 0;
+
+    // Set geometryType and properties of @_feature to those of the feature at @_index.
+    // Temporary storage for decoding is taken from @_arena.
+    virtual void decodeProperties(size_t _index, Feature& _feature, Arena& _arena) const = 0;
+
+    // Replace the points, lines and polygons of @_feature with those of the feature
+    // at @_index. @_feature must hold the properties decoded for the same feature.
+    virtual void decodeGeometry(size_t _index, Feature& _feature, Arena& _arena) const = 0;
+
+    // Bytes held by the encoded features, including the encoded data
+    virtual size_t memoryUsage() const = 0;
+};
+
 struct Layer {
 
     Layer(const std::string& _name) : name(_name) {}
@@ -90,6 +116,9 @@ struct Layer {
 
     std::vector<Feature> features;
 
+    // Features in addition to @features, may be null
+    std::shared_ptr<const EncodedFeatures> encodedFeatures;
+
 };
 
 struct TileData {
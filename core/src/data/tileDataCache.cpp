@@ -0,0 +1,145 @@
+#include "data/tileDataCache.h"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "tile/tileHash.h"
+
+namespace Tangram {
+
+size_t TileDataCache::KeyHash::operator()(const Key& _key) const {
+    std::size_t seed = 0;
+    hash_combine(seed, _key.sourceKey);
+    hash_combine(seed, _key.generation);
+    hash_combine(seed, _key.tileId);
+    return seed;
+}
+
+std::shared_ptr<TileData> TileDataCache::get(uint64_t _sourceKey, int64_t _generation, const TileID& _tileId) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Parsed data does not depend on styling zoom or wrap
+    auto it = m_cacheMap.find({ _sourceKey, _generation, TileID(_tileId.x, _tileId.y, _tileId.z) });
+    if (it == m_cacheMap.end()) { return nullptr; }
+
+    // Move cached entry to start of list
+    m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
+
+    return it->second->tileData;
+}
+
+void TileDataCache::put(uint64_t _sourceKey, int64_t _generation, const TileID& _tileId,
+                        std::shared_ptr<TileData> _tileData) {
+
+    if (!_tileData) { return; }
+
+    size_t usage = memoryUsage(*_tileData);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (usage > m_maxUsage) { return; }
+
+    Key key{ _sourceKey, _generation, TileID(_tileId.x, _tileId.y, _tileId.z) };
+
+    auto it = m_cacheMap.find(key);
+    if (it != m_cacheMap.end()) { erase(it); }
+
+    m_cacheList.push_front({ key, std::move(_tileData), usage });
+    m_cacheMap[key] = m_cacheList.begin();
+    m_usage += usage;
+
+    limitCacheSize();
+}
+
+void TileDataCache::clear(uint64_t _sourceKey) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_cacheMap.begin(); it != m_cacheMap.end();) {
+        if (it->first.sourceKey == _sourceKey) {
+            auto next = std::next(it);
+            erase(it);
+            it = next;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileDataCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_cacheMap.clear();
+    m_cacheList.clear();
+    m_usage = 0;
+}
+
+void TileDataCache::setCacheSize(size_t _cacheSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_maxUsage = _cacheSize;
+    limitCacheSize();
+}
+
+size_t TileDataCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_usage;
+}
+
+size_t TileDataCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cacheList.size();
+}
+
+void TileDataCache::limitCacheSize() {
+    while (m_usage > m_maxUsage && !m_cacheList.empty()) {
+        erase(m_cacheMap.find(m_cacheList.back().key));
+    }
+}
+
+void TileDataCache::erase(CacheMap::iterator _it) {
+    m_usage -= _it->second->usage;
+    m_cacheList.erase(_it->second);
+    m_cacheMap.erase(_it);
+}
+
+size_t TileDataCache::memoryUsage(const TileData& _tileData) {
+
+    auto lineUsage = [](const Line& _line) {
+        return sizeof(Line) + _line.capacity() * sizeof(Point);
+    };
+
+    size_t usage = sizeof(TileData);
+
+    for (const auto& layer : _tileData.layers) {
+        usage += sizeof(Layer) + layer.name.capacity();
+
+        if (layer.encodedFeatures) {
+            usage += layer.encodedFeatures->memoryUsage();
+        }
+
+        for (const auto& feature : layer.features) {
+            usage += sizeof(Feature);
+            usage += feature.points.capacity() * sizeof(Point);
+
+            for (const auto& line : feature.lines) {
+                usage += lineUsage(line);
+            }
+            for (const auto& polygon : feature.polygons) {
+                usage += sizeof(Polygon);
+                for (const auto& ring : polygon) {
+                    usage += lineUsage(ring);
+                }
+            }
+            for (const auto& item : feature.props.items()) {
+                usage += sizeof(item);
+                if (item.value.is<std::string>()) {
+                    usage += item.value.get<std::string>().capacity();
+                }
+            }
+        }
+    }
+
+    return usage;
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Tangram {
+
+struct TileData;
+
+/* Size-bounded LRU cache of parsed <TileData>.
+ *
+ * Entries are keyed by TileSource::dataKey(), TileSource::dataGeneration()
+ * and TileID, so that tiles can be rebuilt (e.g. after a change of the pixel
+ * scale, on clearTileSets() or for a reloaded scene with the same sources)
+ * without parsing their raw data again. Cached TileData is shared with the
+ * TileTasks building it and must not be modified.
+ *
+ * Thread-safe: accessed from TileWorker threads.
+ */
+class TileDataCache {
+
+    struct Key {
+        uint64_t sourceKey;
+        int64_t generation;
+        TileID tileId;
+
+        bool operator==(const Key& _rhs) const {
+            return sourceKey == _rhs.sourceKey && generation == _rhs.generation && tileId == _rhs.tileId;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& _key) const;
+    };
+
+    struct CacheEntry {
+        Key key;
+        std::shared_ptr<TileData> tileData;
+        size_t usage;
+    };
+
+    using CacheList = std::list<CacheEntry>;
+    using CacheMap = std::unordered_map<Key, CacheList::iterator, KeyHash>;
+
+public:
+
+    TileDataCache(size_t _cacheSize) : m_maxUsage(_cacheSize) {}
+
+    std::shared_ptr<TileData> get(uint64_t _sourceKey, int64_t _generation, const TileID& _tileId);
+
+    void put(uint64_t _sourceKey, int64_t _generation, const TileID& _tileId,
+             std::shared_ptr<TileData> _tileData);
+
+    /* Remove all entries of the TileSources with data key @_sourceKey */
+    void clear(uint64_t _sourceKey);
+
+    void clear();
+
+    /* @_cacheSize: Maximum memory usage of the cached TileData in bytes */
+    void setCacheSize(size_t _cacheSize);
+
+    size_t getMemoryUsage() const;
+
+    size_t getEntryCount() const;
+
+    /* Estimated memory used by @_tileData in bytes */
+    static size_t memoryUsage(const TileData& _tileData);
+
+private:
+
+    void limitCacheSize();
+
+    void erase(CacheMap::iterator _it);
+
+    mutable std::mutex m_mutex;
+
+    CacheMap m_cacheMap;
+    CacheList m_cacheList;
+
+    size_t m_usage = 0;
+    size_t m_maxUsage;
+};
+
+}
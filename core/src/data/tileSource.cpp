@@ -4,13 +4,16 @@
 #include "data/formats/mvt.h"
 #include "data/formats/topoJson.h"
 #include "data/tileData.h"
+#include "data/tileDataCache.h"
 #include "platform.h"
 #include "tile/tileID.h"
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "log.h"
 #include "util/geom.h"
+#include "util/hash.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 
@@ -25,10 +28,16 @@ TileSource::TileSource(const std::string& _name, std::unique_ptr<DataSource> _so
     static std::atomic<int32_t> s_serial;
 
     m_id = s_serial++;
+
+    updateDataKey();
 }
 
 TileSource::~TileSource() {
-    clearData();
+
+    if (m_sources) { m_sources->clear(); }
+
+    // Parsed data of a configured source remains cached for the same source of the next scene
+    if (m_tileDataCache && !m_configHash) { m_tileDataCache->clear(m_dataKey); }
 }
 
 int32_t TileSource::zoomBiasFromTileSize(int32_t tileSize) {
@@ -82,7 +91,37 @@ void TileSource::clearData() {
 
     if (m_sources) { m_sources->clear(); }
 
+    if (m_tileDataCache) { m_tileDataCache->clear(m_dataKey); }
+
     m_generation++;
+    m_dataGeneration++;
+}
+
+void TileSource::setConfigHash(uint64_t _hash) {
+    m_configHash = _hash;
+    updateDataKey();
+}
+
+void TileSource::updateDataKey() {
+
+    if (!m_configHash) {
+        m_dataKey = uint32_t(m_id);
+        return;
+    }
+
+    // The order in which scene layers add collections does not matter
+    auto collections = m_collections;
+    std::sort(collections.begin(), collections.end());
+
+    size_t seed = 0;
+    hash_combine(seed, m_name);
+    hash_combine(seed, m_configHash);
+    for (auto& collection : collections) {
+        hash_combine(seed, collection);
+    }
+
+    // Keys of configured sources have the high bit set, so that they differ from source ids
+    m_dataKey = uint64_t(seed) | (uint64_t(1) << 63);
 }
 
 void TileSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -106,12 +145,47 @@ std::shared_ptr<TileData> TileSource::parse(const TileTask& _task, const MapProj
     switch (m_format) {
     case Format::TopoJson: return TopoJson::parseTile(_task, _projection, m_id);
     case Format::GeoJson: return GeoJson::parseTile(_task, _projection, m_id);
-    case Format::Mvt: return Mvt::parseTile(_task, _projection, m_id);
+    case Format::Mvt: {
+        if (m_collections.empty()) { return Mvt::parseTile(_task, _projection, m_id); }
+
+        Mvt::SkippedLayers skipped;
+        auto tileData = Mvt::parseTile(_task, _projection, m_id, true, &m_collections, &skipped);
+
+        m_skippedLayers += skipped.layers;
+        m_skippedBytes += skipped.bytes;
+        m_skippedFeatures += skipped.features;
+        return tileData;
+    }
     }
     assert(false);
     return nullptr;
 }
 
+void TileSource::addCollections(const std::vector<std::string>& _collections) {
+    bool added = false;
+
+    for (auto& collection : _collections) {
+        if (std::find(m_collections.begin(), m_collections.end(), collection) == m_collections.end()) {
+            m_collections.push_back(collection);
+            added = true;
+        }
+    }
+
+    // TileData that was parsed without these collections is outdated
+    if (added) {
+        m_generation++;
+        updateDataKey();
+    }
+}
+
+TileSource::ParseStats TileSource::parseStats() const {
+    ParseStats stats;
+    stats.skippedLayers = m_skippedLayers;
+    stats.skippedBytes = m_skippedBytes;
+    stats.skippedFeatures = m_skippedFeatures;
+    return stats;
+}
+
 void TileSource::cancelLoadingTile(const TileID& _tileID) {
 
     if (m_sources) { return m_sources->cancelLoadingTile(_tileID); }
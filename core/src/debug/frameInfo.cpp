@@ -1,5 +1,7 @@
 #include "debug/frameInfo.h"
 
+#include "data/tileDataCache.h"
+#include "data/tileSource.h"
 #include "debug/textDisplay.h"
 #include "gl.h"
 #include "gl/glError.h"
@@ -8,6 +10,8 @@
 #include "tile/tileManager.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
+#include "tile/tileWorker.h"
 #include "view/view.h"
 
 #include <deque>
@@ -52,7 +56,8 @@ void FrameInfo::beginFrame() {
 }
 
 
-void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManager) {
+void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManager,
+                     TileWorker& _tileWorker) {
 
     if (getDebugFlag(DebugFlags::tangram_infos) || getDebugFlag(DebugFlags::tangram_stats)) {
         static int cpt = 0;
@@ -116,6 +121,43 @@ void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManag
                                  + std::to_string(features));
             debuginfos.push_back("tile cache size:"
                                  + std::to_string(_tileManager.getTileCache()->getMemoryUsage() / 1024) + "kb");
+            debuginfos.push_back("tile data cache size:"
+                                 + std::to_string(_tileManager.getTileDataCache()->getMemoryUsage() / 1024) + "kb");
+            auto& prefetch = _tileManager.getPrefetchStats();
+            debuginfos.push_back("prefetch requests/hits/misses:"
+                                 + std::to_string(prefetch.requests) + "/"
+                                 + std::to_string(prefetch.hits) + "/"
+                                 + std::to_string(prefetch.misses));
+            if (auto& diskCache = _tileManager.getTileDiskCache()) {
+                auto stats = diskCache->getStats();
+                debuginfos.push_back("tile disk cache hits/misses/writes/evictions:"
+                                     + std::to_string(stats.hits) + "/"
+                                     + std::to_string(stats.misses) + "/"
+                                     + std::to_string(stats.writes) + "/"
+                                     + std::to_string(stats.evictions));
+                // Share of built tiles that could not be stored, e.g. with labels
+                size_t built = stats.writes + stats.skipped;
+                debuginfos.push_back("tile disk cache size/skipped:"
+                                     + std::to_string(stats.size / 1024) + "kb/"
+                                     + std::to_string(built ? 100 * stats.skipped / built : 0) + "%");
+            }
+            auto workerStats = _tileWorker.getStats();
+            debuginfos.push_back("canceled builds/skipped features:"
+                                 + std::to_string(workerStats.canceledBuilds) + "/"
+                                 + std::to_string(workerStats.skippedFeatures));
+            TileSource::ParseStats parseStats;
+            for (auto& tileSet : _tileManager.getTileSets()) {
+                auto stats = tileSet.source->parseStats();
+                parseStats.skippedLayers += stats.skippedLayers;
+                parseStats.skippedBytes += stats.skippedBytes;
+                parseStats.skippedFeatures += stats.skippedFeatures;
+            }
+            debuginfos.push_back("skipped layers/features/size:"
+                                 + std::to_string(parseStats.skippedLayers) + "/"
+                                 + std::to_string(parseStats.skippedFeatures) + "/"
+                                 + std::to_string(parseStats.skippedBytes / 1024) + "kb");
+            debuginfos.push_back("tile build arena peak/frame:"
+                                 + std::to_string(workerStats.peakArenaSize / 1024) + "kb");
             debuginfos.push_back("tile size:" + std::to_string(memused / 1024) + "kb");
             debuginfos.push_back("avg frame cpu time:" + to_string_with_precision(avgTimeCpu, 2) + "ms");
             debuginfos.push_back("avg frame render time:" + to_string_with_precision(avgTimeRender, 2) + "ms");
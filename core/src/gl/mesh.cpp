@@ -283,4 +283,19 @@ void MeshBase::setDirty(GLintptr _byteOffset, GLsizei _byteSize) {
     }
 }
 
+void RawMesh::compile(std::vector<std::pair<uint32_t, uint32_t>> _offsets,
+                      GLbyte* _vertices, size_t _nVertices,
+                      GLushort* _indices, size_t _nIndices) {
+
+    m_vertexOffsets = std::move(_offsets);
+
+    m_glVertexData = _vertices;
+    m_nVertices = _nVertices;
+
+    m_glIndexData = _indices;
+    m_nIndices = _nIndices;
+
+    m_isCompiled = true;
+}
+
 }
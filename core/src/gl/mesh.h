@@ -74,6 +74,18 @@ public:
 
     size_t bufferSize() const;
 
+    /* Compiled vertex and index data; only available until the mesh is uploaded */
+    const GLbyte* compiledVertices() const { return m_glVertexData; }
+    const GLushort* compiledIndices() const { return m_glIndexData; }
+
+    size_t vertexCount() const { return m_nVertices; }
+    size_t indexCount() const { return m_nIndices; }
+
+    /* Number of indices and vertices of each draw call */
+    const auto& vertexOffsets() const { return m_vertexOffsets; }
+
+    GLenum drawMode() const { return m_drawMode; }
+
 protected:
 
     // Used in draw for legth and offsets: sumIndices, sumVertices
@@ -152,6 +164,8 @@ public:
         return MeshBase::draw(rs, shader, useVao);
     }
 
+    const MeshBase* compiledMesh() const override { return this; }
+
     void compile(const std::vector<MeshData<T>>& _meshes);
 
     void compile(const MeshData<T>& _mesh);
@@ -172,6 +186,34 @@ public:
                          size_t _attribOffset = 0);
 };
 
+/*
+ * RawMesh - Mesh of already compiled vertex and index data, e.g. restored
+ * from the <TileDiskCache>
+ */
+class RawMesh : public StyledMesh, protected MeshBase {
+public:
+
+    RawMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode)
+        : MeshBase(_vertexLayout, _drawMode) {}
+
+    size_t bufferSize() const override {
+        return MeshBase::bufferSize();
+    }
+
+    bool draw(RenderState& rs, ShaderProgram& shader, bool useVao = true) override {
+        return MeshBase::draw(rs, shader, useVao);
+    }
+
+    const MeshBase* compiledMesh() const override { return this; }
+
+    /*
+     * Takes ownership of _vertices and _indices, which must be allocated
+     * with new[]; _offsets are the draw calls as in <vertexOffsets()>
+     */
+    void compile(std::vector<std::pair<uint32_t, uint32_t>> _offsets,
+                 GLbyte* _vertices, size_t _nVertices,
+                 GLushort* _indices, size_t _nIndices);
+};
 
 template<class T>
 void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
@@ -1,6 +1,8 @@
 #include "map.h"
 
 #include "data/clientGeoJsonSource.h"
+#include "data/mbtilesDataSource.h"
+#include "data/tileDataCache.h"
 #include "debug/textDisplay.h"
 #include "debug/frameInfo.h"
 #include "gl.h"
@@ -22,6 +24,7 @@
 #include "text/fontContext.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
 #include "tile/tileManager.h"
 #include "util/asyncWorker.h"
 #include "util/fastmap.h"
@@ -36,6 +39,7 @@
 namespace Tangram {
 
 const static size_t MAX_WORKERS = 2;
+const static size_t MAX_DECODERS = 1;
 
 enum class EaseField { position, zoom, rotation, tilt };
 
@@ -46,7 +50,7 @@ public:
         platform(_platform),
         inputHandler(_platform, view),
         scene(std::make_shared<Scene>(_platform, Url())),
-        tileWorker(_platform, MAX_WORKERS),
+        tileWorker(_platform, MAX_WORKERS, MAX_DECODERS),
         tileManager(_platform, tileWorker) {}
 
     void setScene(std::shared_ptr<Scene>& _scene);
@@ -61,6 +65,9 @@ public:
 
     void setPixelScale(float _pixelsPerPoint);
 
+    // Predict the view in 'prefetchHorizon' seconds, returns false when the view is not moving
+    bool updatePrefetchView(float _dt);
+
     std::mutex tilesMutex;
     std::mutex sceneMutex;
 
@@ -90,6 +97,14 @@ public:
     bool cacheGlState = false;
     float pickRadius = .5f;
 
+    // Tile prefetching, see Map::setTilePrefetch()
+    float prefetchHorizon = 0.f;
+    View prefetchView;
+    glm::dvec2 lastPosition;
+    float lastZoom = 0.f;
+    glm::dvec2 positionEaseTarget;
+    float zoomEaseTarget = 0.f;
+
     std::vector<SelectionQuery> selectionQueries;
 
     SceneReadyCallback onSceneReady = nullptr;
@@ -174,6 +189,10 @@ void Map::Impl::setScene(std::shared_ptr<Scene>& _scene) {
     }
 
     inputHandler.setView(view);
+
+    if (auto& diskCache = tileManager.getTileDiskCache()) {
+        diskCache->setScene(_scene);
+    }
     tileManager.setTileSources(_scene->tileSources());
     tileWorker.setScene(_scene);
     markerManager.setScene(_scene);
@@ -417,6 +436,8 @@ bool Map::update(float _dt) {
 
     impl->view.update();
 
+    bool prefetch = impl->prefetchHorizon > 0.f && impl->updatePrefetchView(_dt);
+
     bool markersChanged = impl->markerManager.update(impl->view, _dt);
 
     for (const auto& style : impl->scene->styles()) {
@@ -426,7 +447,7 @@ bool Map::update(float _dt) {
     {
         std::lock_guard<std::mutex> lock(impl->tilesMutex);
 
-        impl->tileManager.updateTileSets(impl->view);
+        impl->tileManager.updateTileSets(impl->view, prefetch ? &impl->prefetchView : nullptr);
 
         auto& tiles = impl->tileManager.getVisibleTiles();
         auto& markers = impl->markerManager.markers();
@@ -468,6 +489,94 @@ void Map::setPickRadius(float _radius) {
     impl->pickRadius = _radius;
 }
 
+void Map::setTilePrefetch(float _horizon, size_t _budget) {
+    impl->prefetchHorizon = _horizon;
+    impl->tileManager.setPrefetchBudget(_budget);
+}
+
+void Map::setTileDecoders(int _threads) {
+    impl->tileWorker.setDecoders(_threads);
+}
+
+void Map::setTileBuilderThreads(int _threads) {
+    impl->tileWorker.setBuilderConcurrency(_threads);
+}
+
+void Map::setTileCachePolicy(TileCachePolicyType _policy) {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    switch (_policy) {
+    case TileCachePolicyType::lru:
+        impl->tileManager.setCachePolicy(std::make_unique<LRUTileCachePolicy>());
+        break;
+    case TileCachePolicyType::greedyDualSize:
+        impl->tileManager.setCachePolicy(std::make_unique<GreedyDualSizeTileCachePolicy>());
+        break;
+    }
+}
+
+void Map::setTileDiskCache(const std::string& _path, uint64_t _maxSize) {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    std::shared_ptr<TileDiskCache> diskCache;
+    if (!_path.empty()) {
+        diskCache = std::make_shared<TileDiskCache>(_path, _maxSize);
+        diskCache->setScene(impl->scene);
+    }
+    impl->tileManager.setTileDiskCache(diskCache);
+
+    platform->requestRender();
+}
+
+bool Map::Impl::updatePrefetchView(float _dt) {
+
+    glm::dvec2 position(view.getPosition());
+    float zoom = view.getZoom();
+
+    glm::dvec2 velocity(0.0);
+    float zoomVelocity = 0.f;
+
+    if (_dt > 0.f) {
+        velocity = (position - lastPosition) / double(_dt);
+        zoomVelocity = (zoom - lastZoom) / _dt;
+    }
+
+    lastPosition = position;
+    lastZoom = zoom;
+
+    glm::dvec2 predictedPosition = position + velocity * double(prefetchHorizon);
+    float predictedZoom = zoom + zoomVelocity * prefetchHorizon;
+
+    // Eases that end within the horizon will stop at their target
+    auto& positionEase = eases[static_cast<size_t>(EaseField::position)];
+    if (!positionEase.finished() && positionEase.d - positionEase.t <= prefetchHorizon) {
+        predictedPosition = positionEaseTarget;
+    }
+    auto& zoomEase = eases[static_cast<size_t>(EaseField::zoom)];
+    if (!zoomEase.finished() && zoomEase.d - zoomEase.t <= prefetchHorizon) {
+        predictedZoom = zoomEaseTarget;
+    }
+
+    // Skip predictions more than one viewport ahead, e.g. from the apparent
+    // velocity of a jump to a new position. Limit zoom to one level ahead.
+    double maxDistance = std::fmax(view.getWidth(), view.getHeight()) / view.pixelsPerMeter() / view.pixelScale();
+    glm::dvec2 offset = predictedPosition - position;
+    double distance = glm::length(offset);
+    if (distance > maxDistance) {
+        return false;
+    }
+    predictedZoom = glm::clamp(predictedZoom, zoom - 1.f, zoom + 1.f);
+
+    if (distance == 0.0 && predictedZoom == zoom) { return false; }
+
+    prefetchView = view;
+    prefetchView.setPosition(predictedPosition);
+    prefetchView.setZoom(predictedZoom);
+    prefetchView.update();
+
+    return true;
+}
+
 void Map::pickFeatureAt(float _x, float _y, FeaturePickCallback _onFeaturePickCallback) {
     impl->selectionQueries.push_back({{_x, _y}, impl->pickRadius, _onFeaturePickCallback});
 
@@ -543,7 +652,7 @@ void Map::render() {
 
     if (drawSelectionBuffer) {
         impl->selectionBuffer->drawDebug(impl->renderState, viewport);
-        FrameInfo::draw(impl->renderState, impl->view, impl->tileManager);
+        FrameInfo::draw(impl->renderState, impl->view, impl->tileManager, impl->tileWorker);
         return;
     }
 
@@ -563,7 +672,7 @@ void Map::render() {
 
     impl->labels.drawDebug(impl->renderState, impl->view);
 
-    FrameInfo::draw(impl->renderState, impl->view, impl->tileManager);
+    FrameInfo::draw(impl->renderState, impl->view, impl->tileManager, impl->tileWorker);
 }
 
 int Map::getViewportHeight() {
@@ -602,6 +711,7 @@ void Map::setPositionEased(double _lon, double _lat, float _duration, EaseType _
 
     double lon_start, lat_start;
     getPosition(lon_start, lat_start);
+    impl->positionEaseTarget = impl->view.getMapProjection().LonLatToMeters({ _lon, _lat });
     auto cb = [=](float t) { impl->setPositionNow(ease(lon_start, _lon, t, _e), ease(lat_start, _lat, t, _e)); };
     impl->setEase(EaseField::position, { _duration, cb });
 
@@ -634,6 +744,7 @@ void Map::setZoom(float _z) {
 void Map::setZoomEased(float _z, float _duration, EaseType _e) {
 
     float z_start = getZoom();
+    impl->zoomEaseTarget = _z;
     auto cb = [=](float t) { impl->setZoomNow(ease(z_start, _z, t, _e)); };
     impl->setEase(EaseField::zoom, { _duration, cb });
 
@@ -791,6 +902,43 @@ void Map::clearTileSource(TileSource& _source, bool _data, bool _tiles) {
     platform->requestRender();
 }
 
+// Returns the MBTiles tile cache in the data sources of the tile source named _sourceName,
+// call with tilesMutex held
+static MBTilesDataSource* findTileCache(TileManager& _tileManager, const std::string& _sourceName) {
+    for (auto& tileSet : _tileManager.getTileSets()) {
+        if (tileSet.source->name() != _sourceName) { continue; }
+
+        for (auto* source = tileSet.source->dataSources(); source; source = source->next.get()) {
+            auto* mbtiles = dynamic_cast<MBTilesDataSource*>(source);
+            if (mbtiles && mbtiles->isCache()) { return mbtiles; }
+        }
+    }
+    return nullptr;
+}
+
+bool Map::setTileCacheSize(const std::string& _sourceName, uint64_t _bytes) {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    auto* cache = findTileCache(impl->tileManager, _sourceName);
+    if (!cache) { return false; }
+
+    cache->setCacheSize(_bytes);
+    return true;
+}
+
+bool Map::getTileCacheStats(const std::string& _sourceName, TileCacheStats& _stats) {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    auto* cache = findTileCache(impl->tileManager, _sourceName);
+    if (!cache) { return false; }
+
+    auto stats = cache->getStats();
+    _stats.hits = stats.hits;
+    _stats.misses = stats.misses;
+    _stats.size = stats.size;
+    return true;
+}
+
 MarkerID Map::markerAdd() {
     return impl->markerManager.add();
 }
@@ -944,6 +1092,8 @@ void Map::onMemoryWarning() {
         tileCache->clear();
     }
 
+    impl->tileManager.getTileDataCache()->clear();
+
     for (auto& tileSet : impl->tileManager.getTileSets()) {
         tileSet.source->clearData();
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/propertyKey.h"
 #include "util/variant.h"
 
 #include <memory>
@@ -28,24 +29,24 @@ struct Filter {
     };
 
     struct EqualitySet {
-        std::string key;
+        PropertyKey key;
         std::vector<Value> values;
         FilterKeyword keyword;
     };
     struct Equality {
-        std::string key;
+        PropertyKey key;
         Value value;
         FilterKeyword keyword;
     };
     struct Range {
-        std::string key;
+        PropertyKey key;
         float min;
         float max;
         FilterKeyword keyword;
         bool hasPixelArea;
     };
     struct Existence {
-        std::string key;
+        PropertyKey key;
         bool exists;
     };
     struct Function {
@@ -29,6 +29,7 @@
 #include "scene/styleParam.h"
 #include "util/base64.h"
 #include "util/floatFormatter.h"
+#include "util/hash.h"
 #include "util/yamlHelper.h"
 #include "view/view.h"
 
@@ -1011,6 +1012,16 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
         getBool(tmsNode, isTms);
     }
 
+    // MBTiles database that stores the tiles of a network source, and its maximum size in megabytes
+    std::string cachePath;
+    uint64_t cacheSize = 0;
+    if (auto cacheNode = source["cache"]) {
+        cachePath = cacheNode.Scalar();
+    }
+    if (auto cacheSizeNode = source["cache_size"]) {
+        cacheSize = uint64_t(cacheSizeNode.as<uint32_t>(0)) * 1024 * 1024;
+    }
+
     auto rawSources = std::make_unique<MemoryCacheDataSource>();
     rawSources->setCacheSize(CACHE_SIZE);
 
@@ -1020,7 +1031,19 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
         // Create an MBTiles data source from the file at the url and add it to the source chain.
         rawSources->setNext(std::make_unique<MBTilesDataSource>(platform, name, url, ""));
     } else if (tiled) {
-        rawSources->setNext(std::make_unique<NetworkDataSource>(platform, url, std::move(subdomains), isTms));
+        auto networkSource = std::make_unique<NetworkDataSource>(platform, url, std::move(subdomains), isTms);
+
+        if (!cachePath.empty()) {
+            // Load tiles from the cache and store downloaded tiles in it
+            auto cacheSource = std::make_unique<MBTilesDataSource>(platform, name, cachePath, "", true);
+            cacheSource->setCacheSize(cacheSize);
+
+            auto& cache = *cacheSource;
+            rawSources->setNext(std::move(cacheSource));
+            cache.setNext(std::move(networkSource));
+        } else {
+            rawSources->setNext(std::move(networkSource));
+        }
     }
 
     std::shared_ptr<TileSource> sourcePtr;
@@ -1058,6 +1081,11 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
                 "This source will be ignored.", name.c_str());
             return;
         }
+
+        // Share parsed tile data with the same source of a reloaded scene
+        size_t configHash = 0;
+        hash_combine(configHash, YAML::Dump(source));
+        sourcePtr->setConfigHash(configHash);
     }
 
     _scene->tileSources().push_back(sourcePtr);
@@ -1718,13 +1746,14 @@ void SceneLoader::loadLayer(const std::pair<Node, Node>& layer, const std::share
     const std::string& name = layer.first.Scalar();
 
     std::string source;
+    std::shared_ptr<TileSource> dataSource;
     std::vector<std::string> collections;
 
     if (Node data = layer.second["data"]) {
         if (Node data_source = data["source"]) {
             if (data_source.IsScalar()) {
                 source = data_source.Scalar();
-                auto dataSource = scene->getTileSource(source);
+                dataSource = scene->getTileSource(source);
                 if (dataSource) {
                     dataSource->generateGeometry(true);
                 } else {
@@ -1746,6 +1775,9 @@ void SceneLoader::loadLayer(const std::pair<Node, Node>& layer, const std::share
         collections.push_back(name);
     }
 
+    // Other layers of the source are skipped when parsing its tiles
+    if (dataSource) { dataSource->addCollections(collections); }
+
     auto sublayer = loadSublayer(layer.second, name, scene);
 
     scene->layers().push_back({ std::move(sublayer), source, collections });
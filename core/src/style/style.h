@@ -28,6 +28,7 @@ class TileSource;
 class VertexLayout;
 class View;
 struct DrawRule;
+struct MeshBase;
 struct LightUniforms;
 struct MaterialUniforms;
 
@@ -57,6 +58,10 @@ struct StyledMesh {
     virtual bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) = 0;
     virtual size_t bufferSize() const = 0;
 
+    /* Compiled geometry of this mesh, nullptr when the mesh depends on
+     * runtime state and can not be stored (e.g. labels and their glyphs) */
+    virtual const MeshBase* compiledMesh() const { return nullptr; }
+
     virtual ~StyledMesh() {}
 };
 
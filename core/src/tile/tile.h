@@ -92,6 +92,11 @@ public:
     /* Get the sum in bytes of static <Mesh>es */
     size_t getMemoryUsage() const;
 
+    /* Time in milliseconds it took to decode and build this tile */
+    float getBuildTime() const { return m_buildTime; }
+
+    void setBuildTime(float _buildTime) { m_buildTime = _buildTime; }
+
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
     int32_t sourceID() const { return m_sourceId; }
@@ -133,6 +138,8 @@ private:
 
     mutable size_t m_memoryUsage = 0;
 
+    float m_buildTime = 0;
+
     fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
 
 };
@@ -10,13 +10,53 @@
 #include "selection/featureSelection.h"
 #include "style/style.h"
 #include "tile/tile.h"
+#include "util/asyncWorker.h"
 #include "util/mapProjection.h"
 #include "view/view.h"
 
+#include <condition_variable>
+#include <mutex>
+
+// Number of features that are styled before the queued
+// features are passed to the StyleBuilders
+#define STYLE_BATCH_SIZE 256
+
+// Memory the arena keeps between builds, larger
+// blocks needed by a single build are released
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_CAPACITY (1024 * 1024)
+
 namespace Tangram {
 
+TileBuilder::StyleCommand::StyleCommand(const DrawRule& _rule, size_t _feature, bool _selectable,
+                                        Arena& _arena)
+    : rule(_rule), evaluated(ArenaAllocator<StyleParam>(&_arena)),
+      feature(_feature), selectable(_selectable), added(false) {
+
+    // Evaluated parameters keep the function or stops they were evaluated from
+    auto isEvaluated = [&](size_t i) {
+        return rule.active[i] && (rule.params[i].param->function >= 0 || rule.params[i].param->stops);
+    };
+
+    size_t count = 0;
+    for (size_t i = 0; i < StyleParamKeySize; i++) {
+        if (isEvaluated(i)) { count++; }
+    }
+
+    // Reserve all space up front: rule.params point into 'evaluated'
+    evaluated.reserve(count);
+
+    for (size_t i = 0; i < StyleParamKeySize; i++) {
+        if (isEvaluated(i)) {
+            evaluated.push_back(*rule.params[i].param);
+            rule.params[i].param = &evaluated.back();
+        }
+    }
+}
+
 TileBuilder::TileBuilder(std::shared_ptr<Scene> _scene)
-    : m_scene(_scene) {
+    : m_scene(_scene),
+      m_arena(ARENA_BLOCK_SIZE, ARENA_MAX_CAPACITY) {
 
     m_styleContext.initFunctions(*_scene);
 
@@ -28,6 +68,15 @@ TileBuilder::TileBuilder(std::shared_ptr<Scene> _scene)
 
 TileBuilder::~TileBuilder() {}
 
+void TileBuilder::setConcurrency(int _threads) {
+    m_concurrency = std::max(1, _threads);
+
+    m_helpers.resize(m_concurrency - 1);
+    for (auto& helper : m_helpers) {
+        if (!helper) { helper = std::make_unique<AsyncWorker>(); }
+    }
+}
+
 StyleBuilder* TileBuilder::getStyleBuilder(const std::string& _name) {
     auto it = m_styleBuilder.find(_name);
     if (it == m_styleBuilder.end()) { return nullptr; }
@@ -40,8 +89,29 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
     // If no rules matched the feature, return immediately
     if (!m_ruleSet.match(_feature, _layer, m_styleContext)) { return; }
 
+    applyMatchedRules(_feature);
+}
+
+void TileBuilder::applyStyling(const EncodedFeatures& _features, size_t _index, const SceneLayer& _layer) {
+
+    // Queued features keep their slot until the batch is built
+    auto& feature = m_decodedFeatures[m_styledFeatures.size()];
+
+    _features.decodeProperties(_index, feature, m_arena);
+
+    if (!m_ruleSet.match(feature, _layer, m_styleContext)) { return; }
+
+    // Only the geometry of matched features is decoded
+    _features.decodeGeometry(_index, feature, m_arena);
+
+    applyMatchedRules(feature);
+}
+
+void TileBuilder::applyMatchedRules(const Feature& _feature) {
+
     uint32_t selectionColor = 0;
     bool added = false;
+    bool deferred = m_concurrency > 1;
 
     // For each matched rule, find the style to be used and
     // build the feature with the rule's parameters
@@ -81,13 +151,27 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
                 LOGN("Invalid style %s", styleName.c_str());
             } else {
                 rule.isOutlineOnly = true;
-                outlineStyle->addFeature(_feature, rule);
+                if (deferred) {
+                    queueFeature(*outlineStyle, rule, false);
+                } else {
+                    outlineStyle->addFeature(_feature, rule);
+                }
                 rule.isOutlineOnly = false;
             }
         }
 
         // build feature with style
-        added |= style->addFeature(_feature, rule);
+        if (deferred) {
+            queueFeature(*style, rule, true);
+        } else {
+            added |= style->addFeature(_feature, rule);
+        }
+    }
+
+    if (deferred) {
+        // Selection color is known once all rules were applied
+        m_styledFeatures.push_back({ &_feature, selectionColor });
+        return;
     }
 
     if (added && (selectionColor != 0)) {
@@ -95,9 +179,98 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
     }
 }
 
-std::shared_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source) {
+void TileBuilder::queueFeature(StyleBuilder& _builder, const DrawRule& _rule, bool _selectable) {
+    m_styleQueues[&_builder].emplace_back(_rule, m_styledFeatures.size(), _selectable, m_arena);
+}
+
+void TileBuilder::buildStyledFeatures() {
+
+    using StyleQueue = std::pair<StyleBuilder* const, std::vector<StyleCommand>>;
+
+    ArenaAllocator<StyleQueue*> alloc(&m_arena);
+
+    ArenaVector<StyleQueue*> queues(alloc);
+    for (auto& queue : m_styleQueues) {
+        if (!queue.second.empty()) { queues.push_back(&queue); }
+    }
+
+    // Distribute StyleBuilders over threads, largest queues first
+    std::sort(queues.begin(), queues.end(), [](auto* a, auto* b) {
+            return a->second.size() > b->second.size();
+        });
+
+    size_t numPartitions = std::min(queues.size(), size_t(m_concurrency));
+    ArenaVector<ArenaVector<StyleQueue*>> partitions(numPartitions, ArenaVector<StyleQueue*>(alloc), alloc);
+    ArenaVector<size_t> load(numPartitions, 0, alloc);
+
+    for (auto* queue : queues) {
+        size_t p = std::min_element(load.begin(), load.end()) - load.begin();
+        partitions[p].push_back(queue);
+        load[p] += queue->second.size();
+    }
+
+    auto run = [this](const ArenaVector<StyleQueue*>& _partition) {
+        for (auto* queue : _partition) {
+            for (auto& command : queue->second) {
+                if (isCanceled()) { return; }
+
+                auto& feature = *m_styledFeatures[command.feature].feature;
+                command.added = queue->first->addFeature(feature, command.rule);
+            }
+        }
+    };
+
+    // The first partition is run on this thread, the others by the helpers
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t pending = numPartitions > 0 ? numPartitions - 1 : 0;
+
+    for (size_t i = 1; i < numPartitions; i++) {
+        m_helpers[i - 1]->enqueue([&, i]() {
+            run(partitions[i]);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) { finished.notify_one(); }
+        });
+    }
+    if (numPartitions > 0) { run(partitions[0]); }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]{ return pending == 0; });
+    }
+
+    for (auto& queue : m_styleQueues) {
+        for (auto& command : queue.second) {
+            auto& styled = m_styledFeatures[command.feature];
+
+            if (command.added && command.selectable && styled.selectionColor != 0) {
+                auto& props = m_selectionFeatures[styled.selectionColor];
+                if (!props) { props = std::make_shared<Properties>(styled.feature->props); }
+            }
+        }
+        queue.second.clear();
+    }
+
+    m_styledFeatures.clear();
+}
+
+TileBuilder::Stats TileBuilder::takeStats() {
+    Stats stats = m_stats;
+    m_stats = Stats();
+    return stats;
+}
+
+std::shared_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source,
+                                         const std::atomic<bool>* _canceled) {
+
+    m_canceled = _canceled;
 
     m_selectionFeatures.clear();
+    m_styledFeatures.clear();
+    m_decodedFeatures.resize(m_concurrency > 1 ? STYLE_BATCH_SIZE : 1);
+    for (auto& queue : m_styleQueues) { queue.second.clear(); }
+    m_arena.reset();
 
     auto tile = std::make_shared<Tile>(_tileID, *m_scene->mapProjection(), &_source);
 
@@ -110,6 +283,9 @@ std::shared_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileDa
             builder.second->setup(*tile);
     }
 
+    size_t numFeatures = 0;
+    size_t styledFeatures = 0;
+
     for (const auto& datalayer : m_scene->layers()) {
 
         if (datalayer.source() != _source.name()) { continue; }
@@ -124,12 +300,55 @@ std::shared_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileDa
                 if (!layerContainsCollection) { continue; }
             }
 
+            numFeatures += collection.features.size();
+
             for (const auto& feat : collection.features) {
+                if (isCanceled()) { break; }
+
                 applyStyling(feat, datalayer);
+                styledFeatures++;
+
+                if (m_styledFeatures.size() >= STYLE_BATCH_SIZE) {
+                    buildStyledFeatures();
+                }
+            }
+
+            if (!collection.encodedFeatures) { continue; }
+
+            const auto& encoded = *collection.encodedFeatures;
+            numFeatures += encoded.size();
+
+            for (size_t i = 0; i < encoded.size(); i++) {
+                if (isCanceled()) { break; }
+
+                applyStyling(encoded, i, datalayer);
+                styledFeatures++;
+
+                if (m_styledFeatures.size() >= STYLE_BATCH_SIZE) {
+                    buildStyledFeatures();
+                }
             }
         }
     }
 
+    if (!m_styledFeatures.empty() && !isCanceled()) {
+        buildStyledFeatures();
+    }
+
+    if (isCanceled()) {
+        // Drop the geometry built so far, the StyleBuilders are reused
+        for (auto& builder : m_styleBuilder) {
+            builder.second->build();
+        }
+
+        m_stats.canceled++;
+        m_stats.skippedFeatures += numFeatures - styledFeatures;
+        m_stats.peakArenaSize = std::max(m_stats.peakArenaSize, m_arena.peakSize());
+
+        m_canceled = nullptr;
+        return nullptr;
+    }
+
     for (auto& builder : m_styleBuilder) {
 
         builder.second->addLayoutItems(m_labelLayout);
@@ -145,6 +364,9 @@ std::shared_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileDa
 
     tile->setSelectionFeatures(m_selectionFeatures);
 
+    m_stats.peakArenaSize = std::max(m_stats.peakArenaSize, m_arena.peakSize());
+
+    m_canceled = nullptr;
     return tile;
 }
 
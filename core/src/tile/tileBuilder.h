@@ -1,19 +1,26 @@
 #pragma once
 
+#include "data/tileData.h"
 #include "data/tileSource.h"
 #include "labels/labelCollider.h"
 #include "scene/styleContext.h"
 #include "scene/drawRule.h"
+#include "util/arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace Tangram {
 
+class AsyncWorker;
 class DataLayer;
 class StyleBuilder;
 class Tile;
 class TileSource;
-struct Feature;
 struct Properties;
-struct TileData;
 
 class TileBuilder {
 
@@ -25,15 +32,75 @@ public:
 
     StyleBuilder* getStyleBuilder(const std::string& _name);
 
-    std::shared_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source);
+    struct Stats {
+        // Builds that stopped early because they were canceled
+        size_t canceled = 0;
+        // Features of canceled builds that were not styled
+        size_t skippedFeatures = 0;
+        // Largest arena used by a single build
+        size_t peakArenaSize = 0;
+    };
+
+    /* Build the Tile for @_data. When @_canceled is set while building, the
+     * build stops at the next data layer or feature and returns nullptr. */
+    std::shared_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source,
+                                const std::atomic<bool>* _canceled = nullptr);
+
+    /* Returns the Stats of the builds since the last call and resets them */
+    Stats takeStats();
 
     const Scene& scene() const { return *m_scene; }
 
+    /* Set the number of threads used to build the geometry of a tile.
+     * With more than one thread, DrawRules are still matched and evaluated
+     * on the calling thread while the StyleBuilders run concurrently on the
+     * styled features. Each StyleBuilder is run by a single thread, so
+     * the resulting meshes do not depend on the number of threads. The
+     * helper threads are started here and kept for all following builds. */
+    void setConcurrency(int _threads);
+
+    int concurrency() const { return m_concurrency; }
+
 private:
 
+    // A matched feature whose styled geometry is not built yet
+    struct StyledFeature {
+        const Feature* feature;
+        uint32_t selectionColor;
+    };
+
+    // A DrawRule queued for a StyleBuilder. Evaluated parameters are
+    // copied since DrawRuleMergeSet reuses them for the next rule.
+    struct StyleCommand {
+        DrawRule rule;
+        ArenaVector<StyleParam> evaluated;
+        size_t feature;
+        bool selectable;
+        bool added;
+
+        StyleCommand(const DrawRule& _rule, size_t _feature, bool _selectable, Arena& _arena);
+    };
+
     // Determine and apply DrawRules for a @_feature
     void applyStyling(const Feature& _feature, const SceneLayer& _layer);
 
+    // Determine and apply DrawRules for the encoded feature at @_index
+    void applyStyling(const EncodedFeatures& _features, size_t _index, const SceneLayer& _layer);
+
+    // Apply the DrawRules that matched @_feature
+    void applyMatchedRules(const Feature& _feature);
+
+    // Queue @_rule for the current feature to be built by @_builder
+    void queueFeature(StyleBuilder& _builder, const DrawRule& _rule, bool _selectable);
+
+    // Run the StyleBuilders on all queued features
+    void buildStyledFeatures();
+
+    // Whether the current build was canceled
+    bool isCanceled() const {
+        return m_canceled && m_canceled->load(std::memory_order_relaxed);
+    }
+
     std::shared_ptr<Scene> m_scene;
 
     StyleContext m_styleContext;
@@ -44,6 +111,27 @@ private:
     fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilder;
 
     fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
+
+    int m_concurrency = 1;
+
+    // Threads that run StyleBuilders besides the building thread
+    std::vector<std::unique_ptr<AsyncWorker>> m_helpers;
+
+    // Cancel flag of the current build
+    const std::atomic<bool>* m_canceled = nullptr;
+
+    Stats m_stats;
+
+    // Memory that is only used while building a tile, reset and trimmed
+    // for each build. Declared before the containers that take memory from it.
+    Arena m_arena;
+
+    std::vector<StyledFeature> m_styledFeatures;
+    std::unordered_map<StyleBuilder*, std::vector<StyleCommand>> m_styleQueues;
+
+    // Reused storage for features decoded from EncodedFeatures,
+    // one for each feature of a batch of StyledFeatures
+    std::vector<Feature> m_decodedFeatures;
 };
 
 }
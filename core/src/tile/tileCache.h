@@ -2,53 +2,56 @@
 
 #include "log.h"
 #include "tile/tile.h"
-#include "tile/tileHash.h"
+#include "tile/tileCachePolicy.h"
 #include "tile/tileID.h"
 
-#include <list>
 #include <memory>
 #include <unordered_map>
 
-namespace Tangram {
-// TileSet serial + TileID
-using TileCacheKey = std::pair<int32_t, TileID>;
-}
-
-namespace std {
-    template <>
-    struct hash<Tangram::TileCacheKey> {
-        size_t operator()(const Tangram::TileCacheKey& k) const {
-            std::size_t seed = 0;
-            hash_combine(seed, k.first);
-            hash_combine(seed, k.second);
-            return seed;
-        }
-    };
-}
-
 namespace Tangram {
 
 class TileCache {
     struct CacheEntry {
-        TileCacheKey key;
         std::shared_ptr<Tile> tile;
+        size_t usage;
     };
 
-    using CacheList = std::list<CacheEntry>;
-    using CacheMap = std::unordered_map<TileCacheKey, typename CacheList::iterator>;
+    using CacheMap = std::unordered_map<TileCacheKey, CacheEntry>;
 
 public:
 
-    TileCache(size_t _cacheSizeMB) :
+    TileCache(size_t _cacheSizeMB, std::unique_ptr<TileCachePolicy> _policy = nullptr) :
         m_cacheUsage(0),
-        m_cacheMaxUsage(_cacheSizeMB) {}
+        m_cacheMaxUsage(_cacheSizeMB),
+        m_policy(std::move(_policy)) {
+
+        if (!m_policy) { m_policy = std::make_unique<LRUTileCachePolicy>(); }
+    }
+
+    /* Replace the replacement policy, cached tiles are passed to the new policy */
+    void setPolicy(std::unique_ptr<TileCachePolicy> _policy) {
+        m_policy = std::move(_policy);
+
+        for (auto& entry : m_cacheMap) {
+            m_policy->insert(entry.first, entry.second.usage, entry.second.tile->getBuildTime());
+        }
+    }
+
+    TileCachePolicy& policy() { return *m_policy; }
 
     std::vector<TileID> put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
         TileCacheKey k(_sourceId, _tile->getID());
 
-        m_cacheList.push_front({k, _tile});
-        m_cacheMap[k] = m_cacheList.begin();
-        m_cacheUsage += _tile->getMemoryUsage();
+        auto it = m_cacheMap.find(k);
+        if (it != m_cacheMap.end()) {
+            m_cacheUsage -= it->second.usage;
+            m_policy->remove(k);
+        }
+
+        size_t usage = _tile->getMemoryUsage();
+        m_policy->insert(k, usage, _tile->getBuildTime());
+        m_cacheMap[k] = { std::move(_tile), usage };
+        m_cacheUsage += usage;
 
         return limitCacheSize(m_cacheMaxUsage);
     }
@@ -59,10 +62,10 @@ public:
 
         auto it = m_cacheMap.find(k);
         if (it != m_cacheMap.end()) {
-            std::swap(tile, (*(it->second)).tile);
-            m_cacheList.erase(it->second);
+            std::swap(tile, it->second.tile);
+            m_cacheUsage -= it->second.usage;
             m_cacheMap.erase(it);
-            m_cacheUsage -= tile->getMemoryUsage();
+            m_policy->remove(k);
         }
         return tile;
     }
@@ -73,7 +76,7 @@ public:
 
         auto it = m_cacheMap.find(k);
         if (it != m_cacheMap.end()) {
-            return it->second->tile;
+            return it->second.tile;
         }
         return nullptr;
     }
@@ -83,40 +86,43 @@ public:
         m_cacheMaxUsage = _cacheSizeBytes;
 
         while (m_cacheUsage > m_cacheMaxUsage) {
-            if (m_cacheList.empty()) {
+            if (m_cacheMap.empty()) {
                 LOGE("Invalid cache state!");
                 m_cacheUsage = 0;
                 break;
             }
-            auto& tile = m_cacheList.back().tile;
-            poppedTileIDs.push_back(tile->getID());
-            m_cacheUsage -= tile->getMemoryUsage();
-            m_cacheMap.erase(m_cacheList.back().key);
-            m_cacheList.pop_back();
+            auto it = m_cacheMap.find(m_policy->evict());
+            if (it == m_cacheMap.end()) {
+                LOGE("Invalid cache policy state!");
+                break;
+            }
+            poppedTileIDs.push_back(it->second.tile->getID());
+            m_cacheUsage -= it->second.usage;
+            m_cacheMap.erase(it);
         }
         return poppedTileIDs;
     }
 
+    /* Zoom of the current view, passed on to the replacement policy */
+    void setZoom(float _zoom) { m_policy->setZoom(_zoom); }
+
     size_t getMemoryUsage() const {
-        size_t sum = 0;
-        for (auto& entry : m_cacheList) {
-            sum += entry.tile->getMemoryUsage();
-        }
-        return sum;
+        return m_cacheUsage;
     }
 
     void clear() {
         m_cacheMap.clear();
-        m_cacheList.clear();
+        m_policy->clear();
         m_cacheUsage = 0;
     }
 
 private:
     CacheMap m_cacheMap;
-    CacheList m_cacheList;
 
-    int m_cacheUsage;
-    int m_cacheMaxUsage;
+    size_t m_cacheUsage;
+    size_t m_cacheMaxUsage;
+
+    std::unique_ptr<TileCachePolicy> m_policy;
 };
 
 }
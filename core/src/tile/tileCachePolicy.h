@@ -0,0 +1,156 @@
+#pragma once
+
+#include "tile/tileHash.h"
+#include "tile/tileID.h"
+
+#include <cmath>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace Tangram {
+// TileSet serial + TileID
+using TileCacheKey = std::pair<int32_t, TileID>;
+}
+
+namespace std {
+    template <>
+    struct hash<Tangram::TileCacheKey> {
+        size_t operator()(const Tangram::TileCacheKey& k) const {
+            std::size_t seed = 0;
+            hash_combine(seed, k.first);
+            hash_combine(seed, k.second);
+            return seed;
+        }
+    };
+}
+
+namespace Tangram {
+
+/* Replacement policy of a <TileCache>: Decides which tile is evicted next.
+ *
+ * The cache notifies its policy about each tile that is added or taken out
+ * again and asks for a victim when it exceeds its size limit.
+ */
+class TileCachePolicy {
+public:
+    virtual ~TileCachePolicy() {}
+
+    /* A tile of @_usage bytes that took @_cost milliseconds to build was added */
+    virtual void insert(const TileCacheKey& _key, size_t _usage, float _cost) = 0;
+
+    /* The tile was taken from the cache */
+    virtual void remove(const TileCacheKey& _key) = 0;
+
+    /* Remove and return the key of the tile to evict next. Only called when not empty */
+    virtual TileCacheKey evict() = 0;
+
+    virtual void clear() = 0;
+
+    /* Zoom of the current view, tiles far from it are less likely to be reused */
+    virtual void setZoom(float _zoom) {}
+};
+
+/* Evicts the least recently added tile */
+class LRUTileCachePolicy : public TileCachePolicy {
+public:
+
+    void insert(const TileCacheKey& _key, size_t _usage, float _cost) override {
+        m_list.push_front(_key);
+        m_map[_key] = m_list.begin();
+    }
+
+    void remove(const TileCacheKey& _key) override {
+        auto it = m_map.find(_key);
+        if (it == m_map.end()) { return; }
+
+        m_list.erase(it->second);
+        m_map.erase(it);
+    }
+
+    TileCacheKey evict() override {
+        TileCacheKey key = m_list.back();
+        m_map.erase(key);
+        m_list.pop_back();
+        return key;
+    }
+
+    void clear() override {
+        m_list.clear();
+        m_map.clear();
+    }
+
+private:
+    std::list<TileCacheKey> m_list;
+    std::unordered_map<TileCacheKey, std::list<TileCacheKey>::iterator> m_map;
+};
+
+/* GreedyDual-Size: Evicts the tile with the lowest rebuild cost per byte.
+ *
+ * Each tile gets the value H = L + cost / size when it is added, where cost
+ * is its build time weighted by the distance of its zoom level to the current
+ * view zoom. L is the value of the last evicted tile, so that tiles that were
+ * not used for a long time eventually get evicted even when they are costly.
+ */
+class GreedyDualSizeTileCachePolicy : public TileCachePolicy {
+public:
+
+    // Cost of tiles with unknown build time
+    static constexpr float MIN_COST = 0.1f;
+
+    void insert(const TileCacheKey& _key, size_t _usage, float _cost) override {
+        remove(_key);
+
+        float weight = 1.f / (1.f + std::abs(_key.second.z - m_zoom));
+        double value = m_inflation + std::fmax(_cost, MIN_COST) * weight / std::fmax(_usage, 1);
+
+        m_values[_key] = value;
+        m_queue.emplace(value, _key);
+    }
+
+    void remove(const TileCacheKey& _key) override {
+        auto it = m_values.find(_key);
+        if (it == m_values.end()) { return; }
+
+        m_queue.erase({ it->second, _key });
+        m_values.erase(it);
+    }
+
+    TileCacheKey evict() override {
+        auto entry = *m_queue.begin();
+        m_queue.erase(m_queue.begin());
+        m_values.erase(entry.second);
+
+        m_inflation = entry.first;
+
+        return entry.second;
+    }
+
+    void clear() override {
+        m_queue.clear();
+        m_values.clear();
+        m_inflation = 0;
+    }
+
+    void setZoom(float _zoom) override { m_zoom = _zoom; }
+
+private:
+    using Entry = std::pair<double, TileCacheKey>;
+
+    struct EntryCompare {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.first != b.first) { return a.first < b.first; }
+            if (a.second.first != b.second.first) { return a.second.first < b.second.first; }
+            return a.second.second < b.second.second;
+        }
+    };
+
+    std::set<Entry, EntryCompare> m_queue;
+    std::unordered_map<TileCacheKey, double> m_values;
+
+    double m_inflation = 0;
+    float m_zoom = 0;
+};
+
+}
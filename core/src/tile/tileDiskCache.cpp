@@ -0,0 +1,613 @@
+#include "tile/tileDiskCache.h"
+
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "log.h"
+#include "scene/scene.h"
+#include "selection/featureSelection.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "util/mapProjection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define FILE_MAGIC 0x43544754 // 'TGTC'
+#define FILE_EXTENSION ".tile"
+
+// Fraction of the maximum size that eviction shrinks the cache to, so that
+// the next writes don't evict again right away
+#define EVICT_TARGET 0.9
+
+namespace Tangram {
+
+// File layout, all offsets are relative to the start of the file:
+//
+//   FileHeader
+//   MeshHeader[meshCount]
+//   style names, vertex data, index data and draw calls of the meshes
+//   selection features: { id, itemCount, { key, type, value }[itemCount] }[featureCount]
+//
+// Sections start at multiples of 4 bytes.
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sceneHash;
+    uint32_t meshCount;
+    uint32_t featureCount;
+    uint32_t featureOffset;
+    uint32_t size;
+};
+
+struct MeshHeader {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t stride;
+    uint32_t drawMode;
+    uint32_t vertexCount;
+    uint32_t vertexOffset;
+    uint32_t indexCount;
+    uint32_t indexOffset;
+    uint32_t drawCallCount;
+    uint32_t drawCallOffset;
+};
+
+enum class PropertyType : uint32_t { none, number, string };
+
+static uint64_t fnv1a(const void* _data, size_t _length, uint64_t _hash = 0xcbf29ce484222325ull) {
+    auto* bytes = static_cast<const uint8_t*>(_data);
+    for (size_t i = 0; i < _length; i++) {
+        _hash = (_hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return _hash;
+}
+
+struct FileWriter {
+    std::vector<char> data;
+
+    size_t append(const void* _data, size_t _length) {
+        size_t offset = data.size();
+        auto* bytes = static_cast<const char*>(_data);
+        data.insert(data.end(), bytes, bytes + _length);
+        data.resize((data.size() + 3) & ~size_t(3), 0);
+        return offset;
+    }
+
+    void appendString(const std::string& _string) {
+        uint32_t length = _string.size();
+        append(&length, sizeof(length));
+        append(_string.data(), length);
+    }
+
+    template<class T>
+    void set(size_t _offset, const T& _value) {
+        std::memcpy(data.data() + _offset, &_value, sizeof(T));
+    }
+};
+
+struct FileReader {
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+
+    FileReader(const char* _data, size_t _size) : data(_data), size(_size) {}
+
+    bool contains(size_t _offset, size_t _length) const {
+        return _offset <= size && _length <= size - _offset;
+    }
+
+    template<class T>
+    bool read(T& _value) {
+        if (!contains(pos, sizeof(T))) { return false; }
+        std::memcpy(&_value, data + pos, sizeof(T));
+        pos = (pos + sizeof(T) + 3) & ~size_t(3);
+        return true;
+    }
+
+    bool readString(std::string& _string) {
+        uint32_t length;
+        if (!read(length) || !contains(pos, length)) { return false; }
+        _string.assign(data + pos, length);
+        pos = (pos + length + 3) & ~size_t(3);
+        return true;
+    }
+};
+
+TileDiskCache::TileDiskCache(const std::string& _path, uint64_t _maxSize)
+    : m_path(_path),
+      m_maxSize(_maxSize),
+      m_worker(std::make_unique<AsyncWorker>()) {}
+
+TileDiskCache::~TileDiskCache() {}
+
+uint64_t TileDiskCache::contentHash(const Scene& _scene) {
+
+    uint32_t version = VERSION;
+    uint64_t hash = fnv1a(&version, sizeof(version));
+
+    std::string config = YAML::Dump(_scene.config());
+    hash = fnv1a(config.data(), config.size(), hash);
+
+    float pixelScale = _scene.pixelScale();
+    hash = fnv1a(&pixelScale, sizeof(pixelScale), hash);
+
+    return hash;
+}
+
+uint64_t TileDiskCache::sceneHash(const Scene& _scene) {
+
+    if (_scene.id == m_hashedScene && _scene.pixelScale() == m_hashedPixelScale) {
+        return m_sceneHash;
+    }
+
+    m_hashedScene = _scene.id;
+    m_hashedPixelScale = _scene.pixelScale();
+    m_sceneHash = contentHash(_scene);
+
+    // Tiles of other scenes or pixel scales are not used anymore
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%016" PRIx64 "-", m_sceneHash);
+    removeFiles(prefix);
+
+    return m_sceneHash;
+}
+
+void TileDiskCache::setScene(std::shared_ptr<Scene> _scene) {
+
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+
+    m_scene = _scene;
+
+    if (m_scene) {
+        m_worker->enqueue([this, _scene]() { sceneHash(*_scene); });
+    }
+}
+
+std::string TileDiskCache::filePath(uint64_t _sceneHash, const std::string& _source,
+                                    int64_t _generation, const TileID& _tileId) const {
+
+    char name[128];
+    snprintf(name, sizeof(name), "/%016" PRIx64 "-%016" PRIx64 "-%d-%d-%d-%d-%" PRId64 FILE_EXTENSION,
+             _sceneHash, fnv1a(_source.data(), _source.size()),
+             _tileId.z, _tileId.x, _tileId.y, _tileId.s, _generation);
+
+    return m_path + name;
+}
+
+void TileDiskCache::load(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+
+    auto scene = m_scene;
+
+    if (!scene) {
+        _cb.func(_task);
+        return;
+    }
+
+    m_worker->enqueue([this, scene, _task, _cb]() {
+        if (!_task->isCanceled()) {
+            auto start = std::chrono::steady_clock::now();
+
+            uint64_t hash = sceneHash(*scene);
+            auto path = filePath(hash, _task->source().name(), _task->sourceGeneration(),
+                                 _task->tileId());
+
+            auto tile = read(path, hash, *scene, *_task);
+
+            if (tile) {
+                std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                tile->setBuildTime(elapsed.count());
+
+                _task->tile() = tile;
+                m_hits++;
+            } else {
+                m_misses++;
+            }
+        }
+        _cb.func(_task);
+    });
+}
+
+void TileDiskCache::put(const Tile& _tile, const TileSource& _source, const Scene& _scene) {
+
+    std::shared_ptr<Scene> scene;
+    {
+        std::lock_guard<std::mutex> lock(m_sceneMutex);
+        // Tile of a previous scene
+        if (m_scene.get() != &_scene) { return; }
+        scene = m_scene;
+    }
+
+    if (!_tile.rasters().empty()) {
+        m_skipped++;
+        return;
+    }
+
+    std::vector<std::pair<const Style*, const MeshBase*>> meshes;
+
+    for (auto& style : _scene.styles()) {
+        auto& mesh = _tile.getMesh(*style);
+        if (!mesh) { continue; }
+
+        auto* compiled = mesh->compiledMesh();
+        if (!compiled || !compiled->compiledVertices()) {
+            m_skipped++;
+            return;
+        }
+        meshes.emplace_back(style.get(), compiled);
+    }
+
+    FileWriter file;
+
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = VERSION;
+    header.meshCount = meshes.size();
+    header.featureCount = _tile.getSelectionFeatures().size();
+    file.append(&header, sizeof(header));
+
+    std::vector<MeshHeader> meshHeaders(meshes.size());
+    size_t meshHeaderOffset = file.append(meshHeaders.data(), meshHeaders.size() * sizeof(MeshHeader));
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        auto& name = meshes[i].first->getName();
+        auto& mesh = *meshes[i].second;
+        auto& m = meshHeaders[i];
+
+        size_t stride = meshes[i].first->vertexLayout()->getStride();
+
+        m.nameLength = name.size();
+        m.nameOffset = file.append(name.data(), name.size());
+        m.stride = stride;
+        m.drawMode = mesh.drawMode();
+        m.vertexCount = mesh.vertexCount();
+        m.vertexOffset = file.append(mesh.compiledVertices(), mesh.vertexCount() * stride);
+        m.indexCount = mesh.indexCount();
+        m.indexOffset = file.append(mesh.compiledIndices(), mesh.indexCount() * sizeof(GLushort));
+        m.drawCallCount = mesh.vertexOffsets().size();
+        m.drawCallOffset = file.append(mesh.vertexOffsets().data(),
+                                       mesh.vertexOffsets().size() * sizeof(std::pair<uint32_t, uint32_t>));
+    }
+    std::memcpy(file.data.data() + meshHeaderOffset, meshHeaders.data(),
+                meshHeaders.size() * sizeof(MeshHeader));
+
+    size_t featureOffset = file.data.size();
+
+    for (auto& feature : _tile.getSelectionFeatures()) {
+        uint32_t id = feature.first;
+        uint32_t count = feature.second->items().size();
+        file.append(&id, sizeof(id));
+        file.append(&count, sizeof(count));
+
+        for (auto& item : feature.second->items()) {
+            file.appendString(item.key);
+
+            if (item.value.is<double>()) {
+                auto type = PropertyType::number;
+                double value = item.value.get<double>();
+                file.append(&type, sizeof(type));
+                file.append(&value, sizeof(value));
+            } else if (item.value.is<std::string>()) {
+                auto type = PropertyType::string;
+                file.append(&type, sizeof(type));
+                file.appendString(item.value.get<std::string>());
+            } else {
+                auto type = PropertyType::none;
+                file.append(&type, sizeof(type));
+            }
+        }
+    }
+
+    header.featureOffset = featureOffset;
+    header.size = file.data.size();
+    file.set(0, header);
+
+    // Written on the cache thread where the scene hash is known
+    auto data = std::make_shared<std::vector<char>>(std::move(file.data));
+    TileID tileId = _tile.getID();
+    int64_t generation = _tile.sourceGeneration();
+    std::string source = _source.name();
+
+    m_worker->enqueue([this, scene, data, tileId, generation, source]() {
+        uint64_t hash = sceneHash(*scene);
+        std::memcpy(data->data() + offsetof(FileHeader, sceneHash), &hash, sizeof(hash));
+
+        auto path = filePath(hash, source, generation, tileId);
+        if (write(path, *data)) {
+            m_writes++;
+            useFile(path, data->size());
+            evictFiles();
+        }
+    });
+}
+
+bool TileDiskCache::write(const std::string& _path, const std::vector<char>& _data) {
+
+    // Write to a temporary file first so that readers never see partial files
+    std::string tmpPath = _path + ".tmp";
+
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+        LOGW("Failed to write tile cache file: %s", tmpPath.c_str());
+        return false;
+    }
+
+    file.write(_data.data(), _data.size());
+    file.close();
+
+    if (!file || std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        LOGW("Failed to write tile cache file: %s", _path.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<Tile> TileDiskCache::read(const std::string& _path, uint64_t _sceneHash,
+                                          const Scene& _scene, TileTask& _task) {
+
+    // The source was cleared while waiting for the cache
+    if (_task.sourceGeneration() != _task.source().generation()) { return nullptr; }
+
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        // Removed by someone else
+        if (m_files.count(_path)) { removeFile(_path); }
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(FileHeader))) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = st.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) { return nullptr; }
+
+    FileReader file(static_cast<const char*>(mapping), size);
+
+    auto invalid = [&]() {
+        munmap(mapping, size);
+        LOGW("Invalid tile cache file: %s", _path.c_str());
+        removeFile(_path);
+        return nullptr;
+    };
+
+    FileHeader header;
+    file.read(header);
+
+    if (header.magic != FILE_MAGIC || header.version != VERSION ||
+        header.sceneHash != _sceneHash || header.size != size ||
+        !file.contains(file.pos, header.meshCount * sizeof(MeshHeader))) {
+        return invalid();
+    }
+
+    // Selection colors of the cached meshes are replaced by new
+    // identifiers, the stored ones are used by other features now
+    std::unordered_map<uint32_t, uint32_t> selectionIds;
+    fastmap<uint32_t, std::shared_ptr<Properties>> selectionFeatures;
+
+    FileReader features(file.data, size);
+    features.pos = header.featureOffset;
+
+    for (uint32_t i = 0; i < header.featureCount; i++) {
+        uint32_t id, count;
+        if (!features.read(id) || !features.read(count)) { return invalid(); }
+
+        std::vector<Properties::Item> items;
+        for (uint32_t j = 0; j < count; j++) {
+            std::string key;
+            PropertyType type;
+            if (!features.readString(key) || !features.read(type)) { return invalid(); }
+
+            if (type == PropertyType::number) {
+                double value;
+                if (!features.read(value)) { return invalid(); }
+                items.emplace_back(std::move(key), Value(value));
+            } else if (type == PropertyType::string) {
+                std::string value;
+                if (!features.readString(value)) { return invalid(); }
+                items.emplace_back(std::move(key), Value(std::move(value)));
+            } else {
+                items.emplace_back(std::move(key), Value(none_type{}));
+            }
+        }
+
+        auto props = std::make_shared<Properties>();
+        props->setSorted(std::move(items));
+        props->sourceId = _task.source().id();
+
+        uint32_t newId = _scene.featureSelection()->nextColorIdentifier();
+        selectionIds[id] = newId;
+        selectionFeatures[newId] = props;
+    }
+
+    auto tile = std::make_shared<Tile>(_task.tileId(), *_scene.mapProjection(), &_task.source());
+    tile->initGeometry(_scene.styles().size());
+
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        MeshHeader m;
+        file.read(m);
+
+        if (!file.contains(m.nameOffset, m.nameLength) ||
+            !file.contains(m.vertexOffset, size_t(m.vertexCount) * m.stride) ||
+            !file.contains(m.indexOffset, size_t(m.indexCount) * sizeof(GLushort)) ||
+            !file.contains(m.drawCallOffset, size_t(m.drawCallCount) * sizeof(std::pair<uint32_t, uint32_t>))) {
+            return invalid();
+        }
+
+        std::string name(file.data + m.nameOffset, m.nameLength);
+        const Style* style = _scene.findStyle(name);
+
+        if (!style || size_t(style->vertexLayout()->getStride()) != m.stride) { return invalid(); }
+
+        auto* vertices = new GLbyte[size_t(m.vertexCount) * m.stride];
+        std::memcpy(vertices, file.data + m.vertexOffset, size_t(m.vertexCount) * m.stride);
+
+        GLushort* indices = nullptr;
+        if (m.indexCount > 0) {
+            indices = new GLushort[m.indexCount];
+            std::memcpy(indices, file.data + m.indexOffset, m.indexCount * sizeof(GLushort));
+        }
+
+        std::vector<std::pair<uint32_t, uint32_t>> drawCalls(m.drawCallCount);
+        std::memcpy(drawCalls.data(), file.data + m.drawCallOffset,
+                    drawCalls.size() * sizeof(std::pair<uint32_t, uint32_t>));
+
+        for (auto& attrib : style->vertexLayout()->getAttribs()) {
+            if (attrib.name != "a_selection_color") { continue; }
+
+            for (size_t v = 0; v < m.vertexCount; v++) {
+                GLbyte* selection = vertices + v * m.stride + attrib.offset;
+                uint32_t id;
+                std::memcpy(&id, selection, sizeof(id));
+                if (id == 0) { continue; }
+
+                auto it = selectionIds.find(id);
+                id = (it == selectionIds.end()) ? 0 : it->second;
+                std::memcpy(selection, &id, sizeof(id));
+            }
+        }
+
+        auto mesh = std::make_unique<RawMesh>(style->vertexLayout(), m.drawMode);
+        mesh->compile(std::move(drawCalls), vertices, m.vertexCount, indices, m.indexCount);
+
+        tile->setMesh(*style, std::move(mesh));
+    }
+
+    tile->setSelectionFeatures(selectionFeatures);
+
+    munmap(mapping, size);
+
+    useFile(_path, size);
+
+    // Keep the order of uses for the next start
+    utimes(_path.c_str(), nullptr);
+
+    return tile;
+}
+
+void TileDiskCache::removeFiles(const std::string& _keepPrefix) {
+
+    m_files.clear();
+    m_size = 0;
+
+    DIR* dir = opendir(m_path.c_str());
+    if (!dir) { return; }
+
+    const size_t extLength = strlen(FILE_EXTENSION);
+
+    struct KeptFile {
+        time_t modified;
+        std::string path;
+        uint64_t size;
+    };
+    std::vector<KeptFile> kept;
+
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+
+        if (name.size() <= extLength ||
+            name.compare(name.size() - extLength, extLength, FILE_EXTENSION) != 0) {
+            continue;
+        }
+        std::string path = m_path + "/" + name;
+
+        struct stat st;
+        if (!_keepPrefix.empty() && name.compare(0, _keepPrefix.size(), _keepPrefix) == 0 &&
+            stat(path.c_str(), &st) == 0) {
+            kept.push_back({ st.st_mtime, path, uint64_t(st.st_size) });
+            continue;
+        }
+        std::remove(path.c_str());
+    }
+
+    closedir(dir);
+
+    std::sort(kept.begin(), kept.end(), [](const KeptFile& _a, const KeptFile& _b) {
+        return _a.modified < _b.modified;
+    });
+    for (auto& file : kept) {
+        useFile(file.path, file.size);
+    }
+
+    evictFiles();
+}
+
+void TileDiskCache::useFile(const std::string& _path, uint64_t _size) {
+
+    auto& entry = m_files[_path];
+    m_size = m_size - entry.size + _size;
+
+    entry.size = _size;
+    entry.lastUse = ++m_lastUse;
+}
+
+void TileDiskCache::removeFile(const std::string& _path) {
+
+    std::remove(_path.c_str());
+
+    auto it = m_files.find(_path);
+    if (it == m_files.end()) { return; }
+
+    m_size -= it->second.size;
+    m_files.erase(it);
+}
+
+void TileDiskCache::evictFiles() {
+
+    if (m_size <= m_maxSize) { return; }
+
+    std::vector<std::pair<uint64_t, std::string>> files;
+    files.reserve(m_files.size());
+    for (auto& file : m_files) {
+        files.emplace_back(file.second.lastUse, file.first);
+    }
+    std::sort(files.begin(), files.end());
+
+    uint64_t targetSize = m_maxSize * EVICT_TARGET;
+
+    for (auto& file : files) {
+        if (m_size <= targetSize) { break; }
+        removeFile(file.second);
+        m_evictions++;
+    }
+}
+
+void TileDiskCache::clear() {
+    m_worker->enqueue([this]() { removeFiles(""); });
+}
+
+TileDiskCache::Stats TileDiskCache::getStats() const {
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.writes = m_writes;
+    stats.skipped = m_skipped;
+    stats.evictions = m_evictions;
+    stats.size = m_size;
+    return stats;
+}
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "tile/tileTask.h"
+#include "util/asyncWorker.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class Scene;
+class Tile;
+class TileSource;
+
+/* Persistent cache of built tiles.
+ *
+ * Stores the compiled meshes and selection features of a <Tile> in one file
+ * per tile, so that on a later start the tile can be restored without
+ * loading, parsing and building its data. Files are named by the content
+ * hash of the scene, the name of the TileSource, the generation of the
+ * TileSource and the TileID. When the scene changes, files of other scenes
+ * are removed.
+ *
+ * The file layout is position independent with 4-byte aligned sections,
+ * so the file is mapped into memory and copied directly into the meshes.
+ *
+ * Only the geometry of tiles is stored. Tiles with labels or rasters are
+ * skipped and built as before, since their glyph and raster textures only
+ * exist at runtime; Stats::skipped counts them. In scenes that label most
+ * tiles the cache restores few tiles.
+ *
+ * The files take up at most the maximum size of the cache. When it is
+ * exceeded, the least recently stored or restored files are removed. The
+ * modification time of a file is its last use, so that the order is kept
+ * across restarts.
+ *
+ * Thread-safe: put() is called from TileWorker threads. File I/O runs on
+ * a thread of the cache.
+ */
+class TileDiskCache {
+
+public:
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t writes = 0;
+        // Tiles that could not be stored, e.g. with labels
+        size_t skipped = 0;
+        // Files that were removed to stay within the maximum size
+        size_t evictions = 0;
+        // Bytes of the cache files of the current scene
+        uint64_t size = 0;
+    };
+
+    /* @_path: Directory of the cache files, must exist
+     * @_maxSize: Maximum bytes of the cache files */
+    TileDiskCache(const std::string& _path, uint64_t _maxSize = DEFAULT_MAX_SIZE);
+
+    ~TileDiskCache();
+
+    /* Set the scene whose styles are used to store and restore tiles */
+    void setScene(std::shared_ptr<Scene> _scene);
+
+    /* Restore the tile of @_task. Calls @_cb from the cache thread when
+     * done; the task is ready when the tile was found */
+    void load(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+
+    /* Store @_tile, built with @_scene; must be called before the meshes
+     * of the tile are uploaded */
+    void put(const Tile& _tile, const TileSource& _source, const Scene& _scene);
+
+    /* Remove all cache files */
+    void clear();
+
+    Stats getStats() const;
+
+    /* Hash of the scene configuration and pixel scale, which
+     * determine the geometry of the tiles of a scene */
+    static uint64_t contentHash(const Scene& _scene);
+
+    static const uint32_t VERSION = 1;
+
+    static const uint64_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+
+private:
+
+    std::string filePath(uint64_t _sceneHash, const std::string& _source,
+                         int64_t _generation, const TileID& _tileId) const;
+
+    bool write(const std::string& _path, const std::vector<char>& _data);
+
+    std::shared_ptr<Tile> read(const std::string& _path, uint64_t _sceneHash,
+                               const Scene& _scene, TileTask& _task);
+
+    // Content hash of @_scene, cached for the last scene; called on the cache thread
+    uint64_t sceneHash(const Scene& _scene);
+
+    // Remove cache files, except those starting with @_keepPrefix, which are
+    // indexed in m_files in the order of their modification times
+    void removeFiles(const std::string& _keepPrefix);
+
+    // Record a use of the file at @_path with @_size bytes
+    void useFile(const std::string& _path, uint64_t _size);
+
+    void removeFile(const std::string& _path);
+
+    // Remove least recently used files until the files fit into m_maxSize
+    void evictFiles();
+
+    std::string m_path;
+    uint64_t m_maxSize;
+
+    struct FileEntry {
+        uint64_t size;
+        // Order of the last use
+        uint64_t lastUse;
+    };
+
+    // Cache files by path and their total size, used on the cache thread
+    std::unordered_map<std::string, FileEntry> m_files;
+    uint64_t m_lastUse = 0;
+
+    std::mutex m_sceneMutex;
+    std::shared_ptr<Scene> m_scene;
+
+    // Content hash of the scene with id m_hashedScene at m_hashedPixelScale
+    int32_t m_hashedScene = -1;
+    float m_hashedPixelScale = 0;
+    uint64_t m_sceneHash = 0;
+
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+    std::atomic<size_t> m_writes{0};
+    std::atomic<size_t> m_skipped{0};
+    std::atomic<size_t> m_evictions{0};
+    std::atomic<uint64_t> m_size{0};
+
+    // Keep last: joins the cache thread before other members are destroyed
+    std::unique_ptr<AsyncWorker> m_worker;
+};
+
+}
@@ -1,16 +1,19 @@
 #include "tile/tileManager.h"
 
+#include "data/tileDataCache.h"
 #include "data/tileSource.h"
 #include "map.h"
 #include "platform.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
 #include "util/mapProjection.h"
 #include "view/view.h"
 
 #include "glm/gtx/norm.hpp"
 
 #include <algorithm>
+#include <limits>
 
 #define DBG(...) // LOGD(__VA_ARGS__)
 
@@ -20,6 +23,7 @@ TileManager::TileManager(std::shared_ptr<Platform> platform, TileTaskQueue& _til
     m_workers(_tileWorker) {
 
     m_tileCache = std::unique_ptr<TileCache>(new TileCache(DEFAULT_CACHE_SIZE));
+    m_tileDataCache = std::shared_ptr<TileDataCache>(new TileDataCache(DEFAULT_DATA_CACHE_SIZE));
 
     // Callback to pass task from Download-Thread to Worker-Queue
     m_dataCallback = TileTaskCb{[this, platform](std::shared_ptr<TileTask> task) {
@@ -34,6 +38,15 @@ TileManager::TileManager(std::shared_ptr<Platform> platform, TileTaskQueue& _til
             task->cancel();
         }
     }};
+
+    m_diskCacheCallback = TileTaskCb{[platform](std::shared_ptr<TileTask> task) {
+
+        if (!task->isReady()) {
+            // Not cached - load its data on the next update
+            task->setNeedsLoading(true);
+        }
+        platform->requestRender();
+    }};
 }
 
 TileManager::~TileManager() {
@@ -54,7 +67,7 @@ void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>&
                 return true;
             }
             // Clear cache
-            tileSet.tiles.clear();
+            tileSet.clearTiles();
             return false;
         });
 
@@ -65,6 +78,8 @@ void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>&
 
         if (!source->generateGeometry()) { continue; }
 
+        source->setTileDataCache(m_tileDataCache);
+
         if (std::find_if(m_tileSets.begin(), m_tileSets.end(),
                          [&](const TileSet& a) {
                              return a.source->name() == source->name();
@@ -87,6 +102,7 @@ std::shared_ptr<TileSource> TileManager::getClientTileSource(int32_t sourceID) {
 }
 
 void TileManager::addClientTileSource(std::shared_ptr<TileSource> _tileSource) {
+    _tileSource->setTileDataCache(m_tileDataCache);
     m_tileSets.push_back({ _tileSource, true });
 }
 
@@ -108,7 +124,7 @@ bool TileManager::removeClientTileSource(TileSource& _tileSource) {
 
 void TileManager::clearTileSets() {
     for (auto& tileSet : m_tileSets) {
-        tileSet.tiles.clear();
+        tileSet.clearTiles();
     }
 
     m_tileCache->clear();
@@ -117,23 +133,26 @@ void TileManager::clearTileSets() {
 void TileManager::clearTileSet(int32_t _sourceId) {
     for (auto& tileSet : m_tileSets) {
         if (tileSet.source->id() != _sourceId) { continue; }
-        tileSet.tiles.clear();
+        tileSet.clearTiles();
     }
 
     m_tileCache->clear();
     m_tileSetChanged = true;
 }
 
-void TileManager::updateTileSets(const View& _view) {
+void TileManager::updateTileSets(const View& _view, const View* _prefetchView) {
 
     m_tiles.clear();
     m_tilesInProgress = 0;
     m_tileSetChanged = false;
 
+    m_tileCache->setZoom(_view.getZoom());
+
     if (!getDebugFlag(DebugFlags::freeze_tiles)) {
 
         for (auto& tileSet : m_tileSets) {
             tileSet.visibleTiles.clear();
+            tileSet.prefetchTiles.clear();
         }
 
         auto tileCb = [&, zoom = _view.getZoom()](TileID _tileID){
@@ -141,12 +160,30 @@ void TileManager::updateTileSets(const View& _view) {
                 auto zoomBias = tileSet.source->zoomBias();
                 auto maxZoom = tileSet.source->maxZoom();
 
-                // Insert scaled and maxZoom mapped tileID in the visible set
-                tileSet.visibleTiles.insert(_tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom));
+                // Add scaled and maxZoom mapped tileID to the visible set
+                tileSet.visibleTiles.push_back(_tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom));
             }
         };
 
         _view.getVisibleTiles(tileCb);
+
+        for (auto& tileSet : m_tileSets) {
+            // Mapped tileIDs of different view tiles can be the same
+            auto& visibleTiles = tileSet.visibleTiles;
+            std::sort(visibleTiles.begin(), visibleTiles.end());
+            visibleTiles.erase(std::unique(visibleTiles.begin(), visibleTiles.end()), visibleTiles.end());
+        }
+
+        if (_prefetchView && m_prefetchBudget > 0) {
+            std::vector<TileID> prefetchTiles;
+            _prefetchView->getVisibleTiles([&](TileID _tileID) {
+                    prefetchTiles.push_back(_tileID);
+                });
+
+            for (auto& tileSet : m_tileSets) {
+                updatePrefetchTiles(tileSet, prefetchTiles, _prefetchView->state());
+            }
+        }
     }
 
     for (auto& tileSet : m_tileSets) {
@@ -158,6 +195,10 @@ void TileManager::updateTileSets(const View& _view) {
 
     loadTiles();
 
+    // Pass priority changes and canceled tasks to the workers queue
+    m_workers.updateTasks(m_updatedTasks);
+    m_updatedTasks.clear();
+
     // Make m_tiles an unique list of tiles for rendering sorted from
     // high to low zoom-levels.
     std::sort(m_tiles.begin(), m_tiles.end(), [](auto& a, auto& b) {
@@ -203,61 +244,32 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
 
     const auto& visibleTiles = _tileSet.visibleTiles;
 
+    // Each visible tile adds at most one entry for itself and four for its
+    // proxies: Reserve the space so that entries are not moved while adding.
+    assert(_tileSet.sortedTiles == tiles.size());
+    tiles.reserve(tiles.size() + 5 * visibleTiles.size() + _tileSet.prefetchTiles.size());
+
     // Loop over visibleTiles and add any needed tiles to tileSet
-    auto curTilesIt = tiles.begin();
+    size_t curTiles = 0;
+    size_t endTiles = tiles.size();
     auto visTilesIt = visibleTiles.begin();
 
-    auto generation = _tileSet.source->generation();
-
-    while (visTilesIt != visibleTiles.end() || curTilesIt != tiles.end()) {
+    while (visTilesIt != visibleTiles.end() || curTiles != endTiles) {
 
         auto& visTileId = visTilesIt == visibleTiles.end()
             ? NOT_A_TILE : *visTilesIt;
 
-        auto& curTileId = curTilesIt == tiles.end()
-            ? NOT_A_TILE : curTilesIt->first;
+        auto& curTileId = curTiles == endTiles
+            ? NOT_A_TILE : tiles[curTiles].first;
 
         if (visTileId == curTileId) {
             // tiles in both sets match
             assert(visTilesIt != visibleTiles.end() &&
-                   curTilesIt != tiles.end());
-
-            auto& entry = curTilesIt->second;
-            entry.setVisible(true);
-
-            auto sourceGeneration = (entry.isReady()) ?
-                entry.tile->sourceGeneration() : entry.task->sourceGeneration();
-
-            if (entry.isReady()) {
-                m_tiles.push_back(entry.tile);
-
-                if (!entry.isInProgress() &&
-                    (sourceGeneration < generation)) {
-                    // Tile needs update - enqueue for loading
-                    entry.task = _tileSet.source->createTask(visTileId);
-                    enqueueTask(_tileSet, visTileId, _view);
-                }
-            } else if (entry.needsLoading()) {
-                // Not yet available - enqueue for loading
-                enqueueTask(_tileSet, visTileId, _view);
-
-            } else if (entry.isCanceled() &&
-                       (sourceGeneration < generation)) {
-                // Tile needs update - enqueue for loading
-                entry.task = _tileSet.source->createTask(visTileId);
-                enqueueTask(_tileSet, visTileId, _view);
-            }
-
-            if (entry.isInProgress()) {
-                m_tilesInProgress++;
-            }
+                   curTiles != endTiles);
 
-            if (newTiles && entry.isInProgress()) {
-                // check again for proxies
-                updateProxyTiles(_tileSet, visTileId, entry);
-            }
+            updateVisibleTile(_tileSet, visTileId, tiles[curTiles].second, _view, newTiles);
 
-            ++curTilesIt;
+            ++curTiles;
             ++visTilesIt;
 
         } else if (curTileId > visTileId) {
@@ -267,7 +279,11 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             //     NOT_A_TILE. (for the current implementation of > operator)
             assert(visTilesIt != visibleTiles.end());
 
-            if (!addTile(_tileSet, visTileId)) {
+            if (auto* entry = _tileSet.findTile(visTileId)) {
+                // Added as proxy of a previous tile
+                updateVisibleTile(_tileSet, visTileId, *entry, _view, newTiles);
+
+            } else if (!addTile(_tileSet, visTileId)) {
                 // Not in cache - enqueue for loading
                 enqueueTask(_tileSet, visTileId, _view);
                 m_tilesInProgress++;
@@ -277,9 +293,9 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
 
         } else {
             // tileSet has a tile not present in visibleTiles
-            assert(curTilesIt != tiles.end());
+            assert(curTiles != endTiles);
 
-            auto& entry = curTilesIt->second;
+            auto& entry = tiles[curTiles].second;
 
             if (entry.getProxyCounter() > 0) {
                 if (entry.isReady()) {
@@ -288,29 +304,45 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
                     // Cancel loading
                     removeTiles.push_back(curTileId);
                 }
+            } else if (entry.m_prefetch && _tileSet.isPrefetched(curTileId)) {
+                // Keep tile that is still expected to become visible
             } else {
                 removeTiles.push_back(curTileId);
             }
             entry.setVisible(false);
-            ++curTilesIt;
+            ++curTiles;
+        }
+    }
+
+    for (const auto& tileID : _tileSet.prefetchTiles) {
+        if (!_tileSet.findTile(tileID)) {
+            addPrefetchTile(_tileSet, tileID);
         }
     }
 
     while (!removeTiles.empty()) {
-        auto it = tiles.find(removeTiles.back());
+        auto id = removeTiles.back();
         removeTiles.pop_back();
 
-        if ((it != tiles.end()) &&
-            (!it->second.isVisible()) &&
-            (it->second.getProxyCounter() <= 0  ||
-             it->first.z >= maxZoom)) {
+        auto* entry = _tileSet.findTile(id);
+
+        if (entry &&
+            (!entry->isVisible()) &&
+            (entry->getProxyCounter() <= 0  ||
+             id.z >= maxZoom)) {
+
+            if (entry->m_prefetch && _tileSet.isPrefetched(id)) {
+                continue;
+            }
 
-            clearProxyTiles(_tileSet, it->first, it->second, removeTiles);
+            clearProxyTiles(_tileSet, id, *entry, removeTiles);
 
-            removeTile(_tileSet, it);
+            removeTile(_tileSet, id, *entry);
         }
     }
 
+    _tileSet.sortTiles();
+
     for (auto& it : tiles) {
         auto& entry = it.second;
 
@@ -343,8 +375,15 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             auto tileCenter = _view.mapProjection->TileCenter(id);
             double scaleDiv = exp2(id.z - _view.zoom);
             if (scaleDiv < 1) { scaleDiv = 0.1/scaleDiv; } // prefer parent tiles
-            task->setPriority(glm::length2(tileCenter - _view.center) * scaleDiv);
-            task->setProxyState(entry.getProxyCounter() > 0);
+            float priority = glm::length2(tileCenter - _view.center) * scaleDiv;
+            // Prefetched tiles are loaded after visible tiles, like proxies
+            bool proxy = entry.getProxyCounter() > 0 || entry.m_prefetch;
+
+            if (priority != task->getPriority() || proxy != task->isProxy()) {
+                task->setPriority(priority);
+                task->setProxyState(proxy);
+                m_updatedTasks.push_back(task);
+            }
         }
 
         if (entry.isReady()) {
@@ -354,6 +393,51 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     }
 }
 
+void TileManager::updateVisibleTile(TileSet& _tileSet, const TileID& _tileID, TileEntry& _entry,
+                                    const ViewState& _view, bool _newTiles) {
+
+    auto generation = _tileSet.source->tileGeneration(_tileID);
+
+    _entry.setVisible(true);
+
+    if (_entry.m_prefetch) {
+        _entry.m_prefetch = false;
+        m_prefetchStats.hits++;
+    }
+
+    auto sourceGeneration = (_entry.isReady()) ?
+        _entry.tile->sourceGeneration() : _entry.task->sourceGeneration();
+
+    if (_entry.isReady()) {
+        m_tiles.push_back(_entry.tile);
+
+        if (!_entry.isInProgress() &&
+            (sourceGeneration < generation)) {
+            // Tile needs update - enqueue for loading
+            _entry.task = _tileSet.source->createTask(_tileID);
+            enqueueTask(_tileSet, _tileID, _view);
+        }
+    } else if (_entry.needsLoading()) {
+        // Not yet available - enqueue for loading
+        enqueueTask(_tileSet, _tileID, _view);
+
+    } else if (_entry.isCanceled() &&
+               (sourceGeneration < generation)) {
+        // Tile needs update - enqueue for loading
+        _entry.task = _tileSet.source->createTask(_tileID);
+        enqueueTask(_tileSet, _tileID, _view);
+    }
+
+    if (_entry.isInProgress()) {
+        m_tilesInProgress++;
+    }
+
+    if (_newTiles && _entry.isInProgress()) {
+        // check again for proxies
+        updateProxyTiles(_tileSet, _tileID, _entry);
+    }
+}
+
 void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
                               const ViewState& _view) {
 
@@ -369,6 +453,57 @@ void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
     m_loadTasks.insert(it, std::make_tuple(distance, &_tileSet, _tileID));
 }
 
+void TileManager::updatePrefetchTiles(TileSet& _tileSet, const std::vector<TileID>& _prefetchView,
+                                      const ViewState& _view) {
+
+    auto zoomBias = _tileSet.source->zoomBias();
+    auto maxZoom = _tileSet.source->maxZoom();
+
+    std::vector<std::pair<double, TileID>> candidates;
+
+    for (const auto& id : _prefetchView) {
+        TileID tileID = id.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom);
+
+        if (_tileSet.isVisible(tileID)) { continue; }
+
+        auto tileCenter = _view.mapProjection->TileCenter(tileID);
+        candidates.emplace_back(glm::length2(tileCenter - _view.center), tileID);
+    }
+
+    // Prefer tiles close to the predicted view center
+    std::sort(candidates.begin(), candidates.end(), [](auto& a, auto& b) {
+            return a.first < b.first;
+        });
+
+    auto& prefetchTiles = _tileSet.prefetchTiles;
+
+    for (const auto& candidate : candidates) {
+        if (prefetchTiles.size() >= m_prefetchBudget) { break; }
+
+        if (std::find(prefetchTiles.begin(), prefetchTiles.end(),
+                      candidate.second) == prefetchTiles.end()) {
+            prefetchTiles.push_back(candidate.second);
+        }
+    }
+
+    std::sort(prefetchTiles.begin(), prefetchTiles.end());
+}
+
+void TileManager::addPrefetchTile(TileSet& _tileSet, const TileID& _tileID) {
+
+    // Cached tiles are ready without loading
+    if (m_tileCache->contains(_tileSet.source->id(), _tileID)) { return; }
+
+    auto& entry = _tileSet.emplaceTile(_tileID);
+    entry.task = _tileSet.source->createTask(_tileID);
+    entry.m_prefetch = true;
+
+    // Load after the visible tiles of this update
+    m_loadTasks.emplace_back(std::numeric_limits<double>::max(), &_tileSet, _tileID);
+
+    m_prefetchStats.requests++;
+}
+
 void TileManager::loadTiles() {
 
     if (m_loadTasks.empty()) { return; }
@@ -377,10 +512,18 @@ void TileManager::loadTiles() {
 
         auto tileId = std::get<2>(loadTask);
         auto& tileSet = *std::get<1>(loadTask);
-        auto tileIt = tileSet.tiles.find(tileId);
-        auto& entry = tileIt->second;
+        auto* entry = tileSet.findTile(tileId);
+        assert(entry && entry->task);
+
+        if (useDiskCache(tileSet) && !entry->task->tileDiskCache()) {
+            entry->task->setTileDiskCache(m_tileDiskCache);
+            entry->task->startedLoading();
 
-        tileSet.source->loadTileData(entry.task, m_dataCallback);
+            m_tileDiskCache->load(entry->task, m_diskCacheCallback);
+            continue;
+        }
+
+        tileSet.source->loadTileData(entry->task, m_dataCallback);
     }
 
     DBG("loading:%d pending:%d cache: %fMB",
@@ -395,7 +538,7 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
     auto tile = m_tileCache->get(_tileSet.source->id(), _tileID);
 
     if (tile) {
-        if (tile->sourceGeneration() == _tileSet.source->generation()) {
+        if (tile->sourceGeneration() >= _tileSet.source->tileGeneration(_tileID)) {
             m_tiles.push_back(tile);
 
             // Update tile origin based on wrap (set in the new tileID)
@@ -411,26 +554,31 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
     }
 
     // Add TileEntry to TileSet
-    auto entry = _tileSet.tiles.emplace(_tileID, tile);
+    auto& entry = _tileSet.emplaceTile(_tileID, tile);
 
     if (!tile) {
         // Add Proxy if corresponding proxy MapTile ready
-        updateProxyTiles(_tileSet, _tileID, entry.first->second);
+        updateProxyTiles(_tileSet, _tileID, entry);
 
-        entry.first->second.task = _tileSet.source->createTask(_tileID);
+        entry.task = _tileSet.source->createTask(_tileID);
     }
-    entry.first->second.setVisible(true);
+    entry.setVisible(true);
 
     return bool(tile);
 }
 
-void TileManager::removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::iterator& _tileIt) {
+void TileManager::removeTile(TileSet& _tileSet, const TileID& _tileID, TileEntry& _entry) {
 
-    auto& id = _tileIt->first;
-    auto& entry = _tileIt->second;
+    auto& id = _tileID;
+    auto& entry = _entry;
 
+    if (entry.m_prefetch) {
+        // Mispredicted prefetch
+        m_prefetchStats.misses++;
+    }
 
     if (entry.isInProgress()) {
+        m_updatedTasks.push_back(entry.task);
         entry.clearTask();
 
         // 1. Remove from Datasource. Make sure to cancel
@@ -449,7 +597,9 @@ void TileManager::removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::ite
     _tileSet.source->clearRaster(id);
 
     // Remove tile from set
-    _tileIt = _tileSet.tiles.erase(_tileIt);
+    entry.clearTask();
+    entry.tile.reset();
+    entry.m_removed = true;
 }
 
 bool TileManager::updateProxyTile(TileSet& _tileSet, TileEntry& _tile,
@@ -458,26 +608,21 @@ bool TileManager::updateProxyTile(TileSet& _tileSet, TileEntry& _tile,
 
     if (!_proxyTileId.isValid()) { return false; }
 
-    auto& tiles = _tileSet.tiles;
-
     // check if the proxy exists in the visible tile set
-    {
-        const auto& it = tiles.find(_proxyTileId);
-        if (it != tiles.end()) {
-            auto& entry = it->second;
+    if (auto* entry = _tileSet.findTile(_proxyTileId)) {
 
-            if (!entry.isCanceled() && _tile.setProxy(_proxyId)) {
-                entry.incProxyCounter();
-
-                if (entry.isReady()) {
-                    m_tiles.push_back(entry.tile);
-                }
+        if (!entry->isCanceled() && _tile.setProxy(_proxyId)) {
+            entry->incProxyCounter();
 
-                // Note: No need to check the cache: When the tile is in
-                // tileSet it would have already been fetched from cache
-                return true;
+            if (entry->isReady()) {
+                m_tiles.push_back(entry->tile);
             }
+            return true;
         }
+
+        // Note: No need to check the cache: When the tile is in
+        // tileSet it would have already been fetched from cache
+        return false;
     }
 
     // check if the proxy exists in the cache
@@ -485,8 +630,7 @@ bool TileManager::updateProxyTile(TileSet& _tileSet, TileEntry& _tile,
         auto proxyTile = m_tileCache->get(_tileSet.source->id(), _proxyTileId);
         if (proxyTile && _tile.setProxy(_proxyId)) {
 
-            auto result = tiles.emplace(_proxyTileId, proxyTile);
-            auto& entry = result.first->second;
+            auto& entry = _tileSet.emplaceTile(_proxyTileId, proxyTile);
             entry.incProxyCounter();
 
             m_tiles.push_back(proxyTile);
@@ -528,16 +672,13 @@ void TileManager::updateProxyTiles(TileSet& _tileSet, const TileID& _tileID, Til
 
 void TileManager::clearProxyTiles(TileSet& _tileSet, const TileID& _tileID, TileEntry& _tile,
                                   std::vector<TileID>& _removes) {
-    auto& tiles = _tileSet.tiles;
     auto zoomBias = _tileSet.source->zoomBias();
     auto maxZoom = _tileSet.source->maxZoom();
 
-    auto removeProxy = [&tiles,&_removes](TileID id) {
-        auto it = tiles.find(id);
-        if (it != tiles.end()) {
-            auto& entry = it->second;
-            entry.decProxyCounter();
-            if (entry.getProxyCounter() <= 0 && !entry.isVisible()) {
+    auto removeProxy = [&_tileSet,&_removes](TileID id) {
+        if (auto* entry = _tileSet.findTile(id)) {
+            entry->decProxyCounter();
+            if (entry->getProxyCounter() <= 0 && !entry->isVisible()) {
                 _removes.push_back(id);
             }
         }
@@ -567,4 +708,77 @@ void TileManager::setCacheSize(size_t _cacheSize) {
     m_tileCache->limitCacheSize(_cacheSize);
 }
 
+void TileManager::setCachePolicy(std::unique_ptr<TileCachePolicy> _policy) {
+    m_tileCache->setPolicy(std::move(_policy));
+}
+
+void TileManager::setDataCacheSize(size_t _cacheSize) {
+    m_tileDataCache->setCacheSize(_cacheSize);
+}
+
+void TileManager::setTileDiskCache(std::shared_ptr<TileDiskCache> _cache) {
+
+    m_tileDiskCache = _cache;
+
+    // Drop tasks waiting for the previous cache
+    clearTileSets();
+}
+
+TileManager::TileEntry* TileManager::TileSet::findTile(const TileID& _tileID) {
+
+    auto sorted = tiles.begin() + sortedTiles;
+
+    auto it = std::lower_bound(tiles.begin(), sorted, _tileID,
+                               [](auto& entry, auto& tileID) {
+                                   return entry.first < tileID;
+                               });
+
+    if (it == sorted || it->first != _tileID) {
+        // Not sorted yet
+        it = std::find_if(sorted, tiles.end(),
+                          [&](auto& entry) { return entry.first == _tileID; });
+
+        if (it == tiles.end()) { return nullptr; }
+    }
+
+    if (it->second.m_removed) { return nullptr; }
+
+    return &it->second;
+}
+
+TileManager::TileEntry& TileManager::TileSet::emplaceTile(const TileID& _tileID, std::shared_ptr<Tile> _tile) {
+
+    assert(!findTile(_tileID));
+
+    tiles.emplace_back(_tileID, TileEntry(std::move(_tile)));
+
+    return tiles.back().second;
+}
+
+void TileManager::TileSet::sortTiles() {
+
+    auto removed = [](auto& entry) { return entry.second.m_removed; };
+    auto compare = [](auto& a, auto& b) { return a.first < b.first; };
+
+    auto sorted = std::remove_if(tiles.begin(), tiles.begin() + sortedTiles, removed);
+    auto added = std::remove_if(tiles.begin() + sortedTiles, tiles.end(), removed);
+
+    size_t numSorted = sorted - tiles.begin();
+
+    added = std::move(tiles.begin() + sortedTiles, added, sorted);
+    tiles.erase(added, tiles.end());
+
+    sorted = tiles.begin() + numSorted;
+    std::sort(sorted, tiles.end(), compare);
+    std::inplace_merge(tiles.begin(), sorted, tiles.end(), compare);
+
+    sortedTiles = tiles.size();
+}
+
+bool TileManager::useDiskCache(const TileSet& _tileSet) const {
+    // Client data and rasters exist only at runtime
+    return m_tileDiskCache && !_tileSet.clientTileSource &&
+        !_tileSet.source->isRaster() && _tileSet.source->rasterSources().empty();
+}
+
 }
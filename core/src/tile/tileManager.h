@@ -7,11 +7,10 @@
 #include "tile/tileTask.h"
 #include "tile/tileWorker.h"
 
-#include <map>
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <tuple>
-#include <set>
 #include <vector>
 
 class Platform;
@@ -20,6 +19,9 @@ namespace Tangram {
 
 class TileSource;
 class TileCache;
+class TileCachePolicy;
+class TileDataCache;
+class TileDiskCache;
 class View;
 struct ViewState;
 
@@ -31,6 +33,8 @@ struct ViewState;
 class TileManager {
 
     const static size_t DEFAULT_CACHE_SIZE = 32*1024*1024; // 32 MB
+    const static size_t DEFAULT_DATA_CACHE_SIZE = 16*1024*1024; // 16 MB
+    const static size_t DEFAULT_PREFETCH_BUDGET = 8;
 
 public:
 
@@ -41,8 +45,20 @@ public:
     /* Sets the tile TileSources */
     void setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources);
 
-    /* Updates visible tile set and load missing tiles */
-    void updateTileSets(const View& _view);
+    struct PrefetchStats {
+        // Prefetch tasks created
+        size_t requests = 0;
+        // Prefetched tiles that became visible
+        size_t hits = 0;
+        // Prefetched tiles that were dropped before becoming visible
+        size_t misses = 0;
+    };
+
+    /* Updates visible tile set and load missing tiles.
+     * @_prefetchView: Optional prediction of the view in the near future. Tiles
+     * visible in it are loaded after the visible tiles, see setPrefetchBudget().
+     */
+    void updateTileSets(const View& _view, const View* _prefetchView = nullptr);
 
     void clearTileSets();
 
@@ -65,6 +81,9 @@ public:
 
     std::unique_ptr<TileCache>& getTileCache() { return m_tileCache; }
 
+    /* Set the replacement policy of the tile cache, default is LRU */
+    void setCachePolicy(std::unique_ptr<TileCachePolicy> _policy);
+
     const auto& getTileSets() { return m_tileSets; }
 
     /* @_cacheSize: Set size of in-memory tile cache in bytes.
@@ -72,6 +91,26 @@ public:
      */
     void setCacheSize(size_t _cacheSize);
 
+    const std::shared_ptr<TileDataCache>& getTileDataCache() { return m_tileDataCache; }
+
+    /* @_cacheSize: Set size of in-memory cache for parsed tile data in bytes.
+     * This cache holds <TileData> of recently built tiles, so that tiles can be
+     * rebuilt without parsing their data again.
+     */
+    void setDataCacheSize(size_t _cacheSize);
+
+    /* Set a persistent cache for built tiles, nullptr to disable it.
+     * Tiles of TileSources loading remote or MBTiles data are looked up
+     * in the cache before their data is loaded. Clears all TileSets. */
+    void setTileDiskCache(std::shared_ptr<TileDiskCache> _cache);
+
+    const std::shared_ptr<TileDiskCache>& getTileDiskCache() { return m_tileDiskCache; }
+
+    /* @_budget: Maximum number of tiles per TileSet loaded for the prefetch view */
+    void setPrefetchBudget(size_t _budget) { m_prefetchBudget = _budget; }
+
+    const PrefetchStats& getPrefetchStats() const { return m_prefetchStats; }
+
 protected:
 
     enum class ProxyID : uint8_t {
@@ -87,7 +126,10 @@ protected:
     struct TileEntry {
 
         TileEntry(){}
-        TileEntry(std::shared_ptr<Tile>& _tile) : tile(_tile) {}
+        TileEntry(std::shared_ptr<Tile> _tile) : tile(std::move(_tile)) {}
+
+        TileEntry(TileEntry&& _other) = default;
+        TileEntry& operator=(TileEntry&& _other) = default;
 
         ~TileEntry() { clearTask(); }
 
@@ -179,6 +221,16 @@ protected:
 
         bool m_visible = false;
 
+        /* Whether this tile was requested for the prefetch view
+         * and has not been visible since.
+         */
+        bool m_prefetch = false;
+
+        /* Whether this tile was removed from its TileSet,
+         * the entry is erased on TileSet::sortTiles()
+         */
+        bool m_removed = false;
+
         /* Method to check whther this tile is in the current set of visible tiles
          * determined by view::updateTiles().
          */
@@ -197,19 +249,65 @@ protected:
 
         std::shared_ptr<TileSource> source;
 
-        std::set<TileID> visibleTiles;
-        std::map<TileID, TileEntry> tiles;
+        /* Sorted and unique */
+        std::vector<TileID> visibleTiles;
+        std::vector<TileID> prefetchTiles;
+
+        /* Entries sorted by TileID up to sortedTiles, followed by the entries
+         * added since the last sortTiles() in order of insertion. Appending
+         * entries keeps references to others valid as long as the capacity
+         * of tiles suffices, see updateTileSet().
+         */
+        std::vector<std::pair<TileID, TileEntry>> tiles;
+        size_t sortedTiles = 0;
 
         int64_t sourceGeneration = 0;
         bool clientTileSource;
+
+        /* Returns the entry of @_tileID or nullptr when the tile is not in the TileSet */
+        TileEntry* findTile(const TileID& _tileID);
+
+        /* Appends an entry for @_tileID, which must not be in the TileSet */
+        TileEntry& emplaceTile(const TileID& _tileID, std::shared_ptr<Tile> _tile = nullptr);
+
+        /* Erases removed entries and merges the added entries into the sorted ones */
+        void sortTiles();
+
+        void clearTiles() {
+            tiles.clear();
+            sortedTiles = 0;
+        }
+
+        bool isVisible(const TileID& _tileID) const {
+            return std::binary_search(visibleTiles.begin(), visibleTiles.end(), _tileID);
+        }
+
+        bool isPrefetched(const TileID& _tileID) const {
+            return std::binary_search(prefetchTiles.begin(), prefetchTiles.end(), _tileID);
+        }
     };
 
     void updateTileSet(TileSet& tileSet, const ViewState& _view);
 
+    /* Update the entry of a tile in the visible set of @_tileSet: enqueue
+     * it for loading when needed and add it to the tiles for rendering */
+    void updateVisibleTile(TileSet& _tileSet, const TileID& _tileID, TileEntry& _entry,
+                           const ViewState& _view, bool _newTiles);
+
+    /* Select the tiles of @_prefetchView that are not yet visible, up to the prefetch budget */
+    void updatePrefetchTiles(TileSet& _tileSet, const std::vector<TileID>& _prefetchView,
+                             const ViewState& _view);
+
+    /* Add a TileEntry and load task for a tile that is expected to become visible */
+    void addPrefetchTile(TileSet& _tileSet, const TileID& _tileID);
+
     void enqueueTask(TileSet& _tileSet, const TileID& _tileID, const ViewState& _view);
 
     void loadTiles();
 
+    /* Whether tiles of @_tileSet can be stored in the TileDiskCache */
+    bool useDiskCache(const TileSet& _tileSet) const;
+
     /*
      * Constructs a future (async) to load data of a new visible tile this is
      *      also responsible for loading proxy tiles for the newly visible tiles
@@ -218,9 +316,9 @@ protected:
     bool addTile(TileSet& _tileSet, const TileID& _tileID);
 
     /*
-     * Removes a tile from m_tileSet
+     * Removes a tile from m_tileSet, the entry is erased on TileSet::sortTiles()
      */
-    void removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::iterator& _tileIter);
+    void removeTile(TileSet& _tileSet, const TileID& _tileID, TileEntry& _entry);
 
     /*
      * Checks and updates m_tileSet with proxy tiles for every new visible tile
@@ -244,6 +342,10 @@ protected:
 
     std::unique_ptr<TileCache> m_tileCache;
 
+    std::shared_ptr<TileDataCache> m_tileDataCache;
+
+    std::shared_ptr<TileDiskCache> m_tileDiskCache;
+
     TileTaskQueue& m_workers;
 
     bool m_tileSetChanged = false;
@@ -253,9 +355,21 @@ protected:
      */
     TileTaskCb m_dataCallback;
 
+    /* Callback for TileDiskCache:
+     * Loads the TileTask data when the tile was not in the cache
+     */
+    TileTaskCb m_diskCacheCallback;
+
     /* Temporary list of tiles that need to be loaded */
     std::vector<std::tuple<double, TileSet*, TileID>> m_loadTasks;
 
+    /* Tasks with changed priority or canceled during the current update */
+    std::vector<std::shared_ptr<TileTask>> m_updatedTasks;
+
+    size_t m_prefetchBudget = DEFAULT_PREFETCH_BUDGET;
+
+    PrefetchStats m_prefetchStats;
+
 };
 
 }
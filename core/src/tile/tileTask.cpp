@@ -1,29 +1,87 @@
 #include "tile/tileTask.h"
 
+#include "data/tileDataCache.h"
 #include "data/tileSource.h"
 #include "scene/scene.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
+#include "tile/tileDiskCache.h"
 #include "util/mapProjection.h"
 
+#include <chrono>
+
 namespace Tangram {
 
+static float elapsedMs(std::chrono::steady_clock::time_point _start) {
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - _start;
+    return elapsed.count();
+}
+
 TileTask::TileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, int _subTask) :
     m_tileId(_tileId),
     m_subTaskId(_subTask),
     m_source(_source),
     m_sourceGeneration(_source->generation()),
+    m_dataGeneration(_source->dataGeneration()),
     m_priority(0) {}
 
 void TileTask::process(TileBuilder& _tileBuilder) {
 
-    auto tileData = m_source->parse(*this, *_tileBuilder.scene().mapProjection());
+    decode(*_tileBuilder.scene().mapProjection());
+
+    if (!isCanceled()) {
+        build(_tileBuilder);
+    }
+}
+
+void TileTask::decode(const MapProjection& _projection) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto* cache = m_source->tileDataCache();
+
+    if (cache) {
+        m_tileData = cache->get(m_source->dataKey(), m_dataGeneration, m_tileId);
+        if (m_tileData) {
+            m_decodeTime = elapsedMs(start);
+            return;
+        }
+    }
+
+    m_tileData = m_source->parse(*this, _projection);
 
-    if (tileData) {
-        m_tile = _tileBuilder.build(m_tileId, *tileData, *m_source);
-    } else {
+    m_decodeTime = elapsedMs(start);
+
+    if (!m_tileData) {
         cancel();
+        return;
+    }
+
+    if (cache) {
+        cache->put(m_source->dataKey(), m_dataGeneration, m_tileId, m_tileData);
+    }
+}
+
+void TileTask::build(TileBuilder& _tileBuilder) {
+
+    if (!m_tileData) { return; }
+
+    auto start = std::chrono::steady_clock::now();
+
+    m_tile = _tileBuilder.build(m_tileId, *m_tileData, *m_source, &m_canceled);
+
+    if (m_tile) {
+        // Rebuild cost, used to weigh the tile in TileCache
+        m_tile->setBuildTime(m_decodeTime + elapsedMs(start));
+
+        // Store before the meshes are uploaded and their data is released
+        if (auto diskCache = tileDiskCache()) {
+            diskCache->put(*m_tile, *m_source, _tileBuilder.scene());
+        }
     }
+
+    // Release the decoded data as soon as the tile is built
+    m_tileData.reset();
 }
 
 void TileTask::complete() {
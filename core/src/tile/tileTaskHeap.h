@@ -0,0 +1,173 @@
+#pragma once
+
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/* Indexed binary min-heap of <TileTask>s, ordered by load priority.
+ *
+ * Each task stores its position in the heap so that a task whose priority
+ * changed can be sifted (or removed) in O(log n) without searching for it.
+ * Ordering keys are copied when a task is inserted or updated: changes of
+ * TileTask::getPriority() only take effect through update() or refresh().
+ *
+ * Not thread-safe, the owner must synchronize access.
+ */
+class TileTaskHeap {
+
+    struct Entry {
+        std::shared_ptr<TileTask> task;
+        float priority;
+        bool proxy;
+
+        void updateKey() {
+            priority = task->getPriority();
+            proxy = task->isProxy();
+        }
+    };
+
+public:
+
+    bool empty() const { return m_heap.empty(); }
+
+    size_t size() const { return m_heap.size(); }
+
+    void push(std::shared_ptr<TileTask> _task) {
+        if (_task->m_heapIndex >= 0) { return; }
+
+        m_heap.push_back({ std::move(_task), 0, false });
+        m_heap.back().updateKey();
+
+        setIndex(m_heap.size() - 1);
+        siftUp(m_heap.size() - 1);
+    }
+
+    /* Remove and return the task with highest priority */
+    std::shared_ptr<TileTask> pop() {
+        if (m_heap.empty()) { return nullptr; }
+
+        return removeAt(0);
+    }
+
+    /* Remove _task when it is queued, returns true if it was */
+    bool remove(TileTask& _task) {
+        if (!contains(_task)) { return false; }
+
+        removeAt(_task.m_heapIndex);
+        return true;
+    }
+
+    /* Re-read the priority of a queued _task and restore heap order */
+    void update(TileTask& _task) {
+        if (!contains(_task)) { return; }
+
+        size_t pos = _task.m_heapIndex;
+        m_heap[pos].updateKey();
+
+        if (!siftUp(pos)) { siftDown(pos); }
+    }
+
+    /* Re-read the priorities of all tasks, drop canceled tasks and rebuild the heap
+     * in O(n). Cheaper than update() when most of the tasks have changed. */
+    void refresh() {
+        size_t n = 0;
+        for (auto& entry : m_heap) {
+            if (entry.task->isCanceled()) {
+                entry.task->m_heapIndex = -1;
+                continue;
+            }
+            entry.updateKey();
+            m_heap[n++] = std::move(entry);
+        }
+        m_heap.resize(n);
+
+        for (size_t i = 0; i < n; i++) { setIndex(i); }
+
+        for (size_t i = n / 2; i-- > 0;) { siftDown(i); }
+    }
+
+    void clear() {
+        for (auto& entry : m_heap) { entry.task->m_heapIndex = -1; }
+        m_heap.clear();
+    }
+
+private:
+
+    bool contains(const TileTask& _task) const {
+        return _task.m_heapIndex >= 0 &&
+            size_t(_task.m_heapIndex) < m_heap.size() &&
+            m_heap[_task.m_heapIndex].task.get() == &_task;
+    }
+
+    static bool higherPriority(const Entry& a, const Entry& b) {
+        if (a.proxy != b.proxy) {
+            return !a.proxy;
+        }
+        if (a.task->source().id() == b.task->source().id() &&
+            a.task->sourceGeneration() != b.task->sourceGeneration()) {
+            return a.task->sourceGeneration() < b.task->sourceGeneration();
+        }
+        return a.priority < b.priority;
+    }
+
+    std::shared_ptr<TileTask> removeAt(size_t _pos) {
+        auto task = std::move(m_heap[_pos].task);
+        task->m_heapIndex = -1;
+
+        size_t last = m_heap.size() - 1;
+        if (_pos != last) {
+            m_heap[_pos] = std::move(m_heap[last]);
+            setIndex(_pos);
+        }
+        m_heap.pop_back();
+
+        if (_pos < m_heap.size() && !siftUp(_pos)) { siftDown(_pos); }
+
+        return task;
+    }
+
+    void setIndex(size_t _pos) {
+        m_heap[_pos].task->m_heapIndex = _pos;
+    }
+
+    void swap(size_t a, size_t b) {
+        std::swap(m_heap[a], m_heap[b]);
+        setIndex(a);
+        setIndex(b);
+    }
+
+    bool siftUp(size_t _pos) {
+        size_t start = _pos;
+        while (_pos > 0) {
+            size_t parent = (_pos - 1) / 2;
+            if (!higherPriority(m_heap[_pos], m_heap[parent])) { break; }
+            swap(_pos, parent);
+            _pos = parent;
+        }
+        return _pos != start;
+    }
+
+    void siftDown(size_t _pos) {
+        size_t n = m_heap.size();
+        while (true) {
+            size_t best = _pos;
+            size_t left = 2 * _pos + 1;
+            size_t right = left + 1;
+
+            if (left < n && higherPriority(m_heap[left], m_heap[best])) { best = left; }
+            if (right < n && higherPriority(m_heap[right], m_heap[best])) { best = right; }
+            if (best == _pos) { break; }
+
+            swap(_pos, best);
+            _pos = best;
+        }
+    }
+
+    std::vector<Entry> m_heap;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "map.h"
 #include "platform.h"
+#include "scene/scene.h"
 #include "tile/tileBuilder.h"
 #include "tile/tileID.h"
 #include "tile/tileTask.h"
@@ -12,15 +13,35 @@
 
 #define WORKER_NICENESS 10
 
+// Maximum number of tasks a worker moves from the shared queue
+// to its own queue at once
+#define WORKER_BATCH_SIZE 4
+
+// Number of decoded tasks per building thread that may wait to be built
+#define DECODED_TASKS_PER_WORKER 2
+
 namespace Tangram {
 
-TileWorker::TileWorker(std::shared_ptr<Platform> _platform, int _numWorker) : m_platform(_platform) {
+TileWorker::TileWorker(std::shared_ptr<Platform> _platform, int _numWorker, int _numDecoder)
+    : m_platform(_platform) {
     m_running = true;
 
     for (int i = 0; i < _numWorker; i++) {
-        auto worker = std::make_unique<Worker>();
-        worker->thread = std::thread(&TileWorker::run, this, worker.get());
-        m_workers.push_back(std::move(worker));
+        m_buildStage.workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < _numDecoder; i++) {
+        m_decodeStage.workers.push_back(std::make_unique<Worker>());
+    }
+    m_numDecoders = std::max(0, _numDecoder);
+
+    m_maxDecodedTasks = std::max(1, _numWorker * DECODED_TASKS_PER_WORKER);
+
+    // Start threads once all workers exist, they may steal from each other
+    for (auto& worker : m_buildStage.workers) {
+        worker->thread = std::thread(&TileWorker::runBuilder, this, worker.get());
+    }
+    for (auto& worker : m_decodeStage.workers) {
+        worker->thread = std::thread(&TileWorker::runDecoder, this, worker.get());
     }
 }
 
@@ -30,88 +51,305 @@ TileWorker::~TileWorker(){
     }
 }
 
-void TileWorker::run(Worker* instance) {
+std::shared_ptr<TileTask> TileWorker::popLocalTask(Stage& _stage, Worker& _worker) {
+    std::lock_guard<std::mutex> lock(_worker.mutex);
 
-    setCurrentThreadPriority(WORKER_NICENESS);
+    if (_worker.queue.empty()) { return nullptr; }
 
-    std::unique_ptr<TileBuilder> builder;
+    auto task = std::move(_worker.queue.front());
+    _worker.queue.pop_front();
+    _stage.localTasks--;
 
-    while (true) {
+    return task;
+}
 
-        std::shared_ptr<TileTask> task;
-        {
-            std::unique_lock<std::mutex> lock(m_mutex);
+std::shared_ptr<TileTask> TileWorker::takeSharedTasks(Stage& _stage, Worker& _worker) {
 
-            m_condition.wait(lock, [&, this]{
-                    return !m_running || !m_queue.empty();
-                });
+    // Leave enough tasks in the shared queue for the other workers
+    size_t count = _stage.queue.size() / _stage.workers.size();
+    count = std::max(size_t(1), std::min(count, size_t(WORKER_BATCH_SIZE)));
 
-            if (instance->tileBuilder) {
-                builder = std::move(instance->tileBuilder);
-                LOG("Passed new TileBuilder to TileWorker");
-            }
+    std::shared_ptr<TileTask> task;
+    size_t batched = 0;
 
-            // Check if thread should stop
-            if (!m_running) {
-                break;
-            }
+    while (!_stage.queue.empty() && batched < count) {
+        // Pop highest priority tile from queue
+        auto next = _stage.queue.pop();
 
-            if (!builder) {
-                continue;
-            }
+        // Canceled tasks that were not reported by updateTasks()
+        if (next->isCanceled()) { continue; }
 
-            // Remove all canceled tasks
-            auto removes = std::remove_if(m_queue.begin(), m_queue.end(),
-                                          [](const auto& a) { return a->isCanceled(); });
+        if (!task) {
+            task = std::move(next);
+            batched++;
+            continue;
+        }
 
-            m_queue.erase(removes, m_queue.end());
+        std::lock_guard<std::mutex> lock(_worker.mutex);
+        _worker.queue.push_back(std::move(next));
+        _stage.localTasks++;
+        batched++;
+    }
 
-            if (m_queue.empty()) {
-                continue;
-            }
+    if (batched > 1) {
+        // Let idle workers steal from this batch
+        _stage.condition.notify_all();
+    }
 
-            // Pop highest priority tile from queue
-            auto it = std::min_element(m_queue.begin(), m_queue.end(),
-                [](const auto& a, const auto& b) {
-                    if (a->isProxy() != b->isProxy()) {
-                        return !a->isProxy();
-                    }
-                    if (a->source().id() == b->source().id() &&
-                        a->sourceGeneration() != b->sourceGeneration()) {
-                        return a->sourceGeneration() < b->sourceGeneration();
-                    }
-                    return a->getPriority() < b->getPriority();
-                });
+    return task;
+}
+
+std::shared_ptr<TileTask> TileWorker::stealTask(Stage& _stage, Worker& _thief) {
+
+    for (auto& worker : _stage.workers) {
+        if (worker.get() == &_thief) { continue; }
+
+        std::lock_guard<std::mutex> lock(worker->mutex);
+
+        if (worker->queue.empty()) { continue; }
+
+        auto task = std::move(worker->queue.back());
+        worker->queue.pop_back();
+        _stage.localTasks--;
+
+        return task;
+    }
+
+    return nullptr;
+}
 
-            task = std::move(*it);
-            m_queue.erase(it);
+template<typename F>
+std::shared_ptr<TileTask> TileWorker::nextTask(Stage& _stage, Worker& _worker, bool _ready, F _update) {
+
+    if (_ready) {
+        auto task = popLocalTask(_stage, _worker);
+        if (task) { return task; }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    _stage.condition.wait(lock, [&, this]{
+            return !m_running || !_stage.running || !_stage.queue.empty() || _stage.localTasks > 0;
+        });
+
+    // Check if thread should stop
+    if (!m_running || !_stage.running) { return nullptr; }
+
+    if (!_update()) { return nullptr; }
+
+    auto task = takeSharedTasks(_stage, _worker);
+
+    if (!task) {
+        lock.unlock();
+        task = stealTask(_stage, _worker);
+    }
+
+    return task;
+}
+
+void TileWorker::runBuilder(Worker* instance) {
+
+    setCurrentThreadPriority(WORKER_NICENESS);
+
+    std::unique_ptr<TileBuilder> builder;
+
+    while (m_running) {
+
+        auto task = nextTask(m_buildStage, *instance, bool(builder), [&]() {
+                if (instance->tileBuilder) {
+                    builder = std::move(instance->tileBuilder);
+                    LOG("Passed new TileBuilder to TileWorker");
+                }
+                return bool(builder);
+            });
+
+        if (!task) { continue; }
+
+        if (isPipelined()) {
+            // Wake up a decoder waiting for space in the build queue
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_decodedTasksCondition.notify_one();
         }
 
         if (task->isCanceled()) {
             continue;
         }
 
-        task->process(*builder);
+        int concurrency = m_builderConcurrency;
+        if (builder->concurrency() != concurrency) {
+            builder->setConcurrency(concurrency);
+        }
+
+        // Tasks that were queued before decoders were started
+        // or after they were stopped are not decoded yet
+        if (task->tileData()) {
+            task->build(*builder);
+        } else {
+            task->process(*builder);
+        }
+
+        auto stats = builder->takeStats();
+        m_canceledBuilds += stats.canceled;
+        m_skippedFeatures += stats.skippedFeatures;
+
+        size_t peak = m_peakArenaSize;
+        while (stats.peakArenaSize > peak &&
+               !m_peakArenaSize.compare_exchange_weak(peak, stats.peakArenaSize)) {}
 
         m_platform->requestRender();
     }
 }
 
+void TileWorker::runDecoder(Worker* instance) {
+
+    setCurrentThreadPriority(WORKER_NICENESS);
+
+    std::shared_ptr<Scene> scene;
+
+    while (m_running && m_decodeStage.running) {
+
+        auto task = nextTask(m_decodeStage, *instance, bool(scene), [&]() {
+                scene = m_scene;
+                return bool(scene);
+            });
+
+        if (!task || task->isCanceled()) { continue; }
+
+        task->decode(*scene->mapProjection());
+
+        if (task->isCanceled()) { continue; }
+
+        if (!task->tileData()) {
+            // Nothing to build, e.g. for raster sub-tasks
+            m_platform->requestRender();
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // Decoders that are being stopped pass on their last task
+            m_decodedTasksCondition.wait(lock, [&, this]{
+                    return !m_running || !m_decodeStage.running ||
+                        m_buildStage.size() < m_maxDecodedTasks;
+                });
+
+            if (!m_running) { break; }
+
+            m_buildStage.queue.push(std::move(task));
+        }
+
+        m_buildStage.condition.notify_one();
+    }
+}
+
+TileWorker::Stats TileWorker::getStats() {
+    Stats stats;
+    stats.canceledBuilds = m_canceledBuilds;
+    stats.skippedFeatures = m_skippedFeatures;
+    stats.peakArenaSize = m_peakArenaSize.exchange(0);
+    return stats;
+}
+
 void TileWorker::setScene(std::shared_ptr<Scene>& _scene) {
-    for (auto& worker : m_workers) {
-        worker->tileBuilder = std::make_unique<TileBuilder>(_scene);
+    for (auto& worker : m_buildStage.workers) {
+        auto builder = std::make_unique<TileBuilder>(_scene);
+        builder->setConcurrency(m_builderConcurrency);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        worker->tileBuilder = std::move(builder);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_scene = _scene;
+}
+
+void TileWorker::setDecoders(int _numDecoder) {
+    _numDecoder = std::max(0, _numDecoder);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running || _numDecoder == m_numDecoders) { return; }
+
+        m_decodeStage.running = false;
+    }
+
+    m_decodeStage.condition.notify_all();
+    m_decodedTasksCondition.notify_all();
+
+    for (auto& worker : m_decodeStage.workers) {
+        worker->thread.join();
     }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // Return the tasks taken by the stopped decoders
+        for (auto& worker : m_decodeStage.workers) {
+            for (auto& task : worker->queue) {
+                m_decodeStage.queue.push(std::move(task));
+            }
+        }
+        m_decodeStage.workers.clear();
+        m_decodeStage.localTasks = 0;
+
+        // Without decoders the building threads decode the queued tasks
+        if (_numDecoder == 0) {
+            while (!m_decodeStage.queue.empty()) {
+                m_buildStage.queue.push(m_decodeStage.queue.pop());
+            }
+        }
+
+        for (int i = 0; i < _numDecoder; i++) {
+            m_decodeStage.workers.push_back(std::make_unique<Worker>());
+        }
+
+        m_numDecoders = _numDecoder;
+        m_decodeStage.running = true;
+    }
+
+    for (auto& worker : m_decodeStage.workers) {
+        worker->thread = std::thread(&TileWorker::runDecoder, this, worker.get());
+    }
+
+    m_buildStage.condition.notify_all();
 }
 
 void TileWorker::enqueue(std::shared_ptr<TileTask> task) {
+    Stage* stage;
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         if (!m_running) {
             return;
         }
-        m_queue.push_back(std::move(task));
+        stage = isPipelined() ? &m_decodeStage : &m_buildStage;
+        stage->queue.push(std::move(task));
+    }
+    stage->condition.notify_one();
+}
+
+void TileWorker::updateTasks(const std::vector<std::shared_ptr<TileTask>>& _tasks) {
+
+    if (_tasks.empty()) { return; }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (auto* stage : { &m_decodeStage, &m_buildStage }) {
+
+        if (_tasks.size() * 4 > stage->queue.size()) {
+            // Most of the queue changed: rebuild in O(n)
+            stage->queue.refresh();
+            continue;
+        }
+
+        for (auto& task : _tasks) {
+            if (task->isCanceled()) {
+                stage->queue.remove(*task);
+            } else {
+                stage->queue.update(*task);
+            }
+        }
     }
-    m_condition.notify_one();
 }
 
 void TileWorker::stop() {
@@ -120,13 +358,21 @@ void TileWorker::stop() {
         m_running = false;
     }
 
-    m_condition.notify_all();
+    m_decodedTasksCondition.notify_all();
 
-    for (auto& worker : m_workers) {
-        worker->thread.join();
+    for (auto* stage : { &m_decodeStage, &m_buildStage }) {
+        stage->condition.notify_all();
+
+        for (auto& worker : stage->workers) {
+            worker->thread.join();
+            worker->queue.clear();
+        }
+
+        stage->localTasks = 0;
+        stage->queue.clear();
     }
 
-    m_queue.clear();
+    m_scene.reset();
 }
 
 }
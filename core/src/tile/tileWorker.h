@@ -1,10 +1,13 @@
 #pragma once
 
 #include "tile/tileTask.h"
+#include "tile/tileTaskHeap.h"
 #include "util/jobQueue.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -21,35 +24,126 @@ class TileWorker : public TileTaskQueue {
 
 public:
 
-    TileWorker(std::shared_ptr<Platform> _platform, int _numWorker);
+    /* @_numWorker: Number of threads building tiles.
+     * @_numDecoder: Number of threads decoding raw tile data. Without decoders
+     * each worker decodes and builds its tasks, otherwise decoded tasks are
+     * passed to the building threads through a bounded queue.
+     */
+    TileWorker(std::shared_ptr<Platform> _platform, int _numWorker, int _numDecoder = 0);
 
     ~TileWorker();
 
     virtual void enqueue(std::shared_ptr<TileTask> task) override;
 
+    virtual void updateTasks(const std::vector<std::shared_ptr<TileTask>>& tasks) override;
+
     void stop();
 
     bool isRunning() const { return m_running; }
 
     void setScene(std::shared_ptr<Scene>& _scene);
 
+    /* Set the number of threads decoding raw tile data, 0 to decode each
+     * task on the thread that builds it. Queued tasks are kept. */
+    void setDecoders(int _numDecoder);
+
+    int decoders() const { return m_numDecoders; }
+
+    /* Number of threads each TileBuilder uses to build a single tile,
+     * see TileBuilder::setConcurrency(). Applies from the next tile a worker builds. */
+    void setBuilderConcurrency(int _threads) { m_builderConcurrency = std::max(1, _threads); }
+
+    int builderConcurrency() const { return m_builderConcurrency; }
+
+    struct Stats {
+        // Builds that stopped early because their task was canceled
+        size_t canceledBuilds = 0;
+        // Features that canceled builds did not style
+        size_t skippedFeatures = 0;
+        // Largest arena a TileBuilder used for a single tile
+        // since the previous call of getStats()
+        size_t peakArenaSize = 0;
+    };
+
+    Stats getStats();
+
 private:
 
     struct Worker {
         std::thread thread;
         std::unique_ptr<TileBuilder> tileBuilder;
+
+        // Tasks this worker has taken from the shared queue. The owner
+        // pops from the front, idle workers steal from the back.
+        std::mutex mutex;
+        std::deque<std::shared_ptr<TileTask>> queue;
+    };
+
+    // Workers that share one task queue
+    struct Stage {
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        TileTaskHeap queue;
+
+        // Number of tasks in per-worker queues that can be stolen
+        std::atomic<int> localTasks{0};
+
+        // Cleared to stop the workers of this stage only
+        std::atomic<bool> running{true};
+
+        std::condition_variable condition;
+
+        size_t size() const { return queue.size() + localTasks; }
     };
 
-    void run(Worker* instance);
+    void runDecoder(Worker* instance);
+
+    void runBuilder(Worker* instance);
+
+    bool isPipelined() const { return m_numDecoders > 0; }
+
+    // Wait for the next task of _stage. _update is called with m_mutex
+    // locked to refresh the workers' state and returns whether the worker
+    // is ready to process tasks. Returns nullptr when there is nothing to
+    // do (yet), e.g. when no scene is set.
+    template<typename F>
+    std::shared_ptr<TileTask> nextTask(Stage& _stage, Worker& _worker, bool _ready, F _update);
+
+    // Pop the next task from the workers' own queue
+    std::shared_ptr<TileTask> popLocalTask(Stage& _stage, Worker& _worker);
+
+    // Take the highest priority task from the shared queue and move a
+    // batch of the following tasks to the workers' own queue.
+    // Must be called with m_mutex locked.
+    std::shared_ptr<TileTask> takeSharedTasks(Stage& _stage, Worker& _worker);
+
+    // Take the lowest priority task queued by another worker
+    std::shared_ptr<TileTask> stealTask(Stage& _stage, Worker& _thief);
+
+    std::atomic<bool> m_running;
+
+    // Tasks are decoded in the first stage when pipelined,
+    // otherwise only the build stage is used.
+    Stage m_decodeStage;
+    Stage m_buildStage;
+
+    // Number of decoding threads, read by other threads
+    // while m_decodeStage.workers is replaced
+    std::atomic<int> m_numDecoders{0};
+
+    // Maximum number of decoded tasks waiting to be built
+    size_t m_maxDecodedTasks = 0;
+    std::condition_variable m_decodedTasksCondition;
 
-    bool m_running;
+    std::shared_ptr<Scene> m_scene;
 
-    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<int> m_builderConcurrency{1};
 
-    std::condition_variable m_condition;
+    std::atomic<size_t> m_canceledBuilds{0};
+    std::atomic<size_t> m_skippedFeatures{0};
+    std::atomic<size_t> m_peakArenaSize{0};
 
     std::mutex m_mutex;
-    std::vector<std::shared_ptr<TileTask>> m_queue;
 
     std::shared_ptr<Platform> m_platform;
 };
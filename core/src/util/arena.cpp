@@ -0,0 +1,87 @@
+#include "util/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Tangram {
+
+Arena::Arena(size_t _blockSize, size_t _maxCapacity)
+    : m_blockSize(_blockSize), m_maxCapacity(_maxCapacity) {}
+
+void* Arena::allocate(size_t _size, size_t _alignment) {
+
+    auto align = [&](char* _ptr) {
+        auto address = reinterpret_cast<uintptr_t>(_ptr);
+        return _ptr + (-address & (_alignment - 1));
+    };
+
+    char* ptr = align(m_current);
+
+    if (!m_current || size_t(m_end - ptr) < _size || ptr > m_end) {
+        // Continue with the next block that is large enough,
+        // the rest of the current block stays unused until reset()
+        size_t block = m_current ? m_block + 1 : 0;
+        while (block < m_blocks.size() && m_blocks[block].size < _size + _alignment) {
+            block++;
+        }
+        if (block == m_blocks.size()) {
+            size_t size = std::max(m_blockSize, _size + _alignment);
+            m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        }
+        useBlock(block);
+        ptr = align(m_current);
+    }
+
+    m_size += (ptr - m_current) + _size;
+    m_peakSize = std::max(m_peakSize, m_size);
+    m_current = ptr + _size;
+
+    return ptr;
+}
+
+void Arena::deallocate(void* _ptr, size_t _size) {
+
+    char* ptr = static_cast<char*>(_ptr);
+
+    if (ptr + _size == m_current) {
+        m_current = ptr;
+        m_size -= _size;
+    }
+}
+
+void Arena::reset() {
+
+    size_t size = std::min(capacity(), m_maxCapacity);
+
+    if (m_blocks.size() > 1 || (!m_blocks.empty() && m_blocks[0].size > size)) {
+        // Replace the blocks by one that fits all, the next
+        // tasks are likely to need about as much memory
+        m_blocks.clear();
+        if (size > 0) {
+            m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        }
+    }
+
+    if (m_blocks.empty()) {
+        m_current = m_end = nullptr;
+    } else {
+        useBlock(0);
+    }
+
+    m_size = 0;
+    m_peakSize = 0;
+}
+
+size_t Arena::capacity() const {
+    size_t capacity = 0;
+    for (auto& block : m_blocks) { capacity += block.size; }
+    return capacity;
+}
+
+void Arena::useBlock(size_t _block) {
+    m_block = _block;
+    m_current = m_blocks[_block].data.get();
+    m_end = m_current + m_blocks[_block].size;
+}
+
+}
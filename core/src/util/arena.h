@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * Monotonic allocator for short-lived memory that is released all at once.
+ *
+ * Allocations are taken from large blocks and only released by reset(). Freeing
+ * the most recent allocation returns its memory to the arena, so that scratch
+ * storage which is created and destroyed per feature does not accumulate.
+ * After reset() the blocks are kept, merged into one block when more than one
+ * was needed, and trimmed to at most @_maxCapacity bytes so that a single large
+ * task does not hold on to its memory. An Arena is not thread-safe.
+ */
+class Arena {
+
+public:
+
+    explicit Arena(size_t _blockSize = 64 * 1024,
+                   size_t _maxCapacity = std::numeric_limits<size_t>::max());
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t _size, size_t _alignment);
+
+    // Only returns memory to the arena when @_ptr is the last allocation
+    void deallocate(void* _ptr, size_t _size);
+
+    // Release all allocations and trim the blocks to the maximum capacity
+    void reset();
+
+    // Bytes currently allocated
+    size_t size() const { return m_size; }
+
+    // Maximum of size() since the last reset()
+    size_t peakSize() const { return m_peakSize; }
+
+    // Bytes held in blocks
+    size_t capacity() const;
+
+private:
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    // Make @_block the current block
+    void useBlock(size_t _block);
+
+    size_t m_blockSize;
+    size_t m_maxCapacity;
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;
+
+    char* m_current = nullptr;
+    char* m_end = nullptr;
+
+    size_t m_size = 0;
+    size_t m_peakSize = 0;
+};
+
+/*
+ * Standard allocator that takes memory from an Arena,
+ * or from the heap when constructed without an Arena.
+ */
+template<typename T>
+struct ArenaAllocator {
+
+    using value_type = T;
+
+    ArenaAllocator(Arena* _arena = nullptr) noexcept : arena(_arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& _other) noexcept : arena(_other.arena) {}
+
+    T* allocate(size_t _n) {
+        if (!arena) { return static_cast<T*>(::operator new(_n * sizeof(T))); }
+        return static_cast<T*>(arena->allocate(_n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* _ptr, size_t _n) noexcept {
+        if (!arena) {
+            ::operator delete(_ptr);
+        } else {
+            arena->deallocate(_ptr, _n * sizeof(T));
+        }
+    }
+
+    Arena* arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) { return _a.arena == _b.arena; }
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) { return _a.arena != _b.arena; }
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
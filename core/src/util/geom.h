@@ -66,10 +66,20 @@ struct BoundingBox {
     bool containsX(double x) const { return x >= min.x && x <= max.x; }
     bool containsY(double y) const { return y >= min.y && y <= max.y; }
     bool contains(double x, double y) const { return containsX(x) && containsY(y); }
+    bool intersects(const BoundingBox& _other) const {
+        return min.x <= _other.max.x && max.x >= _other.min.x &&
+               min.y <= _other.max.y && max.y >= _other.min.y;
+    }
     void expand(double x, double y) {
         min = { glm::min(min.x, x), glm::min(min.y, y) };
         max = { glm::max(max.x, x), glm::max(max.y, y) };
     }
+    void expand(const BoundingBox& _other) {
+        // Skip empty bounds, whose min is greater than max
+        if (_other.min.x > _other.max.x) { return; }
+        expand(_other.min.x, _other.min.y);
+        expand(_other.max.x, _other.max.y);
+    }
 };
 
 template<class InputIt>
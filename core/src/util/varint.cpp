@@ -0,0 +1,91 @@
+#include "util/varint.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VARINT_SSE2
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define VARINT_SWAR
+#endif
+
+namespace Tangram {
+
+// Decode the varint at @_p into @_value, returns the position after it
+static inline const uint8_t* decodeVarint(const uint8_t* _p, const uint8_t* _end, uint32_t& _value) {
+
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 70; shift += 7) {
+        if (_p == _end) {
+            throw std::runtime_error("unterminated varint, unexpected end of buffer");
+        }
+        uint8_t byte = *_p++;
+        value |= uint64_t(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80)) {
+            _value = static_cast<uint32_t>(value);
+            return _p;
+        }
+    }
+    throw std::runtime_error("unterminated varint (too long)");
+}
+
+size_t decodeVarints(const char* _begin, const char* _end, uint32_t* _out) {
+
+    auto* p = reinterpret_cast<const uint8_t*>(_begin);
+    auto* end = reinterpret_cast<const uint8_t*>(_end);
+    uint32_t* out = _out;
+
+    while (p < end) {
+
+#if defined(VARINT_SSE2)
+        if (end - p >= 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+            // Bit i is set when byte i is continued by the next byte
+            uint32_t mask = _mm_movemask_epi8(bytes);
+            int run = mask ? __builtin_ctz(mask) : 16;
+
+            if (run > 0) {
+                // Widen all 16 bytes, only the leading @run are complete varints
+                __m128i zero = _mm_setzero_si128();
+                __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+                __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+                auto* dst = reinterpret_cast<__m128i*>(out);
+                _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+
+                p += run;
+                out += run;
+                continue;
+            }
+        }
+#elif defined(VARINT_SWAR)
+        if (end - p >= 8) {
+            uint64_t bytes;
+            std::memcpy(&bytes, p, sizeof(bytes));
+
+            uint64_t mask = bytes & 0x8080808080808080ull;
+            int run = mask ? __builtin_ctzll(mask) / 8 : 8;
+
+            if (run > 0) {
+                for (int i = 0; i < 8; i++) { out[i] = p[i]; }
+
+                p += run;
+                out += run;
+                continue;
+            }
+        }
+#endif
+        p = decodeVarint(p, end, *out++);
+    }
+
+    return out - _out;
+}
+
+}
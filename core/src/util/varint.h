@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Number of values that decodeVarints() may write past the decoded values
+#define VARINT_DECODE_PADDING 16
+
+namespace Tangram {
+
+/* Decode the packed varints in [@_begin, @_end) into @_out and return their count.
+ *
+ * Runs of single-byte varints, which make up most of vector tile geometry, are
+ * widened 16 bytes at a time with SSE2, or 8 at a time on other little-endian
+ * targets. Other varints are decoded one by one. @_out must have room for
+ * (_end - _begin) + VARINT_DECODE_PADDING values. Values are truncated to 32 bits.
+ * Throws std::runtime_error when the last varint is not terminated. */
+size_t decodeVarints(const char* _begin, const char* _end, uint32_t* _out);
+
+inline int32_t zigzagDecode(uint32_t _value) {
+    return static_cast<int32_t>(_value >> 1) ^ -static_cast<int32_t>(_value & 1);
+}
+
+}
@@ -1,8 +1,13 @@
 #include "urlClient.h"
 #include "log.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-#include <curl/curl.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Interval of checks for background transfers to preempt, besides checks when requests are added
+#define PREEMPT_CHECK_INTERVAL std::chrono::milliseconds(100)
 
 namespace Tangram {
 
@@ -20,13 +25,28 @@ struct CurlGlobals {
 const char* requestCancelledError = "Request cancelled";
 
 UrlClient::UrlClient(Options options) : m_options(options) {
-    assert(options.numberOfThreads > 0);
-    // Start the curl threads.
-    m_keepRunning = true;
-    m_tasks.resize(options.numberOfThreads);
-    for (uint32_t i = 0; i < options.numberOfThreads; i++) {
-        m_threads.emplace_back(&UrlClient::curlLoop, this, i);
+    assert(options.maxActiveTasks > 0);
+
+    if (pipe(m_wakeUpPipe) != 0) {
+        LOGE("Unable to create wake up pipe for curl loop");
     }
+    for (int fd : m_wakeUpPipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    m_multi = curl_multi_init();
+    curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, long(options.maxActiveTasks));
+#if LIBCURL_VERSION_NUM >= 0x071e00
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, long(options.maxConnectionsPerHost));
+#endif
+    // Multiplexing needs HTTP/2, which is used over TLS since curl 7.47.0 (CURL_HTTP_VERSION_2TLS)
+#if LIBCURL_VERSION_NUM >= 0x072f00
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+    // Start the curl thread.
+    m_keepRunning = true;
+    m_thread = std::thread(&UrlClient::curlLoop, this);
 }
 
 UrlClient::~UrlClient() {
@@ -42,31 +62,37 @@ UrlClient::~UrlClient() {
             }
         }
         m_requests.clear();
-        for (auto& task : m_tasks) {
-            task.request.canceled = true;
-        }
+        // Stop the curl thread, it cancels the running transfers.
+        m_keepRunning = false;
     }
-    // Stop the curl threads.
-    m_keepRunning = false;
-    m_requestCondition.notify_all();
-    for (auto& thread : m_threads) {
-        thread.join();
+    wakeUp();
+    m_thread.join();
+
+    for (auto* handle : m_idleHandles) {
+        curl_easy_cleanup(handle);
+    }
+    curl_multi_cleanup(m_multi);
+
+    for (int fd : m_wakeUpPipe) {
+        if (fd >= 0) { close(fd); }
     }
 }
 
-UrlRequestHandle UrlClient::addRequest(const std::string& url, UrlCallback onComplete) {
-    // Create a new request.
-    m_requestCount++;
-    Request request = {url, onComplete, m_requestCount, false};
+UrlRequestHandle UrlClient::addRequest(const std::string& url, UrlCallback onComplete,
+                                       UrlPriorityCallback priority) {
+    UrlRequestHandle handle;
     // Add the request to our list.
     {
         // Lock the mutex to prevent concurrent modification of the list by the curl loop thread.
         std::lock_guard<std::mutex> lock(m_requestMutex);
-        m_requests.push_back(request);
+        // Create a new request.
+        handle = ++m_requestCount;
+        m_requests.push_back({url, onComplete, handle, priority});
+        m_requestsAdded = true;
     }
-    // Notify a thread to start the transfer.
-    m_requestCondition.notify_one();
-    return m_requestCount;
+    // Notify the curl thread to start the transfer.
+    wakeUp();
+    return handle;
 }
 
 void UrlClient::cancelRequest(UrlRequestHandle handle) {
@@ -75,27 +101,23 @@ void UrlClient::cancelRequest(UrlRequestHandle handle) {
     {
         // Lock the mutex to prevent concurrent modification of the list by the curl loop thread.
         std::lock_guard<std::mutex> lock(m_requestMutex);
-        for (auto it = m_requests.begin(), end = m_requests.end(); it != end; ++it) {
-            auto& request = *it;
-            if (request.handle == handle) {
-                // Found the request! Now run its callback and remove it.
-                callback = std::move(request.callback);
-                m_requests.erase(it);
-                break;
-            }
+        auto it = std::find_if(m_requests.begin(), m_requests.end(),
+                               [&](const Request& request) { return request.handle == handle; });
+        if (it != m_requests.end()) {
+            // Found the request! Now run its callback and remove it.
+            callback = std::move(it->callback);
+            m_requests.erase(it);
+        } else {
+            // The request may be running, the curl thread removes it.
+            m_canceled.push_back(handle);
         }
     }
     // We run the callback outside of the mutex lock to prevent deadlock in case the callback
     // makes further calls into this UrlClient.
     if (callback) {
         callback(getCanceledResponse());
-    }
-
-    // Next check the active request list.
-    for (auto& task : m_tasks) {
-        if (task.request.handle == handle) {
-            task.request.canceled = true;
-        }
+    } else {
+        wakeUp();
     }
 }
 
@@ -116,84 +138,236 @@ size_t UrlClient::curlWriteCallback(char* ptr, size_t size, size_t n, void* user
     return addedSize;
 }
 
-int UrlClient::curlProgressCallback(void* user, double dltotal, double dlnow, double ultotal, double ulnow) {
-    // Signals libCURL to abort the request if marked as canceled.
-    auto* task = reinterpret_cast<UrlClient::Task*>(user);
-    return static_cast<int>(task->request.canceled);
+void UrlClient::wakeUp() {
+    char byte = 0;
+    if (write(m_wakeUpPipe[1], &byte, 1) < 0) {
+        // The pipe is full, the curl loop wakes up anyway.
+    }
 }
 
-void UrlClient::curlLoop(uint32_t index) {
-    assert(m_tasks.size() > index);
-    Task& task = m_tasks[index];
-    LOGD("curlLoop %u starting", index);
-    // Create a buffer for curl error messages.
-    char curlErrorString[CURL_ERROR_SIZE] = {0};
-    // Set up an easy handle for reuse.
-    auto handle = curl_easy_init();
-    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curlWriteCallback);
-    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &task.response);
-    curl_easy_setopt(handle, CURLOPT_PROGRESSFUNCTION, &curlProgressCallback);
-    curl_easy_setopt(handle, CURLOPT_PROGRESSDATA, &task);
-    curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
-    curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
-    curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
-    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip");
-    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, curlErrorString);
-    curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
-    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, m_options.connectionTimeoutMs);
-    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, m_options.requestTimeoutMs);
-    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1);
-    curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 20);
+void UrlClient::startPendingRequests(bool _preempt) {
+    if (m_requests.empty()) { return; }
+
+    size_t freeSlots = m_options.maxActiveTasks - std::min<size_t>(m_tasks.size(), m_options.maxActiveTasks);
+    if (freeSlots == 0 && !_preempt) { return; }
+
+    // Order the pending requests by their current priority, the stable sort keeps
+    // requests of the same priority in the order they were added.
+    std::vector<std::pair<UrlRequestPriority, size_t>> pending;
+    pending.reserve(m_requests.size());
+    for (size_t i = 0; i < m_requests.size(); i++) {
+        pending.emplace_back(m_requests[i].getPriority(), i);
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](auto& a, auto& b) { return a.first < b.first; });
+
+    if (_preempt && freeSlots < pending.size() && !pending[freeSlots].first.background) {
+        // Foreground requests wait for a transfer, abort the lowest priority background transfers.
+        std::vector<std::pair<UrlRequestPriority, Task*>> running;
+        for (auto& task : m_tasks) {
+            auto priority = task->request.getPriority();
+            if (priority.background) { running.emplace_back(priority, task.get()); }
+        }
+        std::sort(running.begin(), running.end(),
+                  [](auto& a, auto& b) { return b.first < a.first; });
+
+        for (auto& preempted : running) {
+            if (freeSlots >= pending.size() || pending[freeSlots].first.background) { break; }
+
+            auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
+                                   [&](auto& task) { return task.get() == preempted.second; });
+            auto& task = *it;
+            LOGD("curlLoop preempted request for url: %s", task->request.url.c_str());
+
+            curl_multi_remove_handle(m_multi, task->handle);
+            m_idleHandles.push_back(task->handle);
+
+            // The request is ordered again with the next pending requests
+            m_requests.push_back(std::move(task->request));
+            m_tasks.erase(it);
+            freeSlots++;
+        }
+    }
+
+    if (freeSlots == 0) { return; }
+
+    // Take the requests to start out of the queue.
+    std::vector<Request> start;
+    std::vector<bool> started(m_requests.size(), false);
+    for (size_t i = 0; i < std::min(freeSlots, pending.size()); i++) {
+        start.push_back(std::move(m_requests[pending[i].second]));
+        started[pending[i].second] = true;
+    }
+    std::deque<Request> remaining;
+    for (size_t i = 0; i < m_requests.size(); i++) {
+        if (!started[i]) { remaining.push_back(std::move(m_requests[i])); }
+    }
+    m_requests = std::move(remaining);
+
+    for (auto& request : start) {
+        auto task = std::make_unique<Task>();
+        task->request = std::move(request);
+
+        // Reuse an easy handle of a finished transfer, or set up a new one.
+        if (m_idleHandles.empty()) {
+            auto handle = curl_easy_init();
+            curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curlWriteCallback);
+            curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
+            curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
+            curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
+            curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip");
+            curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+            curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, long(m_options.connectionTimeoutMs));
+            curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, long(m_options.requestTimeoutMs));
+            curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 20L);
+            // Signals are not thread-safe, timeouts of name resolves are not needed.
+            curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+#if LIBCURL_VERSION_NUM >= 0x072f00
+            curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, long(CURL_HTTP_VERSION_2TLS));
+#endif
+            m_idleHandles.push_back(handle);
+        }
+        task->handle = m_idleHandles.back();
+        m_idleHandles.pop_back();
+
+        curl_easy_setopt(task->handle, CURLOPT_URL, task->request.url.c_str());
+        curl_easy_setopt(task->handle, CURLOPT_WRITEDATA, &task->response);
+        curl_easy_setopt(task->handle, CURLOPT_ERRORBUFFER, task->errorString);
+        curl_easy_setopt(task->handle, CURLOPT_PRIVATE, task.get());
+#if LIBCURL_VERSION_NUM >= 0x072f00
+        // Wait for a connection that the request can be multiplexed on instead of opening a new one.
+        // Only HTTPS connections use HTTP/2, others would wait for the previous transfer to start.
+        bool https = task->request.url.compare(0, 6, "https:") == 0;
+        curl_easy_setopt(task->handle, CURLOPT_PIPEWAIT, long(https));
+#endif
+
+        LOGD("curlLoop starting request for url: %s", task->request.url.c_str());
+        curl_multi_add_handle(m_multi, task->handle);
+        m_tasks.push_back(std::move(task));
+    }
+}
+
+void UrlClient::finishTask(std::unique_ptr<Task> _task, const char* _error) {
+    curl_multi_remove_handle(m_multi, _task->handle);
+    m_idleHandles.push_back(_task->handle);
+
+    _task->response.error = _error;
+    // If a callback is given, always run it regardless of request result.
+    if (_task->request.callback) {
+        _task->request.callback(std::move(_task->response));
+    }
+}
+
+void UrlClient::curlLoop() {
+    LOGD("curlLoop starting");
+
+    // Tasks that finished in one iteration, their callbacks run without m_requestMutex held.
+    std::vector<std::pair<std::unique_ptr<Task>, const char*>> finished;
+
+    auto takeTask = [&](std::vector<std::unique_ptr<Task>>::iterator _it, const char* _error) {
+        finished.emplace_back(std::move(*_it), _error);
+        return m_tasks.erase(_it);
+    };
+
+    // Requests wait for a transfer slot
+    bool waiting = false;
+
     // Loop until the session is destroyed.
-    while (m_keepRunning) {
-        bool haveRequest = false;
-        // Wait until the condition variable is notified.
+    while (true) {
         {
-            std::unique_lock<std::mutex> lock(m_requestMutex);
-            if (m_requests.empty()) {
-                LOGD("curlLoop %u waiting", index);
-                m_requestCondition.wait(lock);
+            std::lock_guard<std::mutex> lock(m_requestMutex);
+
+            if (!m_keepRunning) {
+                for (auto it = m_tasks.begin(); it != m_tasks.end(); ) {
+                    it = takeTask(it, requestCancelledError);
+                }
+                break;
             }
-            LOGD("curlLoop %u notified", index);
-            // Try to get a request from the list.
-            if (!m_requests.empty()) {
-                // Take the first request from our list.
-                task.request = m_requests.front();
-                m_requests.erase(m_requests.begin());
-                haveRequest = true;
+
+            for (auto handle : m_canceled) {
+                auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
+                                       [&](auto& task) { return task->request.handle == handle; });
+                if (it != m_tasks.end()) {
+                    LOGD("curlLoop aborted request for url: %s", (*it)->request.url.c_str());
+                    takeTask(it, requestCancelledError);
+                }
             }
+            m_canceled.clear();
+
+            // Priorities change while requests wait, look for transfers to preempt
+            // when requests were added and in regular intervals.
+            auto now = std::chrono::steady_clock::now();
+            bool preempt = m_requestsAdded || now >= m_nextPreemptCheck;
+            if (preempt) {
+                m_requestsAdded = false;
+                m_nextPreemptCheck = now + PREEMPT_CHECK_INTERVAL;
+            }
+            startPendingRequests(preempt);
+            waiting = !m_requests.empty();
+        }
+
+        // Remove canceled transfers before they make progress.
+        for (auto& task : finished) {
+            finishTask(std::move(task.first), task.second);
         }
-        if (haveRequest) {
-            // Configure the easy handle.
-            const char* url = task.request.url.data();
-            curl_easy_setopt(handle, CURLOPT_URL, url);
-            LOGD("curlLoop %u starting request for url: %s", index, url);
-            // Perform the request.
-            auto result = curl_easy_perform(handle);
-            // Handle success or error.
-            if (result == CURLE_OK) {
-                LOGD("curlLoop %u succeeded for url: %s", index, url);
-                task.response.error = nullptr;
-            } else if (result == CURLE_ABORTED_BY_CALLBACK) {
-                LOGD("curlLoop %u aborted request for url: %s", index, url);
-                task.response.error = requestCancelledError;
+        finished.clear();
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        // Handle success or error of finished transfers.
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(m_multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) { continue; }
+
+            Task* done = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&done));
+
+            auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
+                                   [&](auto& task) { return task.get() == done; });
+            if (it == m_tasks.end()) { continue; }
+
+            if (msg->data.result == CURLE_OK) {
+                LOGD("curlLoop succeeded for url: %s", done->request.url.c_str());
+                takeTask(it, nullptr);
             } else {
-                LOGD("curlLoop %u failed with error '%s' for url: %s", index, curlErrorString, url);
-                task.response.error = curlErrorString;
-            }
-            // If a callback is given, always run it regardless of request result.
-            if (task.request.callback) {
-                LOGD("curlLoop %u performing request callback", index);
-                task.request.callback(task.response);
+                LOGD("curlLoop failed with error '%s' for url: %s", done->errorString, done->request.url.c_str());
+                takeTask(it, done->errorString);
             }
         }
-        // Reset the response.
-        task.response.content.clear();
-        task.response.error = nullptr;
+
+        {
+            // Free transfer slots for pending requests before their callbacks add more.
+            std::lock_guard<std::mutex> lock(m_requestMutex);
+            startPendingRequests(false);
+        }
+
+        for (auto& task : finished) {
+            finishTask(std::move(task.first), task.second);
+        }
+        finished.clear();
+
+        // Wait for network activity, a curl timeout or a wake up.
+        curl_waitfd wakeUpFd;
+        wakeUpFd.fd = m_wakeUpPipe[0];
+        wakeUpFd.events = CURL_WAIT_POLLIN;
+        wakeUpFd.revents = 0;
+
+        int timeoutMs = waiting ? PREEMPT_CHECK_INTERVAL.count() : 1000;
+        curl_multi_wait(m_multi, &wakeUpFd, 1, timeoutMs, nullptr);
+
+        if (wakeUpFd.revents) {
+            char buffer[64];
+            while (read(m_wakeUpPipe[0], buffer, sizeof(buffer)) > 0) {}
+        }
+    }
+
+    for (auto& task : finished) {
+        finishTask(std::move(task.first), task.second);
     }
-    LOGD("curlLoop %u exiting", index);
-    // Clean up our easy handle.
-    curl_easy_cleanup(handle);
+
+    LOGD("curlLoop exiting");
 }
 
 } // namespace Tangram
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "platform.h"
-#include <condition_variable>
+#include <curl/curl.h>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -10,12 +13,26 @@
 
 namespace Tangram {
 
+/* Runs URL requests with the curl multi interface on one thread.
+ *
+ * At most maxActiveTasks requests are transferred at once, the others wait
+ * ordered by their UrlRequestPriority, which is read again on every scheduling
+ * pass. Requests without priority and requests of the same priority are started
+ * in the order they were added. When all transfers are in use, background
+ * transfers are aborted and queued again for waiting foreground requests.
+ *
+ * Connections are kept open and reused, and HTTP/2 requests to the same host
+ * are multiplexed over one connection where the server supports it.
+ */
 class UrlClient {
 
 public:
 
     struct Options {
-        uint32_t numberOfThreads = 4;
+        // Requests that are transferred at the same time
+        uint32_t maxActiveTasks = 32;
+        // Connections that are opened to one host, further requests to it wait for one
+        uint32_t maxConnectionsPerHost = 8;
         uint32_t connectionTimeoutMs = 3000;
         uint32_t requestTimeoutMs = 30000;
     };
@@ -23,7 +40,8 @@ public:
     UrlClient(Options options);
     ~UrlClient();
 
-    UrlRequestHandle addRequest(const std::string& url, UrlCallback onComplete);
+    UrlRequestHandle addRequest(const std::string& url, UrlCallback onComplete,
+                                UrlPriorityCallback priority = nullptr);
 
     void cancelRequest(UrlRequestHandle request);
 
@@ -33,7 +51,11 @@ private:
         std::string url;
         UrlCallback callback;
         UrlRequestHandle handle;
-        bool canceled;
+        UrlPriorityCallback priority;
+
+        UrlRequestPriority getPriority() const {
+            return priority ? priority() : UrlRequestPriority{};
+        }
     };
 
     using Response = UrlResponse;
@@ -41,22 +63,50 @@ private:
     struct Task {
         Request request;
         Response response;
+        CURL* handle = nullptr;
+        // Buffer for curl error messages
+        char errorString[CURL_ERROR_SIZE] = {0};
     };
 
     static Response getCanceledResponse();
     static size_t curlWriteCallback(char* ptr, size_t size, size_t n, void* user);
-    static int curlProgressCallback(void* user, double dltotal, double dlnow, double ultotal, double ulnow);
 
-    void curlLoop(uint32_t index);
+    void curlLoop();
+
+    // Start transfers of pending requests by priority, up to maxActiveTasks. With _preempt,
+    // background transfers are queued again for waiting foreground requests.
+    // Call with m_requestMutex held.
+    void startPendingRequests(bool _preempt);
+
+    // Remove @_task from the multi handle and run its callback
+    void finishTask(std::unique_ptr<Task> _task, const char* _error);
+
+    // Interrupt the wait for network activity in curlLoop()
+    void wakeUp();
+
+    std::thread m_thread;
+    CURLM* m_multi = nullptr;
+
+    // Pipe that wakes the curl loop when requests were added or canceled
+    int m_wakeUpPipe[2] = { -1, -1 };
+
+    // Requests that wait for a transfer slot
+    std::deque<Request> m_requests;
+    // Active requests that were canceled, removed by the curl loop
+    std::vector<UrlRequestHandle> m_canceled;
+    // Running transfers, only used by the curl loop
+    std::vector<std::unique_ptr<Task>> m_tasks;
+    // Easy handles of finished transfers, kept for the next ones
+    std::vector<CURL*> m_idleHandles;
 
-    std::vector<std::thread> m_threads;
-    std::vector<Task> m_tasks;
-    std::vector<Request> m_requests;
-    std::condition_variable m_requestCondition;
     std::mutex m_requestMutex;
     Options m_options;
     UrlRequestHandle m_requestCount = 0;
     bool m_keepRunning = false;
+
+    // Requests were added since the last preemption check
+    bool m_requestsAdded = false;
+    std::chrono::steady_clock::time_point m_nextPreemptCheck;
 };
 
 } // namespace Tangram
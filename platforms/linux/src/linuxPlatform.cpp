@@ -55,6 +55,11 @@ UrlRequestHandle LinuxPlatform::startUrlRequest(Url _url, UrlCallback _callback)
     return m_urlClient.addRequest(_url.string(), _callback);
 }
 
+UrlRequestHandle LinuxPlatform::startPrioritizedUrlRequest(Url _url, UrlCallback _callback,
+                                                           UrlPriorityCallback _priority) {
+    return m_urlClient.addRequest(_url.string(), _callback, _priority);
+}
+
 void LinuxPlatform::cancelUrlRequest(UrlRequestHandle _request) {
     m_urlClient.cancelRequest(_request);
 }
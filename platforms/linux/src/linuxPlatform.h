@@ -15,6 +15,8 @@ public:
     void requestRender() const override;
     std::vector<FontSourceHandle> systemFontFallbacksHandle() const override;
     UrlRequestHandle startUrlRequest(Url _url, UrlCallback _callback) override;
+    UrlRequestHandle startPrioritizedUrlRequest(Url _url, UrlCallback _callback,
+                                                UrlPriorityCallback _priority) override;
     void cancelUrlRequest(UrlRequestHandle _request) override;
 
 protected:
@@ -52,6 +52,11 @@ UrlRequestHandle RpiPlatform::startUrlRequest(Url _url, UrlCallback _callback) {
     return m_urlClient.addRequest(_url.string(), _callback);
 }
 
+UrlRequestHandle RpiPlatform::startPrioritizedUrlRequest(Url _url, UrlCallback _callback,
+                                                         UrlPriorityCallback _priority) {
+    return m_urlClient.addRequest(_url.string(), _callback, _priority);
+}
+
 void RpiPlatform::cancelUrlRequest(UrlRequestHandle _request) {
     m_urlClient.cancelRequest(_request);
 }
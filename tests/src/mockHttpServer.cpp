@@ -0,0 +1,137 @@
+#include "mockHttpServer.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Tangram {
+
+MockHttpServer::MockHttpServer(Options _options) : m_options(_options) {
+
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(m_socket, 128);
+
+    socklen_t length = sizeof(address);
+    getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+
+    m_acceptThread = std::thread(&MockHttpServer::acceptLoop, this);
+}
+
+MockHttpServer::~MockHttpServer() {
+    m_running = false;
+
+    // Wake up accept() and recv() of the serving threads
+    shutdown(m_socket, SHUT_RDWR);
+    m_acceptThread.join();
+    close(m_socket);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int client : m_clients) {
+        shutdown(client, SHUT_RDWR);
+    }
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    for (int client : m_clients) {
+        close(client);
+    }
+}
+
+void MockHttpServer::acceptLoop() {
+    while (m_running) {
+        int client = accept(m_socket, nullptr, nullptr);
+        if (client < 0) { break; }
+
+        int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        m_connections++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_clients.push_back(client);
+        m_threads.emplace_back(&MockHttpServer::serve, this, client);
+    }
+}
+
+bool MockHttpServer::waitForActiveRequests(size_t _count, uint32_t _timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_activeMutex);
+    return m_activeCondition.wait_for(lock, std::chrono::milliseconds(_timeoutMs),
+                                      [&]() { return m_activeRequests >= _count; });
+}
+
+void MockHttpServer::serve(int _socket) {
+    std::string body(m_options.bodySize, 'x');
+    std::string input;
+    char buffer[4096];
+
+    while (m_running) {
+        size_t end = input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            ssize_t received = recv(_socket, buffer, sizeof(buffer), 0);
+            if (received <= 0) { break; }
+            input.append(buffer, received);
+            continue;
+        }
+
+        // Request line: 'GET /path HTTP/1.1'
+        size_t pathStart = input.find(' ') + 1;
+        std::string path = input.substr(pathStart, input.find(' ', pathStart) - pathStart);
+        input.erase(0, end + 4);
+
+        {
+            std::lock_guard<std::mutex> lock(m_activeMutex);
+            m_activeRequests++;
+        }
+        m_activeCondition.notify_all();
+
+        if (m_options.delayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_options.delayMs));
+        }
+
+        bool missing = path.compare(0, 8, "/missing") == 0;
+        const std::string& content = missing ? std::string() : body;
+
+        std::string response = missing ? "HTTP/1.1 404 Not Found\r\n" : "HTTP/1.1 200 OK\r\n";
+        response += "Content-Length: " + std::to_string(content.size()) + "\r\n";
+        response += "Connection: keep-alive\r\n\r\n";
+        response += content;
+
+        m_requests++;
+
+        // Send chunks of 10 ms at the rate limit
+        size_t chunkSize = response.size();
+        if (m_options.bytesPerSecond > 0) {
+            chunkSize = std::max<size_t>(m_options.bytesPerSecond / 100, 1);
+        }
+
+        for (size_t sent = 0; sent < response.size() && m_running; ) {
+            size_t size = std::min(chunkSize, response.size() - sent);
+            ssize_t n = send(_socket, response.data() + sent, size, MSG_NOSIGNAL);
+            if (n <= 0) { break; }
+            sent += n;
+            if (m_options.bytesPerSecond > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_activeMutex);
+        m_activeRequests--;
+    }
+}
+
+} // namespace Tangram
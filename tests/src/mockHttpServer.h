@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Tangram {
+
+/* Minimal HTTP/1.1 server on a local port for testing URL clients.
+ *
+ * Every GET is answered with a body of bodySize bytes after a delay of delayMs,
+ * paths starting with '/missing' get a 404. With bytesPerSecond, each connection
+ * sends at most that rate. Connections are kept alive, each one is served by its
+ * own thread.
+ */
+class MockHttpServer {
+
+public:
+
+    struct Options {
+        uint32_t delayMs = 0;
+        size_t bodySize = 1024;
+        // Rate limit of a connection, 0 for no limit
+        size_t bytesPerSecond = 0;
+    };
+
+    MockHttpServer(Options _options);
+    ~MockHttpServer();
+
+    // Base URL of the server, e.g. 'http://127.0.0.1:12345'
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(m_port); }
+
+    // Number of accepted connections and of answered requests
+    size_t connections() const { return m_connections; }
+    size_t requests() const { return m_requests; }
+
+    // Wait until at least _count requests are answered at the same time,
+    // returns false if that did not happen within _timeoutMs
+    bool waitForActiveRequests(size_t _count, uint32_t _timeoutMs = 5000);
+
+private:
+
+    void acceptLoop();
+    void serve(int _socket);
+
+    Options m_options;
+    int m_socket = -1;
+    int m_port = 0;
+
+    std::atomic<size_t> m_connections{0};
+    std::atomic<size_t> m_requests{0};
+    std::atomic<bool> m_running{true};
+
+    size_t m_activeRequests = 0;
+    std::mutex m_activeMutex;
+    std::condition_variable m_activeCondition;
+
+    std::thread m_acceptThread;
+    std::mutex m_mutex;
+    std::vector<std::thread> m_threads;
+    std::vector<int> m_clients;
+};
+
+} // namespace Tangram
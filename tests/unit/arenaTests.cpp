@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include "util/arena.h"
+
+#include <cstdint>
+#include <string>
+
+using namespace Tangram;
+
+TEST_CASE("Arena allocations are aligned and tracked", "[Arena]") {
+    Arena arena(256);
+
+    auto* a = arena.allocate(3, 1);
+    auto* b = arena.allocate(sizeof(double), alignof(double));
+
+    size_t misalignment = reinterpret_cast<uintptr_t>(b) % alignof(double);
+    REQUIRE(misalignment == 0);
+    auto offset = static_cast<char*>(b) - static_cast<char*>(a);
+    REQUIRE(offset >= 3);
+    REQUIRE(arena.size() >= 3 + sizeof(double));
+
+    // Larger than a block
+    arena.allocate(1000, 16);
+    REQUIRE(arena.capacity() >= 1256);
+    REQUIRE(arena.peakSize() >= 1000);
+
+    // Blocks are merged on reset
+    size_t capacity = arena.capacity();
+    arena.reset();
+    REQUIRE(arena.size() == 0);
+    REQUIRE(arena.peakSize() == 0);
+    REQUIRE(arena.capacity() == capacity);
+
+    auto* c = arena.allocate(capacity / 2, 1);
+    REQUIRE(c != nullptr);
+    REQUIRE(arena.capacity() == capacity);
+}
+
+TEST_CASE("Arena reuses the memory of the last allocation", "[Arena]") {
+    Arena arena(1024);
+
+    for (int i = 0; i < 100; i++) {
+        ArenaVector<int> scratch(64, i, ArenaAllocator<int>(&arena));
+        REQUIRE(scratch.back() == i);
+    }
+
+    REQUIRE(arena.size() == 0);
+    REQUIRE(arena.peakSize() == 64 * sizeof(int));
+    REQUIRE(arena.capacity() == 1024);
+}
+
+TEST_CASE("Arena trims its blocks to the maximum capacity on reset", "[Arena]") {
+    Arena arena(256, 1024);
+
+    for (int i = 0; i < 16; i++) { arena.allocate(200, 1); }
+    REQUIRE(arena.capacity() >= 16 * 200);
+    REQUIRE(arena.peakSize() == 16 * 200);
+
+    arena.reset();
+    REQUIRE(arena.capacity() == 1024);
+    REQUIRE(arena.peakSize() == 0);
+
+    // A single block that is too large is trimmed as well
+    arena.allocate(4000, 1);
+    REQUIRE(arena.capacity() >= 4000);
+    arena.reset();
+    REQUIRE(arena.capacity() == 1024);
+
+    // Smaller builds keep their memory
+    arena.allocate(500, 1);
+    arena.reset();
+    REQUIRE(arena.capacity() == 1024);
+
+    auto* a = arena.allocate(1000, 1);
+    REQUIRE(a != nullptr);
+    REQUIRE(arena.capacity() == 1024);
+}
+
+TEST_CASE("ArenaAllocator without Arena uses the heap", "[Arena]") {
+    ArenaVector<std::string> strings;
+
+    for (int i = 0; i < 100; i++) {
+        strings.push_back(std::to_string(i));
+    }
+    REQUIRE(strings[99] == "99");
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "data/clientGeoJsonSource.h"
+#include "data/properties.h"
+#include "tile/tileID.h"
+
+#include <memory>
+
+using namespace Tangram;
+
+TEST_CASE("ClientGeoJsonSource features keep their id", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<ClientGeoJsonSource>(nullptr, "client", "");
+
+    Properties props;
+    auto a = source->addPoint(props, { 10, 10 });
+    auto b = source->addLine(props, { { 20, 20 }, { 21, 21 } });
+    auto c = source->addPoint(props, { 30, 30 });
+
+    REQUIRE(a != b);
+    REQUIRE(b != c);
+
+    REQUIRE(source->removeFeature(a));
+    REQUIRE(!source->removeFeature(a));
+
+    // Removing a moves other features in the store, their ids stay valid
+    REQUIRE(source->updatePoint(c, props, { 31, 31 }));
+    REQUIRE(source->updateLine(b, props, { { 22, 22 }, { 23, 23 } }));
+    REQUIRE(!source->updatePoint(a, props, { 0, 0 }));
+
+    REQUIRE(source->removeFeature(b));
+    REQUIRE(source->removeFeature(c));
+
+    source->clearData();
+    REQUIRE(!source->removeFeature(c));
+}
+
+TEST_CASE("ClientGeoJsonSource updates only outdate tiles they intersect", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<ClientGeoJsonSource>(nullptr, "client", "");
+
+    Properties props;
+    // North-east and south-west quadrants at zoom 1
+    auto ne = source->addPoint(props, { 90, 45 });
+    source->waitForIndex();
+    auto sw = source->addPoint(props, { -90, -45 });
+    source->waitForIndex();
+
+    TileID neTile(1, 0, 1);
+    TileID swTile(0, 1, 1);
+
+    int64_t neGeneration = source->tileGeneration(neTile);
+    int64_t swGeneration = source->tileGeneration(swTile);
+    REQUIRE(swGeneration > neGeneration);
+    REQUIRE(swGeneration == source->generation());
+
+    REQUIRE(source->updatePoint(ne, props, { 91, 46 }));
+    source->waitForIndex();
+    REQUIRE(source->tileGeneration(neTile) == source->generation());
+    REQUIRE(source->tileGeneration(swTile) == swGeneration);
+
+    // Moving a feature outdates the tiles of its old and new position
+    REQUIRE(source->updatePoint(sw, props, { 90, 45 }));
+    source->waitForIndex();
+    REQUIRE(source->tileGeneration(neTile) == source->generation());
+    REQUIRE(source->tileGeneration(swTile) == source->generation());
+
+    swGeneration = source->tileGeneration(swTile);
+    REQUIRE(source->removeFeature(ne));
+    source->waitForIndex();
+    REQUIRE(source->tileGeneration(swTile) == swGeneration);
+
+    source->clearData();
+    source->waitForIndex();
+    REQUIRE(source->tileGeneration(swTile) == source->generation());
+}
+
+TEST_CASE("ClientGeoJsonSource updates show up when the index was rebuilt", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<ClientGeoJsonSource>(nullptr, "client", "");
+
+    int64_t generation = source->generation();
+
+    Properties props;
+    source->addPoint(props, { 10, 10 });
+    source->addPoint(props, { 20, 20 });
+    source->waitForIndex();
+
+    // Both updates were applied by one or two index builds
+    REQUIRE(source->generation() > generation);
+    REQUIRE(source->generation() <= generation + 2);
+}
+
+TEST_CASE("ClientGeoJsonSource adds features in batches", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<ClientGeoJsonSource>(nullptr, "client", "");
+
+    ClientGeoJsonSource::FeatureBatch batch;
+    batch.geometryType = GeometryType::lines;
+    batch.coordinates = { { 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 } };
+    batch.lineEnds = { 2, 5 };
+    batch.keys = { "name", "speed" };
+    batch.values = { Value(std::string("a")), Value(10.0), Value(std::string("b")), Value(none_type{}) };
+
+    auto first = source->addFeatures(std::move(batch));
+
+    REQUIRE(source->updatePoint(first + 1, Properties(), { 5, 5 }));
+    REQUIRE(source->removeFeature(first));
+    REQUIRE(!source->removeFeature(first + 2));
+
+    // Lines past the coordinates are rejected
+    ClientGeoJsonSource::FeatureBatch invalid;
+    invalid.geometryType = GeometryType::lines;
+    invalid.coordinates = { { 0, 0 } };
+    invalid.lineEnds = { 2 };
+
+    auto next = source->addFeatures(std::move(invalid));
+    REQUIRE(!source->removeFeature(next));
+
+    source->waitForIndex();
+}
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include "data/featureColumns.h"
+#include "data/formats/geoJson.h"
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+#include "util/arena.h"
+#include "util/mapProjection.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+static Line line(std::initializer_list<Point> _points) { return Line(_points); }
+
+TEST_CASE("FeatureColumns decode the features that were added", "[FeatureColumns]") {
+    FeatureColumns columns(3);
+
+    columns.beginFeature(GeometryType::points);
+    columns.addProperty("name", std::string("point"));
+    columns.addProperty("kind", std::string("poi"));
+    columns.addCoordinate({ 0.1, 0.2, 0 });
+    columns.addCoordinate({ 0.3, 0.4, 0 });
+    columns.endPoints();
+    columns.endFeature();
+
+    Line first = line({ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 } });
+    Line second = line({ { 0.5, 0.5, 0 }, { 0.6, 0.6, 0 } });
+
+    columns.beginFeature(GeometryType::lines);
+    columns.addProperty("kind", std::string("poi"));
+    columns.addProperty("width", 2.0);
+    columns.addLine(first.begin(), first.end());
+    columns.addLine(second.begin(), second.end());
+    columns.endFeature();
+
+    Line outer = line({ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 0, 0 } });
+    Line hole = line({ { 0.2, 0.1, 0 }, { 0.3, 0.1, 0 }, { 0.3, 0.2, 0 }, { 0.2, 0.1, 0 } });
+
+    columns.beginFeature(GeometryType::polygons);
+    columns.addRing(outer.begin(), outer.end(), true);
+    columns.addRing(hole.begin(), hole.end(), false);
+    columns.addRing(hole.begin(), hole.end(), true);
+    columns.endFeature();
+
+    columns.finish();
+
+    REQUIRE(columns.size() == 3);
+    REQUIRE(columns.memoryUsage() > 0);
+
+    // Reused for all features
+    Feature feature;
+    Arena arena;
+
+    columns.decodeProperties(0, feature, arena);
+    columns.decodeGeometry(0, feature, arena);
+
+    REQUIRE(feature.geometryType == GeometryType::points);
+    REQUIRE(feature.props.sourceId == 3);
+    REQUIRE(feature.props.items().size() == 2);
+    // Sorted like Properties
+    REQUIRE(feature.props.items()[0].key == "kind");
+    REQUIRE(feature.props.items()[1].key == "name");
+    REQUIRE(feature.points == line({ { 0.1, 0.2, 0 }, { 0.3, 0.4, 0 } }));
+
+    columns.decodeProperties(1, feature, arena);
+    columns.decodeGeometry(1, feature, arena);
+
+    REQUIRE(feature.geometryType == GeometryType::lines);
+    REQUIRE(feature.props.getString("kind") == "poi");
+    REQUIRE(feature.props.getNumber("width") == 2.0);
+    REQUIRE(feature.points.empty());
+    REQUIRE(feature.lines.size() == 2);
+    REQUIRE(feature.lines[0] == first);
+    REQUIRE(feature.lines[1] == second);
+
+    columns.decodeProperties(2, feature, arena);
+    columns.decodeGeometry(2, feature, arena);
+
+    REQUIRE(feature.geometryType == GeometryType::polygons);
+    REQUIRE(feature.props.items().empty());
+    REQUIRE(feature.lines.empty());
+    REQUIRE(feature.polygons.size() == 2);
+    REQUIRE(feature.polygons[0] == Polygon({ outer, hole }));
+    REQUIRE(feature.polygons[1] == Polygon({ hole }));
+}
+
+TEST_CASE("GeoJSON tiles are parsed into FeatureColumns", "[FeatureColumns]") {
+    std::string json = R"({
+        "type": "FeatureCollection",
+        "features": [
+            { "type": "Feature", "properties": { "name": "a", "height": 10, "visible": true },
+              "geometry": { "type": "MultiLineString", "coordinates": [ [[0, 0], [1, 1]], [[2, 2], [3, 3], [4, 4]] ] } },
+            { "type": "Feature", "properties": { "name": "b" },
+              "geometry": { "type": "Polygon", "coordinates": [ [[0, 0], [1, 0], [1, 1], [0, 0]] ] } }
+        ]
+    })";
+
+    auto source = std::make_shared<TileSource>("source", nullptr);
+    TileID tileId(0, 0, 0);
+    BinaryTileTask task(tileId, source, -1);
+    task.rawTileData = std::make_shared<std::vector<char>>(json.begin(), json.end());
+
+    MercatorProjection projection;
+    auto tileData = GeoJson::parseTile(task, projection, 5);
+
+    REQUIRE(tileData->layers.size() == 1);
+
+    auto& layer = tileData->layers[0];
+    REQUIRE(layer.features.empty());
+    REQUIRE(layer.encodedFeatures);
+    REQUIRE(layer.encodedFeatures->size() == 2);
+
+    Feature feature;
+    Arena arena;
+
+    layer.encodedFeatures->decodeProperties(0, feature, arena);
+    layer.encodedFeatures->decodeGeometry(0, feature, arena);
+
+    REQUIRE(feature.geometryType == GeometryType::lines);
+    REQUIRE(feature.props.sourceId == 5);
+    REQUIRE(feature.props.getString("name") == "a");
+    REQUIRE(feature.props.getNumber("height") == 10);
+    REQUIRE(feature.props.getNumber("visible") == 1);
+    REQUIRE(feature.lines.size() == 2);
+    REQUIRE(feature.lines[0].size() == 2);
+    REQUIRE(feature.lines[1].size() == 3);
+
+    layer.encodedFeatures->decodeProperties(1, feature, arena);
+    layer.encodedFeatures->decodeGeometry(1, feature, arena);
+
+    REQUIRE(feature.geometryType == GeometryType::polygons);
+    REQUIRE(feature.props.getString("name") == "b");
+    REQUIRE(feature.lines.empty());
+    REQUIRE(feature.polygons.size() == 1);
+    REQUIRE(feature.polygons[0].size() == 1);
+    REQUIRE(feature.polygons[0][0].size() == 4);
+}
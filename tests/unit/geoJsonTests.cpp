@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#include "data/formats/geoJson.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+struct TestSink : public GeoJson::FeatureSink {
+
+    struct TestLayer {
+        std::string name;
+        std::vector<GeoJson::ParsedFeature> features;
+        bool valid = false;
+    };
+
+    size_t beginLayer(const std::string& _name) override {
+        layers.push_back({ _name });
+        return layers.size() - 1;
+    }
+
+    void addFeature(size_t _layer, const GeoJson::ParsedFeature& _feature) override {
+        layers[_layer].features.push_back(_feature);
+    }
+
+    void endLayer(size_t _layer, bool _valid) override {
+        layers[_layer].valid = _valid;
+    }
+
+    std::vector<TestLayer> layers;
+};
+
+static bool parse(const std::string& _json, TestSink& _sink) {
+    const char* error;
+    size_t offset;
+    return GeoJson::parse(_json.data(), _json.size(), _sink, &error, &offset);
+}
+
+TEST_CASE("Stream the features of a FeatureCollection", "[GeoJson]") {
+    TestSink sink;
+    REQUIRE(parse(R"({
+        "type": "FeatureCollection",
+        "crs": { "type": "name", "properties": { "name": "EPSG:4326" } },
+        "features": [
+            { "properties": { "name": "a", "height": 10, "visible": true, "type": "x", "tags": { "a": [1] } },
+              "geometry": { "coordinates": [ [[0, 0], [1, 0], [1, 1], [0, 0]], [[0.2, 0.2], [0.5, 0.2], [0.2, 0.2]] ],
+                            "type": "Polygon" },
+              "type": "Feature" },
+            { "type": "Feature", "bbox": [0, 0, 5, 5],
+              "geometry": { "type": "MultiPolygon", "coordinates": [ [[[0, 0], [1, 1], [0, 0]]],
+                                                                     [[[2, 2], [3, 3], [2, 2]], [[4, 4], [5, 5], [4, 4]]] ] } },
+            { "type": "Feature", "geometry": { "type": "Point", "coordinates": [1, 2, 3] } },
+            { "type": "Feature", "geometry": { "type": "MultiLineString", "coordinates": [ [[0, 0], [1, 1]], [[2, 2], [3, 3], [4, 4]] ] } },
+            { "type": "Feature", "geometry": null, "properties": { "name": "b" } }
+        ]
+    })", sink));
+
+    REQUIRE(sink.layers.size() == 2);
+    REQUIRE(sink.layers[0].valid);
+    // The 'crs' member is not a FeatureCollection
+    REQUIRE(sink.layers[1].name == "crs");
+    REQUIRE(!sink.layers[1].valid);
+
+    auto& features = sink.layers[0].features;
+    REQUIRE(features.size() == 5);
+
+    // Properties may come before the geometry type is known
+    REQUIRE(features[0].geometryType == GeometryType::polygons);
+    REQUIRE(features[0].coordinates.size() == 7);
+    REQUIRE(features[0].lineEnds == std::vector<uint32_t>({ 4, 7 }));
+    REQUIRE(features[0].polygonEnds == std::vector<uint32_t>({ 2 }));
+    REQUIRE(features[0].properties.size() == 4);
+    REQUIRE(features[0].properties[0].first == "name");
+    REQUIRE(features[0].properties[0].second == Value(std::string("a")));
+    REQUIRE(features[0].properties[1].second == Value(10.0));
+    REQUIRE(features[0].properties[2].second == Value(1.0));
+    REQUIRE(features[0].properties[3].first == "type");
+
+    REQUIRE(features[1].geometryType == GeometryType::polygons);
+    REQUIRE(features[1].lineEnds == std::vector<uint32_t>({ 3, 6, 9 }));
+    REQUIRE(features[1].polygonEnds == std::vector<uint32_t>({ 1, 3 }));
+    REQUIRE(features[1].properties.empty());
+
+    REQUIRE(features[2].geometryType == GeometryType::points);
+    REQUIRE(features[2].coordinates.size() == 1);
+    REQUIRE(features[2].coordinates[0] == glm::dvec2(1, 2));
+
+    REQUIRE(features[3].geometryType == GeometryType::lines);
+    REQUIRE(features[3].lineEnds == std::vector<uint32_t>({ 2, 5 }));
+
+    REQUIRE(features[4].geometryType == GeometryType::unknown);
+    REQUIRE(features[4].coordinates.empty());
+    REQUIRE(features[4].properties.size() == 1);
+}
+
+TEST_CASE("Stream a single Feature or geometry", "[GeoJson]") {
+    TestSink sink;
+    REQUIRE(parse(R"({ "type": "Feature", "properties": { "kind": "bus" },
+                       "geometry": { "type": "LineString", "coordinates": [[0, 0], [1, 1]] } })", sink));
+
+    REQUIRE(sink.layers.size() == 1);
+    REQUIRE(sink.layers[0].valid);
+    REQUIRE(sink.layers[0].features.size() == 1);
+    REQUIRE(sink.layers[0].features[0].geometryType == GeometryType::lines);
+    REQUIRE(sink.layers[0].features[0].properties.size() == 1);
+
+    TestSink geometrySink;
+    REQUIRE(parse(R"({ "type": "MultiPoint", "coordinates": [[0, 0], [1, 1]] })", geometrySink));
+
+    REQUIRE(geometrySink.layers.size() == 1);
+    REQUIRE(geometrySink.layers[0].valid);
+    REQUIRE(geometrySink.layers[0].features.size() == 1);
+    REQUIRE(geometrySink.layers[0].features[0].geometryType == GeometryType::points);
+    REQUIRE(geometrySink.layers[0].features[0].coordinates.size() == 2);
+}
+
+TEST_CASE("Stream named FeatureCollections", "[GeoJson]") {
+    TestSink sink;
+    REQUIRE(parse(R"({
+        "roads": { "type": "FeatureCollection",
+                   "features": [ { "type": "Feature", "geometry": { "type": "Point", "coordinates": [0, 0] } } ] },
+        "water": { "features": [], "type": "FeatureCollection" },
+        "other": { "a": 1 }
+    })", sink));
+
+    REQUIRE(sink.layers.size() == 4);
+    REQUIRE(!sink.layers[0].valid);
+    REQUIRE(sink.layers[1].name == "roads");
+    REQUIRE(sink.layers[1].valid);
+    REQUIRE(sink.layers[1].features.size() == 1);
+    REQUIRE(sink.layers[2].name == "water");
+    REQUIRE(sink.layers[2].valid);
+    REQUIRE(!sink.layers[3].valid);
+}
+
+TEST_CASE("Streaming malformed GeoJSON fails", "[GeoJson]") {
+    TestSink sink;
+    REQUIRE(!parse(R"({ "type": "FeatureCollection", "features": [ { "type": "Feature" )", sink));
+}
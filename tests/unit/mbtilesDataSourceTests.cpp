@@ -0,0 +1,423 @@
+#include "catch.hpp"
+
+#include "data/mbtilesDataSource.h"
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tileID.h"
+#include "tile/tileTask.h"
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace Tangram;
+
+// MBTiles file in /tmp that is removed with its journal files
+struct TempMBTiles {
+    std::string path;
+
+    TempMBTiles() {
+        char name[] = "/tmp/mbtilesDataSourceTests-XXXXXX";
+        close(mkstemp(name));
+        path = name;
+    }
+
+    ~TempMBTiles() {
+        for (auto suffix : { "", "-wal", "-shm" }) {
+            std::remove((path + suffix).c_str());
+        }
+    }
+};
+
+// Next source that returns TILE_SIZE bytes for every tile, different for each tile
+#define TILE_SIZE 4096
+
+struct GeneratedSource : public TileSource::DataSource {
+    std::atomic<int> loads{0};
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        loads++;
+        TileID id = _task->tileId();
+        auto data = std::make_shared<std::vector<char>>(TILE_SIZE);
+        for (size_t i = 0; i < data->size(); i++) {
+            (*data)[i] = char(i * 7);
+        }
+        std::string name = id.toString();
+        std::copy(name.begin(), name.end(), data->begin());
+        static_cast<BinaryTileTask&>(*_task).rawTileData = data;
+        _cb.func(_task);
+        return true;
+    }
+};
+
+// Loads tiles from an MBTilesDataSource and waits for them
+struct Loader {
+    std::shared_ptr<TileSource> tileSource = std::make_shared<TileSource>("test", nullptr);
+    std::atomic<int> loaded{0};
+    int requested = 0;
+
+    std::shared_ptr<BinaryTileTask> load(MBTilesDataSource& _source, TileID _tileId) {
+        auto task = std::make_shared<BinaryTileTask>(_tileId, tileSource, -1);
+        requested++;
+        _source.loadTileData(task, {[this](std::shared_ptr<TileTask>) { loaded++; }});
+        return task;
+    }
+
+    bool wait() {
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (loaded < requested) {
+            if (std::chrono::steady_clock::now() > timeout) { return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+// Opens the cache at _path, loads _tiles and waits for them to be written
+static int loadTiles(const std::string& _path, const std::vector<TileID>& _tiles,
+                     uint64_t _cacheSize = 0, MBTilesDataSource::Stats* _stats = nullptr) {
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", _path, "", true);
+    auto next = std::make_unique<GeneratedSource>();
+    auto& generated = *next;
+    source.setNext(std::move(next));
+    source.setCacheSize(_cacheSize);
+
+    Loader loader;
+    for (auto& tileId : _tiles) {
+        loader.load(source, tileId);
+    }
+    REQUIRE(loader.wait());
+
+    if (_stats) { *_stats = source.getStats(); }
+
+    // Written and evicted when the source is destroyed
+    return generated.loads;
+}
+
+static std::vector<TileID> tileRow(int _y, int _begin, int _end) {
+    std::vector<TileID> tiles;
+    for (int x = _begin; x < _end; x++) {
+        tiles.emplace_back(x, _y, 10);
+    }
+    return tiles;
+}
+
+TEST_CASE("MBTilesDataSource evicts least recently used tiles from the cache", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    const uint64_t cacheSize = 380 * 1024;
+
+    // Store 50 tiles and read 10 of them again later
+    REQUIRE(loadTiles(file.path, tileRow(0, 0, 50), cacheSize) == 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    REQUIRE(loadTiles(file.path, tileRow(0, 0, 10), cacheSize) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // The next 30 tiles don't fit into the cache
+    REQUIRE(loadTiles(file.path, tileRow(1, 0, 30), cacheSize) == 30);
+
+    MBTilesDataSource::Stats stats;
+    REQUIRE(loadTiles(file.path, {}, cacheSize, &stats) == 0);
+    REQUIRE(stats.size > 0);
+    REQUIRE(stats.size <= cacheSize);
+
+    // The tiles that were read and the newest tiles are kept
+    REQUIRE(loadTiles(file.path, tileRow(0, 0, 10)) == 0);
+    REQUIRE(loadTiles(file.path, tileRow(1, 0, 30)) == 0);
+
+    // The oldest tiles were removed
+    REQUIRE(loadTiles(file.path, tileRow(0, 10, 50)) > 0);
+}
+
+TEST_CASE("MBTilesDataSource counts cache hits and misses", "[MBTilesDataSource]") {
+    TempMBTiles file;
+
+    MBTilesDataSource::Stats stats;
+    REQUIRE(loadTiles(file.path, tileRow(0, 0, 20), 0, &stats) == 20);
+    REQUIRE(stats.hits == 0);
+    REQUIRE(stats.misses == 20);
+
+    REQUIRE(loadTiles(file.path, tileRow(0, 10, 30), 0, &stats) == 10);
+    REQUIRE(stats.hits == 10);
+    REQUIRE(stats.misses == 10);
+    REQUIRE(stats.size > 20 * TILE_SIZE);
+}
+
+// Tile data of the MBTiles files created by createMBTiles()
+static std::string tileName(TileID _tileId) {
+    return std::to_string(_tileId.z) + "/" + std::to_string(_tileId.x) + "/" + std::to_string(_tileId.y);
+}
+
+// Creates an MBTiles file with the tiles of zoom levels 0 to _maxZoom, except for
+// the tiles of column 0 at _maxZoom. Rows are stored in TMS order, from the south.
+static void createMBTiles(const std::string& _path, int _maxZoom) {
+    SQLite::Database db(_path, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+    db.exec("CREATE TABLE metadata (name text, value text);"
+            "INSERT INTO metadata VALUES ('name', 'test'), ('compression', 'identity');"
+            "CREATE TABLE tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob);"
+            "CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row);");
+
+    SQLite::Transaction transaction(db);
+    SQLite::Statement insert(db, "INSERT INTO tiles VALUES (?, ?, ?, ?);");
+
+    for (int z = 0; z <= _maxZoom; z++) {
+        for (int x = (z == _maxZoom ? 1 : 0); x < (1 << z); x++) {
+            for (int y = 0; y < (1 << z); y++) {
+                std::string data = tileName(TileID(x, y, z));
+                insert.bind(1, z);
+                insert.bind(2, x);
+                insert.bind(3, (1 << z) - 1 - y);
+                insert.bind(4, data.data(), data.size());
+                insert.exec();
+                insert.reset();
+            }
+        }
+    }
+    transaction.commit();
+}
+
+static std::string taskData(const BinaryTileTask& _task) {
+    if (!_task.rawTileData) { return ""; }
+    return std::string(_task.rawTileData->begin(), _task.rawTileData->end());
+}
+
+TEST_CASE("MBTilesDataSource reads tiles from TMS rows", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    createMBTiles(file.path, 3);
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "");
+
+    Loader loader;
+    auto a = loader.load(source, TileID(1, 0, 1));
+    auto b = loader.load(source, TileID(2, 5, 3));
+    REQUIRE(loader.wait());
+
+    REQUIRE(taskData(*a) == "1/1/0");
+    REQUIRE(taskData(*b) == "3/2/5");
+}
+
+TEST_CASE("MBTilesDataSource reads batches of tiles and loads missing tiles from the next source", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    createMBTiles(file.path, 4);
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "");
+    auto next = std::make_unique<GeneratedSource>();
+    auto& generated = *next;
+    source.setNext(std::move(next));
+
+    // Tiles of two zoom levels, queued faster than they are read
+    Loader loader;
+    std::vector<std::shared_ptr<BinaryTileTask>> tasks;
+    for (int x = 0; x < 16; x++) {
+        for (int y = 0; y < 16; y++) {
+            tasks.push_back(loader.load(source, TileID(x, y, 4)));
+            if (x < 8 && y < 8) {
+                tasks.push_back(loader.load(source, TileID(x, y, 3)));
+            }
+        }
+    }
+    REQUIRE(loader.wait());
+
+    // Column 0 of zoom 4 is not in the file
+    REQUIRE(generated.loads == 16);
+
+    for (auto& task : tasks) {
+        TileID tileId = task->tileId();
+        if (tileId.z == 4 && tileId.x == 0) {
+            REQUIRE(task->rawTileData->size() == TILE_SIZE);
+        } else {
+            REQUIRE(taskData(*task) == tileName(tileId));
+        }
+    }
+
+    auto stats = source.getStats();
+    REQUIRE(stats.hits == tasks.size() - 16);
+    REQUIRE(stats.misses == 16);
+}
+
+// Next source that has no tiles
+struct EmptySource : public TileSource::DataSource {
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        static_cast<BinaryTileTask&>(*_task).rawTileData = std::make_shared<std::vector<char>>();
+        _cb.func(_task);
+        return true;
+    }
+};
+
+TEST_CASE("MBTilesDataSource falls back to its tiles when the next source has none", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    createMBTiles(file.path, 2);
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "", false, true);
+    source.setNext(std::make_unique<EmptySource>());
+
+    Loader loader;
+    auto stored = loader.load(source, TileID(1, 2, 2));
+    auto missing = loader.load(source, TileID(0, 1, 2));
+    REQUIRE(loader.wait());
+
+    REQUIRE(taskData(*stored) == "2/1/2");
+    REQUIRE(!missing->hasData());
+}
+
+TEST_CASE("MBTilesDataSource reads tiles on each of its connections", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    createMBTiles(file.path, 4);
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "", false, false, 4);
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+
+    std::mutex mutex;
+    std::condition_variable entered;
+    std::set<std::thread::id> threads;
+
+    // Each callback blocks its reader until all readers run one. Tiles of
+    // different zoom levels are not read in one batch.
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) {
+        std::unique_lock<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+        entered.notify_all();
+        entered.wait_for(lock, std::chrono::seconds(5), [&]{ return threads.size() == 4; });
+    }};
+
+    for (int z = 1; z <= 4; z++) {
+        TileID tileId(1, 1, z);
+        source.loadTileData(std::make_shared<BinaryTileTask>(tileId, tileSource, -1), cb);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    REQUIRE(entered.wait_for(lock, std::chrono::seconds(5), [&]{ return threads.size() == 4; }));
+}
+
+// Counts rows of the cache at _path on a separate connection, which sees committed tiles only
+static int countRows(const std::string& _path, const std::string& _table) {
+    SQLite::Database db(_path, SQLite::OPEN_READONLY);
+    SQLite::Statement count(db, "SELECT count(*) FROM " + _table + ";");
+    return count.executeStep() ? count.getColumn(0).getInt() : 0;
+}
+
+// Waits until the map table of the cache at _path is not empty, returns its rows
+static int waitForRows(const std::string& _path) {
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    int rows = 0;
+    while ((rows = countRows(_path, "map")) == 0 && std::chrono::steady_clock::now() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return rows;
+}
+
+static long long elapsedMs(std::chrono::steady_clock::time_point _start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+TEST_CASE("MBTilesDataSource reads buffered tiles before they are written", "[MBTilesDataSource]") {
+    TempMBTiles file;
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "", true);
+    auto next = std::make_unique<GeneratedSource>();
+    auto& generated = *next;
+    source.setNext(std::move(next));
+
+    Loader loader;
+    auto stored = loader.load(source, TileID(3, 4, 5));
+    REQUIRE(loader.wait());
+    REQUIRE(generated.loads == 1);
+
+    auto buffered = loader.load(source, TileID(3, 4, 5));
+    REQUIRE(loader.wait());
+
+    REQUIRE(generated.loads == 1);
+    REQUIRE(buffered->rawTileData == stored->rawTileData);
+    REQUIRE(source.getStats().hits == 1);
+    REQUIRE(countRows(file.path, "map") == 0);
+}
+
+TEST_CASE("MBTilesDataSource writes a full batch of tiles in one transaction", "[MBTilesDataSource]") {
+    TempMBTiles file;
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "", true);
+    source.setNext(std::make_unique<GeneratedSource>());
+
+    auto start = std::chrono::steady_clock::now();
+
+    // MBTILES_WRITE_BATCH tiles don't wait for MBTILES_WRITE_DELAY
+    Loader loader;
+    for (auto& tileId : tileRow(0, 0, 64)) {
+        loader.load(source, tileId);
+    }
+    REQUIRE(loader.wait());
+
+    REQUIRE(waitForRows(file.path) == 64);
+    REQUIRE(elapsedMs(start) < 500);
+}
+
+TEST_CASE("MBTilesDataSource writes buffered tiles after a delay", "[MBTilesDataSource]") {
+    TempMBTiles file;
+
+    auto platform = std::make_shared<MockPlatform>();
+    MBTilesDataSource source(platform, "test", file.path, "", true);
+    source.setNext(std::make_unique<GeneratedSource>());
+
+    auto start = std::chrono::steady_clock::now();
+
+    Loader loader;
+    for (auto& tileId : tileRow(0, 0, 3)) {
+        loader.load(source, tileId);
+    }
+    REQUIRE(loader.wait());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    REQUIRE(countRows(file.path, "map") == 0);
+
+    REQUIRE(waitForRows(file.path) == 3);
+    REQUIRE(elapsedMs(start) >= 500);
+}
+
+// Next source that returns the same data for every tile
+struct ConstantSource : public TileSource::DataSource {
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        static_cast<BinaryTileTask&>(*_task).rawTileData = std::make_shared<std::vector<char>>(TILE_SIZE, 'o');
+        _cb.func(_task);
+        return true;
+    }
+};
+
+TEST_CASE("MBTilesDataSource stores identical tiles as one image", "[MBTilesDataSource]") {
+    TempMBTiles file;
+    auto platform = std::make_shared<MockPlatform>();
+
+    for (auto& tiles : { tileRow(0, 0, 10), tileRow(1, 0, 5) }) {
+        MBTilesDataSource source(platform, "test", file.path, "", true);
+        source.setNext(std::make_unique<ConstantSource>());
+
+        Loader loader;
+        for (auto& tileId : tiles) {
+            loader.load(source, tileId);
+        }
+        REQUIRE(loader.wait());
+    }
+
+    // Images of earlier transactions are kept
+    REQUIRE(countRows(file.path, "map") == 15);
+    REQUIRE(countRows(file.path, "images") == 1);
+}
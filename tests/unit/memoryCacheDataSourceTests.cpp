@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "data/memoryCacheDataSource.h"
+#include "data/tileSource.h"
+#include "tile/tileID.h"
+#include "tile/tileTask.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+// Next source that returns the same content for every tile
+struct ConstantSource : public TileSource::DataSource {
+    std::string content;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        task.rawTileData = std::make_shared<std::vector<char>>(content.begin(), content.end());
+        _cb.func(_task);
+        return true;
+    }
+};
+
+static std::shared_ptr<BinaryTileTask> loadTile(MemoryCacheDataSource& _cache, TileID _tileId) {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto task = std::make_shared<BinaryTileTask>(_tileId, source, -1);
+    _cache.loadTileData(task, {[](std::shared_ptr<TileTask>) {}});
+    return task;
+}
+
+TEST_CASE("MemoryCacheDataSource stores identical tile data once", "[MemoryCacheDataSource]") {
+    MemoryCacheDataSource cache;
+    cache.setCacheSize(1024 * 1024);
+
+    auto next = std::make_unique<ConstantSource>();
+    auto& constant = *next;
+    constant.content = "ocean";
+    cache.setNext(std::move(next));
+
+    auto a = loadTile(cache, TileID(0, 0, 10));
+    auto b = loadTile(cache, TileID(1, 0, 10));
+    REQUIRE(a->rawTileData == b->rawTileData);
+    REQUIRE(cache.getMemoryUsage() == 5);
+
+    // Caches of other sources share the data too
+    MemoryCacheDataSource otherCache;
+    otherCache.setCacheSize(1024 * 1024);
+    auto otherNext = std::make_unique<ConstantSource>();
+    otherNext->content = "ocean";
+    otherCache.setNext(std::move(otherNext));
+
+    auto c = loadTile(otherCache, TileID(5, 5, 10));
+    REQUIRE(c->rawTileData == a->rawTileData);
+
+    constant.content = "land";
+    auto d = loadTile(cache, TileID(2, 0, 10));
+    REQUIRE(d->rawTileData != a->rawTileData);
+    REQUIRE(cache.getMemoryUsage() == 9);
+
+    // Cached tiles keep the shared data
+    auto e = loadTile(cache, TileID(0, 0, 10));
+    REQUIRE(e->rawTileData == a->rawTileData);
+
+    cache.clear();
+    REQUIRE(cache.getMemoryUsage() == 0);
+}
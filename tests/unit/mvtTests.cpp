@@ -0,0 +1,242 @@
+#include "catch.hpp"
+
+#include "data/formats/mvt.h"
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+#include "util/arena.h"
+#include "util/mapProjection.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+// Minimal protobuf writer for MVT test data
+struct PbfWriter {
+    std::string data;
+
+    void varint(uint64_t _value) {
+        while (_value >= 0x80) {
+            data.push_back(char((_value & 0x7f) | 0x80));
+            _value >>= 7;
+        }
+        data.push_back(char(_value));
+    }
+    void field(uint32_t _tag, uint64_t _value) {
+        varint(_tag << 3);
+        varint(_value);
+    }
+    void bytes(uint32_t _tag, const std::string& _bytes) {
+        varint((_tag << 3) | 2);
+        varint(_bytes.size());
+        data += _bytes;
+    }
+    void packed(uint32_t _tag, const std::vector<uint32_t>& _values) {
+        PbfWriter packed;
+        for (auto value : _values) { packed.varint(value); }
+        bytes(_tag, packed.data);
+    }
+};
+
+static uint32_t command(uint32_t _cmd, uint32_t _count) { return (_cmd & 0x7) | (_count << 3); }
+static uint32_t zigzag(int32_t _n) { return (uint32_t(_n) << 1) ^ uint32_t(_n >> 31); }
+
+// Square ring from (x, y) with @_size, @_ccw in tile coordinates
+static std::vector<uint32_t> ring(int _x, int _y, int _size, bool _ccw, int& _cx, int& _cy) {
+    int d = _ccw ? _size : -_size;
+    std::vector<uint32_t> cmds = {
+        command(Mvt::moveTo, 1), zigzag(_x - _cx), zigzag(_y - _cy),
+        command(Mvt::lineTo, 3), zigzag(d), zigzag(0), zigzag(0), zigzag(_size), zigzag(-d), zigzag(0),
+        command(Mvt::closePath, 1)
+    };
+    _cx = _x;
+    _cy = _y + _size;
+    return cmds;
+}
+
+static std::string feature(std::vector<uint32_t> _tags, int _type, std::vector<uint32_t> _geometry) {
+    PbfWriter feature;
+    feature.packed(2, _tags);
+    feature.field(3, _type);
+    feature.packed(4, _geometry);
+    return feature.data;
+}
+
+static std::string createTile() {
+    PbfWriter tile;
+
+    PbfWriter values[4];
+    values[0].bytes(1, "building");
+    values[1].varint((3 << 3) | 1);
+    double height = 10.5;
+    values[1].data.append(reinterpret_cast<const char*>(&height), sizeof(height));
+    values[2].bytes(1, "road");
+    values[3].field(5, 7);
+
+    PbfWriter layer;
+    layer.bytes(1, "a");
+    layer.field(5, 4096);
+    for (auto key : { "kind", "height", "name" }) { layer.bytes(3, key); }
+    for (auto& value : values) { layer.bytes(4, value.data); }
+
+    // Polygon with a hole, a line and a point
+    int x = 0, y = 0;
+    auto polygon = ring(100, 100, 1000, false, x, y);
+    auto hole = ring(200, 200, 100, true, x, y);
+    polygon.insert(polygon.end(), hole.begin(), hole.end());
+    layer.bytes(2, feature({ 0, 0, 1, 1 }, GeometryType::polygons, polygon));
+
+    layer.bytes(2, feature({ 2, 2, 0, 3 }, GeometryType::lines,
+                           { command(Mvt::moveTo, 1), zigzag(10), zigzag(10),
+                             command(Mvt::lineTo, 2), zigzag(50), zigzag(0), zigzag(0), zigzag(50) }));
+
+    layer.bytes(2, feature({ 0, 0 }, GeometryType::points,
+                           { command(Mvt::moveTo, 1), zigzag(2048), zigzag(2048) }));
+
+    tile.bytes(3, layer.data);
+
+    // The exterior winding of the first layer applies to other layers
+    PbfWriter other;
+    other.bytes(1, "b");
+    other.field(5, 4096);
+    other.bytes(3, "kind");
+    other.bytes(4, values[0].data);
+    x = 0, y = 0;
+    auto polygons = ring(100, 100, 500, true, x, y);
+    auto second = ring(1000, 1000, 500, false, x, y);
+    polygons.insert(polygons.end(), second.begin(), second.end());
+    other.bytes(2, feature({ 0, 0 }, GeometryType::polygons, polygons));
+
+    tile.bytes(3, other.data);
+
+    return tile.data;
+}
+
+static std::shared_ptr<TileData> parseTile(const std::string& _data, bool _lazy) {
+    auto source = std::make_shared<TileSource>("source", nullptr);
+    TileID tileId(0, 0, 0);
+    BinaryTileTask task(tileId, source, -1);
+    task.rawTileData = std::make_shared<std::vector<char>>(_data.begin(), _data.end());
+
+    MercatorProjection projection;
+    return Mvt::parseTile(task, projection, 1, _lazy);
+}
+
+TEST_CASE("Lazily decoded MVT features match eagerly parsed features", "[Mvt]") {
+    auto data = createTile();
+
+    auto eager = parseTile(data, false);
+    auto lazy = parseTile(data, true);
+
+    REQUIRE(eager);
+    REQUIRE(lazy);
+    REQUIRE(eager->layers.size() == 2);
+    REQUIRE(lazy->layers.size() == 2);
+
+    std::vector<Feature> polygons;
+
+    for (size_t l = 0; l < eager->layers.size(); l++) {
+        auto& eagerLayer = eager->layers[l];
+        auto& lazyLayer = lazy->layers[l];
+
+        REQUIRE(lazyLayer.name == eagerLayer.name);
+        REQUIRE(eagerLayer.encodedFeatures);
+        REQUIRE(lazyLayer.encodedFeatures);
+        REQUIRE(lazyLayer.encodedFeatures->size() == eagerLayer.encodedFeatures->size());
+
+        // Reused for all features
+        Feature expected, feature;
+        Arena arena;
+
+        for (size_t i = 0; i < eagerLayer.encodedFeatures->size(); i++) {
+            eagerLayer.encodedFeatures->decodeProperties(i, expected, arena);
+            eagerLayer.encodedFeatures->decodeGeometry(i, expected, arena);
+
+            lazyLayer.encodedFeatures->decodeProperties(i, feature, arena);
+
+            REQUIRE(feature.geometryType == expected.geometryType);
+            REQUIRE(feature.props.sourceId == expected.props.sourceId);
+            REQUIRE(feature.props.items().size() == expected.props.items().size());
+
+            for (size_t p = 0; p < expected.props.items().size(); p++) {
+                REQUIRE(feature.props.items()[p].key == expected.props.items()[p].key);
+                REQUIRE(feature.props.items()[p].value == expected.props.items()[p].value);
+            }
+
+            lazyLayer.encodedFeatures->decodeGeometry(i, feature, arena);
+
+            REQUIRE(feature.points == expected.points);
+            REQUIRE(feature.lines == expected.lines);
+            REQUIRE(feature.polygons == expected.polygons);
+
+            if (i == 0) { polygons.push_back(expected); }
+        }
+    }
+
+    // Polygon with hole, both rings in one polygon
+    REQUIRE(polygons[0].polygons.size() == 1);
+    REQUIRE(polygons[0].polygons[0].size() == 2);
+    // Rings wound like the hole of the first layer are separate polygons
+    REQUIRE(polygons[1].polygons.size() == 2);
+}
+
+TEST_CASE("Lazily decoded MVT data is kept alive by TileData", "[Mvt]") {
+    auto data = createTile();
+
+    std::shared_ptr<TileData> tileData;
+    {
+        auto source = std::make_shared<TileSource>("source", nullptr);
+        TileID tileId(0, 0, 0);
+        BinaryTileTask task(tileId, source, -1);
+        task.rawTileData = std::make_shared<std::vector<char>>(data.begin(), data.end());
+
+        MercatorProjection projection;
+        tileData = Mvt::parseTile(task, projection, 1);
+    }
+
+    auto& features = *tileData->layers[0].encodedFeatures;
+    REQUIRE(features.memoryUsage() > 0);
+
+    Feature feature;
+    Arena arena;
+    features.decodeProperties(1, feature, arena);
+    features.decodeGeometry(1, feature, arena);
+
+    REQUIRE(feature.props.getString("name") == "road");
+    REQUIRE(feature.props.getNumber("kind") == 7);
+    REQUIRE(feature.lines.size() == 1);
+    REQUIRE(feature.lines[0].size() == 3);
+}
+
+TEST_CASE("MVT layers that are not selected are skipped", "[Mvt]") {
+    auto data = createTile();
+
+    auto source = std::make_shared<TileSource>("source", nullptr);
+    TileID tileId(0, 0, 0);
+    BinaryTileTask task(tileId, source, -1);
+    task.rawTileData = std::make_shared<std::vector<char>>(data.begin(), data.end());
+
+    MercatorProjection projection;
+    std::vector<std::string> collections = { "b", "c" };
+    Mvt::SkippedLayers skipped;
+
+    auto tileData = Mvt::parseTile(task, projection, 1, true, &collections, &skipped);
+
+    REQUIRE(tileData->layers.size() == 1);
+    REQUIRE(tileData->layers[0].name == "b");
+    REQUIRE(tileData->layers[0].encodedFeatures->size() == 1);
+
+    // The winding of the skipped layer still applies
+    Feature feature;
+    Arena arena;
+    tileData->layers[0].encodedFeatures->decodeProperties(0, feature, arena);
+    tileData->layers[0].encodedFeatures->decodeGeometry(0, feature, arena);
+    REQUIRE(feature.polygons.size() == 2);
+
+    REQUIRE(skipped.layers == 1);
+    REQUIRE(skipped.features == 3);
+    REQUIRE(skipped.bytes > 0);
+    REQUIRE(skipped.bytes < data.size());
+}
@@ -0,0 +1,201 @@
+#include "catch.hpp"
+
+#include "data/networkDataSource.h"
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tileID.h"
+#include "tile/tileTask.h"
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+// Platform that answers URL requests when respond() is called
+class DeferredPlatform : public MockPlatform {
+public:
+    struct Request {
+        Url url;
+        UrlCallback callback;
+        UrlPriorityCallback priority;
+        bool canceled = false;
+    };
+
+    UrlRequestHandle startUrlRequest(Url _url, UrlCallback _callback) override {
+        requests.push_back({ _url, _callback, nullptr });
+        return requests.size() - 1;
+    }
+
+    UrlRequestHandle startPrioritizedUrlRequest(Url _url, UrlCallback _callback,
+                                                UrlPriorityCallback _priority) override {
+        requests.push_back({ _url, _callback, _priority });
+        return requests.size() - 1;
+    }
+
+    void cancelUrlRequest(UrlRequestHandle _request) override {
+        requests[_request].canceled = true;
+    }
+
+    void respond(size_t _request, std::string _content) {
+        UrlResponse response;
+        response.content.assign(_content.begin(), _content.end());
+        requests[_request].callback(response);
+    }
+
+    std::vector<Request> requests;
+};
+
+static std::shared_ptr<BinaryTileTask> createTask(TileID _tileId) {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    return std::make_shared<BinaryTileTask>(_tileId, source, -1);
+}
+
+TEST_CASE("NetworkDataSources share requests for the same URL", "[NetworkDataSource]") {
+    auto platform = std::make_shared<DeferredPlatform>();
+
+    NetworkDataSource a(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+    NetworkDataSource b(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+
+    int loaded = 0;
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    auto taskA = createTask(TileID(1, 2, 3));
+    auto taskB = createTask(TileID(1, 2, 3));
+    auto other = createTask(TileID(2, 2, 3));
+
+    REQUIRE(a.loadTileData(taskA, cb));
+    REQUIRE(b.loadTileData(taskB, cb));
+    REQUIRE(b.loadTileData(other, cb));
+    REQUIRE(platform->requests.size() == 2);
+
+    platform->respond(0, "tile");
+    REQUIRE(loaded == 2);
+    REQUIRE(taskA->rawTileData == taskB->rawTileData);
+    REQUIRE(taskA->rawTileData->size() == 4);
+
+    // The next load of the URL starts a new request
+    auto again = createTask(TileID(1, 2, 3));
+    REQUIRE(a.loadTileData(again, cb));
+    REQUIRE(platform->requests.size() == 3);
+}
+
+TEST_CASE("NetworkDataSource cancels shared requests when no task waits", "[NetworkDataSource]") {
+    auto platform = std::make_shared<DeferredPlatform>();
+
+    NetworkDataSource a(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+    NetworkDataSource b(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+
+    int loaded = 0;
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    auto taskA = createTask(TileID(1, 2, 3));
+    auto taskB = createTask(TileID(1, 2, 3));
+
+    a.loadTileData(taskA, cb);
+    b.loadTileData(taskB, cb);
+    REQUIRE(platform->requests.size() == 1);
+
+    a.cancelLoadingTile(taskA->tileId());
+    REQUIRE(!platform->requests[0].canceled);
+
+    b.cancelLoadingTile(taskB->tileId());
+    REQUIRE(platform->requests[0].canceled);
+
+    // Responses of canceled requests are dropped
+    platform->respond(0, "tile");
+    REQUIRE(loaded == 0);
+}
+
+TEST_CASE("NetworkDataSource drops tasks canceled while loading", "[NetworkDataSource]") {
+    auto platform = std::make_shared<DeferredPlatform>();
+
+    NetworkDataSource source(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+
+    int loaded = 0;
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    // Canceled task whose tile is still loading
+    auto canceled = createTask(TileID(1, 2, 3));
+    source.loadTileData(canceled, cb);
+    canceled->cancel();
+
+    auto other = createTask(TileID(2, 2, 3));
+    source.loadTileData(other, cb);
+
+    platform->respond(0, "tile");
+    platform->respond(1, "tile");
+    REQUIRE(loaded == 1);
+    REQUIRE(!canceled->rawTileData);
+
+    // Canceled by TileManager: the request is aborted and the tile can be loaded again
+    auto task = createTask(TileID(1, 2, 3));
+    source.loadTileData(task, cb);
+    REQUIRE(platform->requests.size() == 3);
+
+    task->cancel();
+    source.cancelLoadingTile(task->tileId());
+    REQUIRE(platform->requests[2].canceled);
+
+    platform->respond(2, "tile");
+    REQUIRE(loaded == 1);
+
+    auto again = createTask(TileID(1, 2, 3));
+    source.loadTileData(again, cb);
+    REQUIRE(platform->requests.size() == 4);
+
+    platform->respond(3, "tile");
+    REQUIRE(loaded == 2);
+}
+
+TEST_CASE("NetworkDataSource requests without waiting tasks have the lowest priority", "[NetworkDataSource]") {
+    auto platform = std::make_shared<DeferredPlatform>();
+
+    NetworkDataSource source(platform, "http://tiles/{z}/{x}/{y}.mvt", {}, false);
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) {}};
+
+    auto task = createTask(TileID(1, 2, 3));
+    task->setPriority(4);
+    source.loadTileData(task, cb);
+
+    auto& priority = platform->requests[0].priority;
+    REQUIRE(!priority().background);
+    REQUIRE(priority().value == 4);
+
+    source.cancelLoadingTile(task->tileId());
+    REQUIRE(priority().background);
+    REQUIRE(priority().value == std::numeric_limits<double>::max());
+}
+
+TEST_CASE("NetworkDataSource destructor waits for running callbacks", "[NetworkDataSource]") {
+    auto platform = std::make_shared<DeferredPlatform>();
+
+    auto a = std::make_unique<NetworkDataSource>(platform, "http://tiles/{z}/{x}/{y}.mvt",
+                                                 std::vector<std::string>{}, false);
+    auto b = std::make_unique<NetworkDataSource>(platform, "http://tiles/{z}/{x}/{y}.mvt",
+                                                 std::vector<std::string>{}, false);
+
+    std::atomic<bool> inCallback{false};
+    std::atomic<bool> loadedB{false};
+
+    a->loadTileData(createTask(TileID(1, 2, 3)), {[&](std::shared_ptr<TileTask>) {
+        inCallback = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }});
+    b->loadTileData(createTask(TileID(1, 2, 3)), {[&](std::shared_ptr<TileTask>) {
+        loadedB = true;
+    }});
+
+    std::thread network([&]() { platform->respond(0, "tile"); });
+
+    while (!inCallback) { std::this_thread::yield(); }
+
+    // The response is fanned out to b after the callback of a returns
+    b.reset();
+    REQUIRE(loadedB);
+
+    network.join();
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/propertyKey.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("PropertyKeys with the same name are equal", "[PropertyKey]") {
+    std::string name = "kind";
+
+    PropertyKey a(name);
+    PropertyKey b("kind");
+    PropertyKey c("name");
+
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+    REQUIRE(&a.str() == &b.str());
+    REQUIRE(a == "kind");
+    REQUIRE(a == name);
+    REQUIRE(c.size() == 4);
+
+    REQUIRE(PropertyKey().empty());
+    REQUIRE(PropertyKey() == PropertyKey(""));
+}
+
+TEST_CASE("PropertyKeys are interned once across threads", "[PropertyKey]") {
+    std::vector<const std::string*> keys(4);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        threads.emplace_back([&, i]() {
+            for (int k = 0; k < 100; k++) { PropertyKey("key" + std::to_string(k)); }
+            keys[i] = &PropertyKey("key42").str();
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    for (auto* key : keys) { REQUIRE(key == keys[0]); }
+}
+
+TEST_CASE("Properties are found by PropertyKey and by name", "[PropertyKey]") {
+    Properties props;
+    props.set("name", "a");
+    props.set("height", 10);
+    props.set(std::string("kind"), "building");
+
+    PropertyKey kind("kind");
+    PropertyKey missing("missing");
+
+    REQUIRE(props.get(kind).get<std::string>() == "building");
+    REQUIRE(props.contains(kind));
+    REQUIRE(!props.contains(missing));
+    REQUIRE(props.getNumber("height") == 10);
+    REQUIRE(props.get("name").get<std::string>() == "a");
+
+    // Sorted by key length, then by name
+    REQUIRE(props.items()[0].key == "kind");
+    REQUIRE(props.items()[1].key == "name");
+    REQUIRE(props.items()[2].key == "height");
+}
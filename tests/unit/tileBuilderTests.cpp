@@ -0,0 +1,280 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "scene/sceneLoader.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileTask.h"
+#include "tile/tileWorker.h"
+
+#include "yaml-cpp/yaml.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace Tangram;
+
+const static std::string sceneString = R"END(
+layers:
+    buildings:
+        data: { source: test }
+        draw:
+            polygons:
+                order: 1
+                color: '#ccc'
+                interactive: true
+                outline:
+                    style: lines
+                    color: '#888'
+                    width: 1px
+    roads:
+        data: { source: test }
+        filter: { kind: major }
+        draw:
+            lines:
+                order: 2
+                color: '#f00'
+                width: [[10, 1px], [16, 4px]]
+        minor:
+            filter: { kind: minor }
+            draw:
+                lines:
+                    order: 3
+                    color: '#fff'
+                    width: 2px
+                    interactive: true
+)END";
+
+// Enough features for several batches of StyleBuilder commands
+#define NUM_FEATURES 600
+
+static TileData createTileData() {
+    TileData data;
+
+    data.layers.emplace_back("buildings");
+    data.layers.emplace_back("roads");
+
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        float x = (i % 30) / 30.f;
+        float y = (i / 30) / 20.f;
+
+        Feature building;
+        building.geometryType = GeometryType::polygons;
+        building.polygons.push_back({{ { x, y, 0 }, { x + .02f, y, 0 }, { x + .02f, y + .03f, 0 },
+                                       { x, y + .03f, 0 }, { x, y, 0 } }});
+        building.props.set("id", double(i));
+        data.layers[0].features.push_back(std::move(building));
+
+        Feature road;
+        road.geometryType = GeometryType::lines;
+        road.lines.push_back({ { x, y, 0 }, { x + .03f, y + .04f, 0 }, { x + .01f, y + .05f, 0 } });
+        road.props.set("kind", i % 3 ? "minor" : "major");
+        data.layers[1].features.push_back(std::move(road));
+    }
+
+    return data;
+}
+
+// Features of a layer that cancel the build when the feature at
+// 'cancelAt' is decoded
+struct CancelingFeatures : EncodedFeatures {
+    std::vector<Feature> features;
+    std::atomic<bool>& canceled;
+    size_t cancelAt;
+
+    CancelingFeatures(std::vector<Feature> _features, std::atomic<bool>& _canceled, size_t _cancelAt)
+        : features(std::move(_features)), canceled(_canceled), cancelAt(_cancelAt) {}
+
+    size_t size() const override { return features.size(); }
+
+    void decodeProperties(size_t _index, Feature& _feature, Arena& _arena) const override {
+        if (_index == cancelAt) { canceled = true; }
+        _feature.geometryType = features[_index].geometryType;
+        _feature.props = features[_index].props;
+    }
+
+    void decodeGeometry(size_t _index, Feature& _feature, Arena& _arena) const override {
+        _feature.polygons = features[_index].polygons;
+    }
+
+    size_t memoryUsage() const override { return 0; }
+};
+
+static std::shared_ptr<Scene> createScene() {
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    scene->config() = YAML::Load(sceneString);
+    SceneLoader::applyConfig(platform, scene);
+    return scene;
+}
+
+struct BuiltTile {
+    std::shared_ptr<Scene> scene;
+    std::shared_ptr<Tile> tile;
+};
+
+// Build the tile with a new Scene each time, so that the selection
+// colors in the vertices are assigned from the same start
+static BuiltTile buildTile(const TileData& _data, const TileSource& _source, int _threads) {
+    auto scene = createScene();
+
+    TileBuilder builder(scene);
+    builder.setConcurrency(_threads);
+
+    auto tile = builder.build(TileID(10, 12, 5), _data, _source);
+
+    return { scene, tile };
+}
+
+TEST_CASE("TileBuilder builds the same meshes with several threads", "[TileBuilder]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto data = createTileData();
+
+    auto serial = buildTile(data, *source, 1);
+    REQUIRE(serial.tile);
+    REQUIRE(serial.tile->getSelectionFeatures().size() > 0);
+
+    for (int threads : { 2, 4 }) {
+        auto parallel = buildTile(data, *source, threads);
+        REQUIRE(parallel.tile);
+
+        size_t selectionFeatures = parallel.tile->getSelectionFeatures().size();
+        REQUIRE(selectionFeatures == serial.tile->getSelectionFeatures().size());
+
+        size_t meshes = 0;
+        for (auto& style : serial.scene->styles()) {
+            auto& expected = serial.tile->getMesh(*style);
+            auto& mesh = parallel.tile->getMesh(*style);
+
+            REQUIRE(bool(mesh) == bool(expected));
+            if (!expected) { continue; }
+
+            auto* a = expected->compiledMesh();
+            auto* b = mesh->compiledMesh();
+            if (!a) { continue; }
+            meshes++;
+
+            size_t stride = style->vertexLayout()->getStride();
+
+            // Vertices and indices are identical and in the same order
+            REQUIRE(b->vertexCount() == a->vertexCount());
+            REQUIRE(b->indexCount() == a->indexCount());
+            REQUIRE(b->vertexOffsets() == a->vertexOffsets());
+
+            int vertices = std::memcmp(b->compiledVertices(), a->compiledVertices(),
+                                       a->vertexCount() * stride);
+            int indices = std::memcmp(b->compiledIndices(), a->compiledIndices(),
+                                      a->indexCount() * sizeof(GLushort));
+            REQUIRE(vertices == 0);
+            REQUIRE(indices == 0);
+        }
+
+        // Polygons and lines
+        REQUIRE(meshes == 2);
+    }
+}
+
+TEST_CASE("TileBuilder stops building a tile that is canceled", "[TileBuilder]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto expected = buildTile(createTileData(), *source, 1);
+
+    for (int threads : { 1, 4 }) {
+        auto scene = createScene();
+        TileBuilder builder(scene);
+        builder.setConcurrency(threads);
+
+        // Cancel while the 101st building is styled
+        std::atomic<bool> canceled{false};
+        auto data = createTileData();
+        auto& buildings = data.layers[0];
+        buildings.encodedFeatures = std::make_shared<CancelingFeatures>(std::move(buildings.features),
+                                                                        canceled, 100);
+        buildings.features.clear();
+
+        auto tile = builder.build(TileID(10, 12, 5), data, *source, &canceled);
+        REQUIRE(!tile);
+
+        // The remaining buildings and all roads were skipped
+        auto stats = builder.takeStats();
+        REQUIRE(stats.canceled == 1);
+        REQUIRE(stats.skippedFeatures == 2 * NUM_FEATURES - 101);
+
+        // The builder is reused for the next tile without the canceled geometry
+        canceled = false;
+        tile = builder.build(TileID(10, 12, 5), createTileData(), *source, &canceled);
+        REQUIRE(tile);
+        REQUIRE(builder.takeStats().canceled == 0);
+
+        for (auto& style : scene->styles()) {
+            auto& mesh = tile->getMesh(*style);
+            auto& expectedMesh = expected.tile->getMesh(*style);
+            REQUIRE(bool(mesh) == bool(expectedMesh));
+            if (!mesh || !mesh->compiledMesh()) { continue; }
+
+            size_t vertices = mesh->compiledMesh()->vertexCount();
+            REQUIRE(vertices == expectedMesh->compiledMesh()->vertexCount());
+        }
+    }
+}
+
+// Task that records the concurrency of the TileBuilder building it
+struct ConcurrencyTileTask : TileTask {
+
+    std::atomic<int> concurrency{0};
+
+    ConcurrencyTileTask(TileID& _tileId, std::shared_ptr<TileSource> _source)
+        : TileTask(_tileId, _source, -1) {}
+
+    void decode(const MapProjection& _projection) override {
+        m_tileData = std::make_shared<TileData>();
+    }
+
+    void build(TileBuilder& _tileBuilder) override {
+        concurrency = _tileBuilder.concurrency();
+    }
+};
+
+static int buildConcurrency(TileWorker& _worker, std::shared_ptr<TileSource> _source) {
+    TileID tileId(0, 0, 1);
+    auto task = std::make_shared<ConcurrencyTileTask>(tileId, _source);
+    _worker.enqueue(task);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (task->concurrency == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return task->concurrency;
+}
+
+TEST_CASE("TileWorker builds tiles with the builder concurrency", "[TileBuilder]") {
+    auto platform = std::make_shared<MockPlatform>();
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto scene = createScene();
+
+    TileWorker worker(platform, 1, 0);
+    worker.setScene(scene);
+
+    // Default used by Map::setTileBuilderThreads()
+    REQUIRE(worker.builderConcurrency() == 1);
+    REQUIRE(buildConcurrency(worker, source) == 1);
+
+    // Applies to the current TileBuilders without a new scene
+    worker.setBuilderConcurrency(3);
+    REQUIRE(buildConcurrency(worker, source) == 3);
+
+    worker.setBuilderConcurrency(0);
+    REQUIRE(worker.builderConcurrency() == 1);
+    REQUIRE(buildConcurrency(worker, source) == 1);
+
+    worker.stop();
+}
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include "tile/tileCachePolicy.h"
+
+using namespace Tangram;
+
+TEST_CASE("LRU policy evicts least recently added tiles", "[TileCache]") {
+    LRUTileCachePolicy policy;
+
+    for (int i = 0; i < 4; i++) {
+        policy.insert({ 0, TileID(i, 0, 10) }, 100, 1.f);
+    }
+
+    // Taken from cache and added again
+    policy.remove({ 0, TileID(0, 0, 10) });
+    policy.insert({ 0, TileID(0, 0, 10) }, 100, 1.f);
+
+    REQUIRE(policy.evict().second == TileID(1, 0, 10));
+    REQUIRE(policy.evict().second == TileID(2, 0, 10));
+    REQUIRE(policy.evict().second == TileID(3, 0, 10));
+    REQUIRE(policy.evict().second == TileID(0, 0, 10));
+}
+
+TEST_CASE("GreedyDual-Size policy keeps tiles that are costly to rebuild", "[TileCache]") {
+    GreedyDualSizeTileCachePolicy policy;
+    policy.setZoom(10);
+
+    policy.insert({ 0, TileID(0, 0, 10) }, 1000, 40.f);
+    policy.insert({ 0, TileID(1, 0, 10) }, 1000, 1.f);
+    policy.insert({ 0, TileID(2, 0, 10) }, 100, 1.f);
+
+    // Cheapest per byte first
+    REQUIRE(policy.evict().second == TileID(1, 0, 10));
+    REQUIRE(policy.evict().second == TileID(2, 0, 10));
+
+    // Tiles added after evictions are valued higher than their cost alone
+    policy.insert({ 0, TileID(3, 0, 10) }, 1000, 1.f);
+    policy.insert({ 0, TileID(4, 0, 10) }, 1000, 1.f);
+    REQUIRE(policy.evict().second == TileID(3, 0, 10));
+
+    policy.remove({ 0, TileID(4, 0, 10) });
+    REQUIRE(policy.evict().second == TileID(0, 0, 10));
+}
+
+TEST_CASE("GreedyDual-Size policy prefers tiles near the view zoom", "[TileCache]") {
+    GreedyDualSizeTileCachePolicy policy;
+    policy.setZoom(14);
+
+    policy.insert({ 0, TileID(0, 0, 10) }, 1000, 10.f);
+    policy.insert({ 0, TileID(0, 0, 14) }, 1000, 10.f);
+
+    REQUIRE(policy.evict().second == TileID(0, 0, 10));
+}
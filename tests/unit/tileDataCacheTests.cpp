@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "data/tileDataCache.h"
+#include "data/tileSource.h"
+
+#include <memory>
+
+using namespace Tangram;
+
+static std::shared_ptr<TileData> createTileData(int _numPoints) {
+    auto tileData = std::make_shared<TileData>();
+    tileData->layers.emplace_back("layer");
+
+    Feature feature;
+    feature.geometryType = GeometryType::points;
+    feature.points.resize(_numPoints);
+    feature.props.set("name", "feature");
+
+    tileData->layers.back().features.push_back(std::move(feature));
+    return tileData;
+}
+
+TEST_CASE("TileDataCache returns data for matching source, generation and tile", "[TileDataCache]") {
+    TileDataCache cache(1024 * 1024);
+
+    auto tileData = createTileData(10);
+    cache.put(1, 1, TileID(1, 2, 3), tileData);
+
+    REQUIRE(cache.get(1, 1, TileID(1, 2, 3)) == tileData);
+    REQUIRE(cache.getMemoryUsage() == TileDataCache::memoryUsage(*tileData));
+
+    // Styling zoom does not affect the parsed data
+    REQUIRE(cache.get(1, 1, TileID(1, 2, 3, 4, 0)) == tileData);
+
+    REQUIRE(cache.get(2, 1, TileID(1, 2, 3)) == nullptr);
+    REQUIRE(cache.get(1, 2, TileID(1, 2, 3)) == nullptr);
+    REQUIRE(cache.get(1, 1, TileID(1, 3, 3)) == nullptr);
+
+    cache.clear(2);
+    REQUIRE(cache.getEntryCount() == 1);
+
+    cache.clear(1);
+    REQUIRE(cache.getEntryCount() == 0);
+    REQUIRE(cache.getMemoryUsage() == 0);
+}
+
+TEST_CASE("TileDataCache evicts least recently used data", "[TileDataCache]") {
+    size_t usage = TileDataCache::memoryUsage(*createTileData(100));
+
+    TileDataCache cache(usage * 3);
+
+    for (int i = 0; i < 3; i++) {
+        cache.put(1, 1, TileID(i, 0, 10), createTileData(100));
+    }
+    REQUIRE(cache.getEntryCount() == 3);
+
+    // Touch the oldest entry
+    REQUIRE(cache.get(1, 1, TileID(0, 0, 10)) != nullptr);
+
+    cache.put(1, 1, TileID(3, 0, 10), createTileData(100));
+
+    REQUIRE(cache.getEntryCount() == 3);
+    REQUIRE(cache.getMemoryUsage() <= usage * 3);
+    REQUIRE(cache.get(1, 1, TileID(0, 0, 10)) != nullptr);
+    REQUIRE(cache.get(1, 1, TileID(1, 0, 10)) == nullptr);
+
+    cache.setCacheSize(usage);
+    REQUIRE(cache.getEntryCount() == 1);
+    REQUIRE(cache.get(1, 1, TileID(0, 0, 10)) != nullptr);
+}
+
+TEST_CASE("TileDataCache shares data of sources with the same configuration", "[TileDataCache]") {
+    auto cache = std::make_shared<TileDataCache>(1024 * 1024);
+    auto tileData = createTileData(10);
+
+    auto createSource = [&](uint64_t _configHash, std::vector<std::string> _collections) {
+        auto source = std::make_shared<TileSource>("test", nullptr);
+        if (_configHash) { source->setConfigHash(_configHash); }
+        source->addCollections(_collections);
+        source->setTileDataCache(cache);
+        return source;
+    };
+
+    auto source = createSource(42, { "roads", "water" });
+    cache->put(source->dataKey(), source->dataGeneration(), TileID(1, 2, 3), tileData);
+
+    // Data of a configured source remains cached for the sources of the next scene
+    source.reset();
+    REQUIRE(cache->getEntryCount() == 1);
+
+    // The order of collections does not matter
+    auto reloaded = createSource(42, { "water", "roads" });
+    REQUIRE(cache->get(reloaded->dataKey(), reloaded->dataGeneration(), TileID(1, 2, 3)) == tileData);
+
+    auto otherConfig = createSource(43, { "roads", "water" });
+    REQUIRE(otherConfig->dataKey() != reloaded->dataKey());
+
+    auto otherCollections = createSource(42, { "roads" });
+    REQUIRE(otherCollections->dataKey() != reloaded->dataKey());
+
+    // Sources without configuration are not shared
+    auto client = createSource(0, {});
+    auto otherClient = createSource(0, {});
+    REQUIRE(client->dataKey() != otherClient->dataKey());
+
+    cache->put(client->dataKey(), client->dataGeneration(), TileID(1, 2, 3), tileData);
+    REQUIRE(cache->getEntryCount() == 2);
+
+    client.reset();
+    REQUIRE(cache->getEntryCount() == 1);
+
+    // Clearing the data of a source clears the shared entries
+    reloaded->clearData();
+    REQUIRE(cache->getEntryCount() == 0);
+}
@@ -0,0 +1,289 @@
+#include "catch.hpp"
+
+#include "data/properties.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "style/polygonStyle.h"
+#include "tile/tile.h"
+#include "tile/tileDiskCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace Tangram;
+
+struct LabelMesh : public StyledMesh {
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) override { return false; }
+    size_t bufferSize() const override { return 0; }
+};
+
+// Directory in /tmp that is removed with its files
+struct TempDir {
+    std::string path;
+
+    TempDir() {
+        char name[] = "/tmp/tileDiskCacheTests-XXXXXX";
+        if (mkdtemp(name)) { path = name; }
+    }
+
+    ~TempDir() {
+        if (DIR* dir = opendir(path.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name != "." && name != "..") { std::remove((path + "/" + name).c_str()); }
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    }
+};
+
+static std::shared_ptr<Scene> createScene() {
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+
+    scene->styles().emplace_back(new PolygonStyle("polygons"));
+    scene->styles()[0]->setID(0);
+    scene->styles()[0]->build(*scene);
+
+    return scene;
+}
+
+static std::shared_ptr<Tile> createTile(const Scene& _scene, const TileSource& _source,
+                                        TileID _tileId, uint32_t _selection) {
+
+    auto& style = *_scene.styles()[0];
+    size_t stride = style.vertexLayout()->getStride();
+    size_t selectionOffset = style.vertexLayout()->getOffset("a_selection_color");
+
+    auto* vertices = new GLbyte[3 * stride];
+    for (size_t i = 0; i < 3 * stride; i++) { vertices[i] = GLbyte(i); }
+    for (size_t v = 0; v < 3; v++) {
+        std::memcpy(vertices + v * stride + selectionOffset, &_selection, sizeof(_selection));
+    }
+    auto* indices = new GLushort[3]{ 0, 1, 2 };
+
+    auto mesh = std::make_unique<RawMesh>(style.vertexLayout(), GL_TRIANGLES);
+    mesh->compile({{ 3, 3 }}, vertices, 3, indices, 3);
+
+    auto tile = std::make_shared<Tile>(_tileId, *_scene.mapProjection(), &_source);
+    tile->initGeometry(_scene.styles().size());
+    tile->setMesh(style, std::move(mesh));
+
+    auto props = std::make_shared<Properties>();
+    props->set("name", "building");
+    props->set("height", 10.0);
+
+    fastmap<uint32_t, std::shared_ptr<Properties>> selectionFeatures;
+    selectionFeatures[_selection] = props;
+    tile->setSelectionFeatures(selectionFeatures);
+
+    return tile;
+}
+
+static std::shared_ptr<TileTask> loadTile(TileDiskCache& _cache, std::shared_ptr<TileSource> _source,
+                                          TileID _tileId) {
+    auto task = _source->createTask(_tileId);
+
+    std::promise<void> done;
+    _cache.load(task, TileTaskCb{[&](std::shared_ptr<TileTask>) { done.set_value(); }});
+    done.get_future().wait();
+
+    return task;
+}
+
+TEST_CASE("TileDiskCache restores stored tiles", "[TileDiskCache]") {
+    TempDir dir;
+    REQUIRE(!dir.path.empty());
+
+    auto scene = createScene();
+    auto source = std::make_shared<TileSource>("source", nullptr);
+    auto& style = *scene->styles()[0];
+
+    TileDiskCache cache(dir.path);
+    cache.setScene(scene);
+
+    TileID tileId(1, 2, 3);
+    auto tile = createTile(*scene, *source, tileId, 7);
+    cache.put(*tile, *source, *scene);
+
+    auto task = loadTile(cache, source, tileId);
+    auto& restored = task->tile();
+
+    REQUIRE(restored);
+    REQUIRE(restored->getID() == tileId);
+    REQUIRE(cache.getStats().hits == 1);
+
+    // Selection features get new identifiers
+    REQUIRE(restored->getSelectionFeatures().size() == 1);
+    auto& feature = *restored->getSelectionFeatures().begin();
+    REQUIRE(feature.first != 7);
+    REQUIRE(feature.second->getString("name") == "building");
+    REQUIRE(feature.second->getNumber("height") == 10.0);
+
+    auto* original = tile->getMesh(style)->compiledMesh();
+    auto* mesh = restored->getMesh(style)->compiledMesh();
+
+    REQUIRE(mesh->vertexCount() == 3);
+    REQUIRE(mesh->indexCount() == 3);
+    REQUIRE(mesh->vertexOffsets() == original->vertexOffsets());
+    REQUIRE(std::memcmp(mesh->compiledIndices(), original->compiledIndices(), 3 * sizeof(GLushort)) == 0);
+
+    size_t stride = style.vertexLayout()->getStride();
+    size_t selectionOffset = style.vertexLayout()->getOffset("a_selection_color");
+
+    for (size_t i = 0; i < 3 * stride; i++) {
+        if (i % stride == selectionOffset) {
+            uint32_t selection;
+            std::memcpy(&selection, mesh->compiledVertices() + i, sizeof(selection));
+            REQUIRE(selection == feature.first);
+            i += sizeof(selection) - 1;
+        } else {
+            REQUIRE(mesh->compiledVertices()[i] == original->compiledVertices()[i]);
+        }
+    }
+
+    // Tiles that were not stored are not found
+    REQUIRE(!loadTile(cache, source, TileID(1, 3, 3))->tile());
+    REQUIRE(!loadTile(cache, std::make_shared<TileSource>("other", nullptr), tileId)->tile());
+    REQUIRE(cache.getStats().misses == 2);
+
+}
+
+TEST_CASE("TileDiskCache drops tiles of other scenes", "[TileDiskCache]") {
+    TempDir dir;
+    REQUIRE(!dir.path.empty());
+
+    auto scene = createScene();
+    auto source = std::make_shared<TileSource>("source", nullptr);
+
+    TileDiskCache cache(dir.path);
+    cache.setScene(scene);
+
+    TileID tileId(1, 2, 3);
+    cache.put(*createTile(*scene, *source, tileId, 1), *source, *scene);
+
+    REQUIRE(loadTile(cache, source, tileId)->tile());
+
+    // Scene with different content
+    auto otherScene = createScene();
+    otherScene->config()["global"] = "changed";
+    cache.setScene(otherScene);
+
+    REQUIRE(!loadTile(cache, source, tileId)->tile());
+
+    // Files of the previous scene were removed
+    cache.setScene(scene);
+    REQUIRE(!loadTile(cache, source, tileId)->tile());
+
+    // Tiles built with a previous scene are not stored
+    cache.put(*createTile(*otherScene, *source, tileId, 1), *source, *otherScene);
+    REQUIRE(!loadTile(cache, source, tileId)->tile());
+
+}
+
+TEST_CASE("TileDiskCache skips tiles with labels", "[TileDiskCache]") {
+    TempDir dir;
+    REQUIRE(!dir.path.empty());
+
+    auto scene = createScene();
+    scene->styles().emplace_back(new PolygonStyle("labels"));
+    scene->styles()[1]->setID(1);
+    scene->styles()[1]->build(*scene);
+
+    auto source = std::make_shared<TileSource>("source", nullptr);
+
+    TileDiskCache cache(dir.path);
+    cache.setScene(scene);
+
+    TileID tileId(1, 2, 3);
+    auto tile = createTile(*scene, *source, tileId, 1);
+    tile->setMesh(*scene->styles()[1], std::make_unique<LabelMesh>());
+
+    cache.put(*tile, *source, *scene);
+    REQUIRE(cache.getStats().skipped == 1);
+
+    REQUIRE(!loadTile(cache, source, tileId)->tile());
+    REQUIRE(cache.getStats().writes == 0);
+
+}
+
+TEST_CASE("TileDiskCache removes least recently used files", "[TileDiskCache]") {
+    TempDir dir;
+    REQUIRE(!dir.path.empty());
+
+    auto scene = createScene();
+    auto source = std::make_shared<TileSource>("source", nullptr);
+
+    // Size of one file
+    uint64_t fileSize = 0;
+    {
+        TileDiskCache cache(dir.path);
+        cache.setScene(scene);
+        cache.put(*createTile(*scene, *source, TileID(0, 0, 3), 1), *source, *scene);
+        REQUIRE(loadTile(cache, source, TileID(0, 0, 3))->tile());
+        fileSize = cache.getStats().size;
+        REQUIRE(fileSize > 0);
+
+        cache.clear();
+        REQUIRE(!loadTile(cache, source, TileID(0, 0, 3))->tile());
+    }
+
+    // Room for three and a half files
+    TileDiskCache cache(dir.path, fileSize * 7 / 2);
+    cache.setScene(scene);
+
+    for (int x = 0; x < 3; x++) {
+        cache.put(*createTile(*scene, *source, TileID(x, 0, 3), 1), *source, *scene);
+    }
+    // Restoring the first tile makes the second the least recently used
+    REQUIRE(loadTile(cache, source, TileID(0, 0, 3))->tile());
+
+    cache.put(*createTile(*scene, *source, TileID(3, 0, 3), 1), *source, *scene);
+
+    REQUIRE(!loadTile(cache, source, TileID(1, 0, 3))->tile());
+    REQUIRE(loadTile(cache, source, TileID(0, 0, 3))->tile());
+    REQUIRE(loadTile(cache, source, TileID(2, 0, 3))->tile());
+    REQUIRE(loadTile(cache, source, TileID(3, 0, 3))->tile());
+
+    auto stats = cache.getStats();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.size == 3 * fileSize);
+}
+
+TEST_CASE("TileDiskCache keeps files within the maximum size after a restart", "[TileDiskCache]") {
+    TempDir dir;
+    REQUIRE(!dir.path.empty());
+
+    auto scene = createScene();
+    auto source = std::make_shared<TileSource>("source", nullptr);
+
+    uint64_t fileSize = 0;
+    {
+        TileDiskCache cache(dir.path);
+        cache.setScene(scene);
+        for (int x = 0; x < 4; x++) {
+            cache.put(*createTile(*scene, *source, TileID(x, 0, 3), 1), *source, *scene);
+        }
+        REQUIRE(loadTile(cache, source, TileID(0, 0, 3))->tile());
+        fileSize = cache.getStats().size / 4;
+    }
+
+    // The files of the scene are counted when the cache is opened again
+    TileDiskCache cache(dir.path, fileSize * 5 / 2);
+    cache.setScene(scene);
+    REQUIRE(!loadTile(cache, source, TileID(4, 0, 3))->tile());
+
+    auto stats = cache.getStats();
+    REQUIRE(stats.evictions == 2);
+    REQUIRE(stats.size == 2 * fileSize);
+}
@@ -9,6 +9,7 @@
 #include "view/view.h"
 
 #include <deque>
+#include <set>
 
 using namespace Tangram;
 
@@ -111,7 +112,8 @@ public:
     using Base = TileManager;
     using Base::Base;
 
-    void updateTiles(const ViewState& _view, std::set<TileID> _visibleTiles) {
+    void updateTiles(const ViewState& _view, std::set<TileID> _visibleTiles,
+                     std::set<TileID> _prefetchTiles = {}) {
         // Mimic TileManager::updateTileSets(View& _view)
         m_tiles.clear();
         m_tilesInProgress = 0;
@@ -119,12 +121,16 @@ public:
 
         TileSet& tileSet = m_tileSets[0];
 
-        tileSet.visibleTiles = _visibleTiles;
+        tileSet.visibleTiles.assign(_visibleTiles.begin(), _visibleTiles.end());
+        tileSet.prefetchTiles.assign(_prefetchTiles.begin(), _prefetchTiles.end());
 
         TileManager::updateTileSet(tileSet, _view);
 
         loadTiles();
 
+        m_workers.updateTasks(m_updatedTasks);
+        m_updatedTasks.clear();
+
         // Make m_tiles an unique list of tiles for rendering sorted from
         // high to low zoom-levels.
         std::sort(m_tiles.begin(), m_tiles.end(), [](auto& a, auto& b){
@@ -302,3 +308,46 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,0));
 
 }
+
+TEST_CASE( "Prefetch Tile", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    TestTileManager tileManager(std::make_shared<MockPlatform>(), worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{0,0,2}};
+    std::set<TileID> prefetchTiles = {TileID{1,0,2}};
+    tileManager.updateTiles(viewState, visibleTiles, prefetchTiles);
+
+    REQUIRE(source->tileTaskCount == 2);
+    REQUIRE(tileManager.getPrefetchStats().requests == 1);
+    REQUIRE(tileManager.hasLoadingTiles() == true);
+
+    worker.processTask();
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles, prefetchTiles);
+
+    // Prefetched tile is loaded but not rendered
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,2));
+
+    // Prefetched tile becomes visible without loading
+    std::set<TileID> visibleTiles2 = {TileID{1,0,2}};
+    std::set<TileID> prefetchTiles2 = {TileID{2,0,2}};
+    tileManager.updateTiles(viewState, visibleTiles2, prefetchTiles2);
+
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(1,0,2));
+    REQUIRE(tileManager.getPrefetchStats().hits == 1);
+    REQUIRE(source->tileTaskCount == 3);
+
+    // Mispredicted tile is canceled
+    std::set<TileID> prefetchTiles3 = {TileID{1,1,2}};
+    tileManager.updateTiles(viewState, visibleTiles2, prefetchTiles3);
+
+    REQUIRE(tileManager.getPrefetchStats().misses == 1);
+    REQUIRE(tileManager.getPrefetchStats().requests == 3);
+    REQUIRE(source->tileTaskCount == 4);
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+#include "tile/tileTaskHeap.h"
+
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static std::vector<std::shared_ptr<TileTask>> createTasks(std::shared_ptr<TileSource> _source, int _count) {
+    std::vector<std::shared_ptr<TileTask>> tasks;
+    for (int i = 0; i < _count; i++) {
+        TileID tileId(i, 0, 10);
+        tasks.push_back(std::make_shared<TileTask>(tileId, _source, -1));
+        tasks.back()->setPriority((i * 37) % _count);
+    }
+    return tasks;
+}
+
+TEST_CASE("TileTaskHeap pops tasks in priority order", "[TileTaskHeap]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto tasks = createTasks(source, 100);
+
+    TileTaskHeap heap;
+    for (auto& task : tasks) { heap.push(task); }
+
+    REQUIRE(heap.size() == 100);
+
+    float last = -1;
+    while (!heap.empty()) {
+        auto task = heap.pop();
+        REQUIRE(task->getPriority() >= last);
+        last = task->getPriority();
+    }
+}
+
+TEST_CASE("TileTaskHeap prefers non-proxy tasks", "[TileTaskHeap]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto tasks = createTasks(source, 10);
+
+    tasks[0]->setPriority(0);
+    tasks[0]->setProxyState(true);
+
+    TileTaskHeap heap;
+    for (auto& task : tasks) { heap.push(task); }
+
+    for (int i = 0; i < 9; i++) {
+        REQUIRE(heap.pop()->isProxy() == false);
+    }
+    REQUIRE(heap.pop() == tasks[0]);
+}
+
+TEST_CASE("TileTaskHeap updates and removes queued tasks", "[TileTaskHeap]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto tasks = createTasks(source, 50);
+
+    TileTaskHeap heap;
+    for (auto& task : tasks) { heap.push(task); }
+
+    // Priorities are only applied on update
+    tasks[10]->setPriority(-1);
+    REQUIRE(heap.pop() != tasks[10]);
+
+    heap.update(*tasks[10]);
+    REQUIRE(heap.pop() == tasks[10]);
+
+    // Removing a popped task is a no-op
+    REQUIRE(heap.remove(*tasks[10]) == false);
+
+    REQUIRE(heap.remove(*tasks[20]) == true);
+    REQUIRE(heap.size() == 47);
+
+    tasks[30]->cancel();
+    for (auto& task : tasks) { task->setPriority(-task->getPriority()); }
+    heap.refresh();
+
+    REQUIRE(heap.size() == 46);
+
+    float last = -100;
+    while (!heap.empty()) {
+        auto task = heap.pop();
+        REQUIRE(task != tasks[20]);
+        REQUIRE(task != tasks[30]);
+        REQUIRE(task->getPriority() >= last);
+        last = task->getPriority();
+    }
+}
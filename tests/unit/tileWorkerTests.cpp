@@ -0,0 +1,232 @@
+#include "catch.hpp"
+
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "tile/tileTask.h"
+#include "tile/tileWorker.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace Tangram;
+
+struct CountingTileTask : TileTask {
+
+    std::atomic<int>& processed;
+
+    CountingTileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, std::atomic<int>& _processed)
+        : TileTask(_tileId, _source, -1), processed(_processed) {}
+
+    void decode(const MapProjection& _projection) override {
+        m_tileData = std::make_shared<TileData>();
+    }
+
+    void build(TileBuilder& _tileBuilder) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        processed++;
+    }
+};
+
+// Task that blocks in decode() or build() until it is canceled
+struct BlockingTileTask : TileTask {
+
+    enum Stage { decoding, building };
+
+    Stage blockIn;
+    std::atomic<bool> blocked{false};
+    std::atomic<int> builds{0};
+
+    BlockingTileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, Stage _blockIn)
+        : TileTask(_tileId, _source, -1), blockIn(_blockIn) {}
+
+    void block(Stage _stage) {
+        if (blockIn != _stage) { return; }
+        blocked = true;
+        while (!isCanceled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void decode(const MapProjection& _projection) override {
+        block(decoding);
+        m_tileData = std::make_shared<TileData>();
+    }
+
+    void build(TileBuilder& _tileBuilder) override {
+        builds++;
+        block(building);
+    }
+};
+
+static bool waitFor(std::atomic<bool>& _flag) {
+    for (int i = 0; i < 1000 && !_flag; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return _flag;
+}
+
+static bool waitFor(std::atomic<int>& _counter, int _count) {
+    for (int i = 0; i < 1000 && _counter < _count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return _counter == _count;
+}
+
+TEST_CASE("TileWorker processes all enqueued tasks", "[TileWorker]") {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    for (int numWorkers : { 1, 2, 4, 8 }) {
+        TileWorker worker(platform, numWorkers);
+        worker.setScene(scene);
+
+        std::atomic<int> processed{0};
+
+        for (int i = 0; i < 200; i++) {
+            TileID tileId(i, 0, 10);
+            auto task = std::make_shared<CountingTileTask>(tileId, source, processed);
+            task->setPriority(200 - i);
+            worker.enqueue(task);
+        }
+
+        REQUIRE(waitFor(processed, 200));
+
+        worker.stop();
+    }
+}
+
+TEST_CASE("TileWorker skips canceled tasks", "[TileWorker]") {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    // No TileBuilder is set yet: tasks stay queued
+    TileWorker worker(platform, 4);
+
+    std::atomic<int> processed{0};
+
+    for (int i = 0; i < 100; i++) {
+        TileID tileId(i, 0, 10);
+        auto task = std::make_shared<CountingTileTask>(tileId, source, processed);
+        if (i % 2) { task->cancel(); }
+        worker.enqueue(task);
+    }
+
+    worker.setScene(scene);
+
+    REQUIRE(waitFor(processed, 50));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(processed == 50);
+
+    worker.stop();
+}
+
+TEST_CASE("Pipelined TileWorker decodes and builds all enqueued tasks", "[TileWorker]") {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    for (int numDecoders : { 1, 2, 4 }) {
+        TileWorker worker(platform, 2, numDecoders);
+        worker.setScene(scene);
+
+        std::atomic<int> processed{0};
+
+        for (int i = 0; i < 200; i++) {
+            TileID tileId(i, 0, 10);
+            auto task = std::make_shared<CountingTileTask>(tileId, source, processed);
+            if (i % 4 == 0) { task->cancel(); }
+            worker.enqueue(task);
+        }
+
+        REQUIRE(waitFor(processed, 150));
+
+        worker.stop();
+    }
+}
+
+TEST_CASE("TileWorker keeps queued tasks when the number of decoders changes", "[TileWorker]") {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    std::atomic<int> processed{0};
+
+    auto enqueue = [&](TileWorker& _worker, int _begin, int _end) {
+        for (int i = _begin; i < _end; i++) {
+            TileID tileId(i, 0, 10);
+            _worker.enqueue(std::make_shared<CountingTileTask>(tileId, source, processed));
+        }
+    };
+
+    // No TileBuilder is set yet: tasks stay queued
+    TileWorker worker(platform, 2, 1);
+
+    enqueue(worker, 0, 50);
+    worker.setDecoders(0);
+    REQUIRE(worker.decoders() == 0);
+
+    enqueue(worker, 50, 100);
+    worker.setDecoders(2);
+    REQUIRE(worker.decoders() == 2);
+
+    enqueue(worker, 100, 150);
+    worker.setScene(scene);
+
+    REQUIRE(waitFor(processed, 150));
+
+    // Change the decoders while tasks are processed
+    processed = 0;
+    enqueue(worker, 0, 200);
+    worker.setDecoders(0);
+    worker.setDecoders(3);
+
+    REQUIRE(waitFor(processed, 200));
+
+    worker.stop();
+}
+
+TEST_CASE("TileWorker frees the worker of a task canceled while it is processed", "[TileWorker]") {
+
+    auto platform = std::make_shared<MockPlatform>();
+    auto scene = std::make_shared<Scene>(platform, Url());
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    for (auto stage : { BlockingTileTask::decoding, BlockingTileTask::building }) {
+        for (int numDecoders : { 0, 1 }) {
+            // A single thread builds the tasks
+            TileWorker worker(platform, 1, numDecoders);
+            worker.setScene(scene);
+
+            TileID tileId(0, 0, 10);
+            auto task = std::make_shared<BlockingTileTask>(tileId, source, stage);
+            worker.enqueue(task);
+
+            REQUIRE(waitFor(task->blocked));
+            task->cancel();
+
+            // The next task is processed once the canceled one stopped
+            std::atomic<int> processed{0};
+            TileID nextId(1, 0, 10);
+            worker.enqueue(std::make_shared<CountingTileTask>(nextId, source, processed));
+
+            REQUIRE(waitFor(processed, 1));
+
+            // Tasks canceled while decoding are not built
+            int builds = stage == BlockingTileTask::building ? 1 : 0;
+            REQUIRE(task->builds == builds);
+
+            worker.stop();
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#include "catch.hpp"
+
+#include "mockHttpServer.h"
+#include "urlClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace Tangram;
+
+// Collects the responses of UrlClient requests
+struct Responses {
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t count = 0;
+    size_t errors = 0;
+    size_t bytes = 0;
+    // Ids of the completed requests
+    std::vector<int> order;
+
+    UrlCallback callback(int _id = -1) {
+        return [this, _id](UrlResponse _response) {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+            if (_response.error) { errors++; }
+            bytes += _response.content.size();
+            order.push_back(_id);
+            done.notify_all();
+        };
+    }
+
+    bool waitFor(size_t _count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return done.wait_for(lock, std::chrono::seconds(10), [&]{ return count >= _count; });
+    }
+};
+
+TEST_CASE("UrlClient completes requests on reused connections", "[UrlClient]") {
+    MockHttpServer server({ 20, 1000 });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 8;
+    options.maxConnectionsPerHost = 4;
+    UrlClient client(options);
+
+    Responses responses;
+    for (int i = 0; i < 64; i++) {
+        client.addRequest(server.url() + "/tile/" + std::to_string(i), responses.callback());
+    }
+    client.addRequest(server.url() + "/missing", responses.callback());
+
+    REQUIRE(responses.waitFor(65));
+    REQUIRE(responses.errors == 1);
+    REQUIRE(responses.bytes == 64 * 1000);
+
+    // Requests to one host share at most maxConnectionsPerHost connections
+    REQUIRE(server.connections() <= 4);
+}
+
+TEST_CASE("UrlClient runs the callbacks of canceled requests", "[UrlClient]") {
+    MockHttpServer server({ 200, 1000 });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 2;
+    UrlClient client(options);
+
+    Responses responses;
+    std::vector<UrlRequestHandle> handles;
+    for (int i = 0; i < 8; i++) {
+        handles.push_back(client.addRequest(server.url() + "/tile/" + std::to_string(i), responses.callback()));
+    }
+
+    // Cancel active and pending requests
+    for (auto handle : handles) {
+        client.cancelRequest(handle);
+    }
+
+    REQUIRE(responses.waitFor(8));
+    REQUIRE(responses.errors == 8);
+    REQUIRE(server.requests() <= 2);
+}
+
+static UrlPriorityCallback priority(double _value, bool _background = false) {
+    return [=]() { return UrlRequestPriority{ _background, _value }; };
+}
+
+TEST_CASE("UrlClient starts requests by priority", "[UrlClient]") {
+    MockHttpServer server({ 20, 1000 });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 1;
+    UrlClient client(options);
+
+    Responses responses;
+    // Keeps the transfer busy while the others are queued
+    client.addRequest(server.url() + "/first", responses.callback(0), priority(0));
+
+    client.addRequest(server.url() + "/a", responses.callback(5), priority(5));
+    client.addRequest(server.url() + "/b", responses.callback(3), priority(3));
+    client.addRequest(server.url() + "/c", responses.callback(9), priority(1, true));
+    client.addRequest(server.url() + "/d", responses.callback(1), priority(1));
+    client.addRequest(server.url() + "/e", responses.callback(4));
+
+    REQUIRE(responses.waitFor(6));
+    REQUIRE(responses.order == std::vector<int>({ 0, 4, 1, 3, 5, 9 }));
+}
+
+TEST_CASE("UrlClient orders requests by their current priority", "[UrlClient]") {
+    MockHttpServer server({ 50, 1000 });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 1;
+    UrlClient client(options);
+
+    std::atomic<int> values[3];
+    for (int i = 0; i < 3; i++) { values[i] = i; }
+
+    Responses responses;
+    client.addRequest(server.url() + "/first", responses.callback(-1), priority(0));
+    for (int i = 0; i < 3; i++) {
+        client.addRequest(server.url() + "/" + std::to_string(i), responses.callback(i), [&values, i]() {
+            return UrlRequestPriority{ false, double(values[i]) };
+        });
+    }
+
+    // Reverse the order while the requests wait
+    for (int i = 0; i < 3; i++) { values[i] = 10 - i; }
+
+    REQUIRE(responses.waitFor(4));
+    REQUIRE(responses.order == std::vector<int>({ -1, 2, 1, 0 }));
+}
+
+TEST_CASE("UrlClient preempts background transfers for foreground requests", "[UrlClient]") {
+    // Transfers take half a second
+    MockHttpServer server({ 0, 10000, 20000 });
+
+    UrlClient::Options options;
+    options.maxActiveTasks = 2;
+    UrlClient client(options);
+
+    Responses responses;
+    client.addRequest(server.url() + "/background/1", responses.callback(1), priority(1, true));
+    client.addRequest(server.url() + "/background/2", responses.callback(2), priority(2, true));
+
+    // Both background transfers are running
+    REQUIRE(server.waitForActiveRequests(2));
+    client.addRequest(server.url() + "/foreground", responses.callback(0), priority(100));
+
+    REQUIRE(responses.waitFor(3));
+    REQUIRE(responses.errors == 0);
+    REQUIRE(responses.bytes == 3 * 10000);
+
+    // The lowest priority background transfer was aborted and started again
+    REQUIRE(responses.order == std::vector<int>({ 1, 0, 2 }));
+    REQUIRE(server.requests() == 4);
+}
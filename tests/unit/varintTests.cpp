@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "util/varint.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace Tangram;
+
+static std::vector<char> encode(const std::vector<uint32_t>& _values) {
+    std::vector<char> bytes;
+    for (uint32_t value : _values) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+    return bytes;
+}
+
+static std::vector<uint32_t> decode(const std::vector<char>& _bytes) {
+    std::vector<uint32_t> values(_bytes.size() + VARINT_DECODE_PADDING);
+    size_t count = decodeVarints(_bytes.data(), _bytes.data() + _bytes.size(), values.data());
+    values.resize(count);
+    return values;
+}
+
+TEST_CASE("Decode runs of single byte varints", "[Varint]") {
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 100; i++) { values.push_back(i); }
+
+    REQUIRE(decode(encode(values)) == values);
+}
+
+TEST_CASE("Decode mixed length varints", "[Varint]") {
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 200; i++) {
+        // Every fifth value needs more than one byte
+        values.push_back(i % 5 == 0 ? i * 100003 : i % 128);
+    }
+    values.push_back(UINT32_MAX);
+
+    REQUIRE(decode(encode(values)) == values);
+}
+
+TEST_CASE("Unterminated varint throws", "[Varint]") {
+    std::vector<uint32_t> values(20, 1);
+    auto bytes = encode(values);
+    bytes.push_back(static_cast<char>(0x81));
+
+    REQUIRE_THROWS_AS(decode(bytes), std::runtime_error);
+}
+
+TEST_CASE("Zigzag decoding", "[Varint]") {
+    REQUIRE(zigzagDecode(0) == 0);
+    REQUIRE(zigzagDecode(1) == -1);
+    REQUIRE(zigzagDecode(2) == 1);
+    REQUIRE(zigzagDecode(3) == -2);
+    REQUIRE(zigzagDecode(UINT32_MAX) == INT32_MIN);
+}